@@ -7,19 +7,32 @@
 #include "StateBuffers.h"
 #include "SimulatorConfig.h"
 #include "EngineConfig.h"
+#include "KernelProfile.h"
 
 class AbstractBackend {
 public:
     StateBuffers * state;
     RawTables tabs;
-    AbstractBackend():state(nullptr){}
-    virtual ~AbstractBackend() {};
+    KernelProfile * kernel_profile; // if the work items are being profiled
+
+    // Which part of the work items to run: interior items need nothing from other nodes,
+    // boundary items have to wait until remote values and spikes have been received.
+    enum WorkItemSet{
+        ALL_WORK_ITEMS,
+        INTERIOR_WORK_ITEMS,
+        BOUNDARY_WORK_ITEMS
+    };
+
+    AbstractBackend():state(nullptr),kernel_profile(nullptr){}
+    virtual ~AbstractBackend() { delete kernel_profile; };
     virtual void init() = 0;
-    virtual void execute_work_items(EngineConfig & engine_config, SimulatorConfig & config, int step, double time) = 0;
+    virtual void execute_work_items(EngineConfig & engine_config, SimulatorConfig & config, int step, double time, WorkItemSet which_items) = 0;
     virtual void populate_print_buffer() = 0;
     virtual void synchronize() const = 0;
     virtual void swap_buffers() = 0;
     virtual void dump_iteration(SimulatorConfig & config, bool initializing, double time, long long step) = 0;
+    // pick up constant tables that were moved after init (e.g. to memory shared between MPI ranks)
+    virtual void rebind_const_tables() {}
 
     virtual float     * print_state_now()               const = 0;
     virtual Table_F32 * print_tables_stateNow_f32()     const = 0;
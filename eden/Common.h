@@ -113,6 +113,70 @@ int64_t getCurrentHeapBytes();
 #endif
 
 
+// Hardware performance counters of the process' OpenMP threads; on Linux, through perf_event_open.
+// A counter only counts the thread that opened it, so each OpenMP thread opens its own group of counters,
+// and the totals are summed over the threads. This relies on the OpenMP runtime reusing the same threads
+// for later parallel regions, as the common runtimes do; work on other threads is not counted.
+// They are often unavailable (on other platforms, in containers, or with a strict perf_event_paranoid setting);
+// then Open() fails with the reason in error, and the values stay unknown.
+struct HardwareCounters{
+	enum Counter{
+		CYCLES,
+		INSTRUCTIONS,
+		LLC_MISSES,
+		BRANCH_MISSES,
+		COUNTER_COUNT
+	};
+	static const char *Name(int counter);
+
+	struct Values{
+		int64_t counts[COUNTER_COUNT]; // -1 for unknown
+		Values(){ for( int i = 0; i < COUNTER_COUNT; i++ ) counts[i] = -1; }
+		bool any() const {
+			for( int i = 0; i < COUNTER_COUNT; i++ ) if( counts[i] >= 0 ) return true;
+			return false;
+		}
+		// for counts taken before and after something
+		Values operator-(const Values &before) const {
+			Values ret;
+			for( int i = 0; i < COUNTER_COUNT; i++ ){
+				if( counts[i] >= 0 && before.counts[i] >= 0 ) ret.counts[i] = counts[i] - before.counts[i];
+			}
+			return ret;
+		}
+		Values &operator+=(const Values &more){
+			for( int i = 0; i < COUNTER_COUNT; i++ ){
+				if( more.counts[i] >= 0 ) counts[i] = std::max( counts[i], (int64_t) 0 ) + more.counts[i];
+			}
+			return *this;
+		}
+	};
+
+	// the counters of one thread, opened as a group
+	struct Group{
+		int fds[COUNTER_COUNT]; // -1 for not open
+		int leader_fd;
+		Group(){
+			for( int i = 0; i < COUNTER_COUNT; i++ ) fds[i] = -1;
+			leader_fd = -1;
+		}
+	};
+	std::vector<Group> thread_groups; // for each OpenMP thread, by thread number
+	std::string error; // why some or all counters could not be opened
+
+	HardwareCounters(){}
+	~HardwareCounters(){ Close(); }
+	// true if at least one counter could be opened on every thread; they start counting right away
+	bool Open();
+	bool IsOpen() const { return !thread_groups.empty(); }
+	// running totals since Open(), over all threads
+	bool Read(Values &values) const;
+	// running totals since Open(), for the calling thread only
+	bool ReadThread(Values &values) const;
+	void Close();
+};
+
+
 struct RunMetaData{
 	double config_time_sec;
 	double init_time_sec;
@@ -121,6 +185,7 @@ struct RunMetaData{
 	
 	int64_t peak_resident_memory_bytes; //0 for unknown
 	int64_t end_resident_memory_bytes; //0 for unknown
+	HardwareCounters::Values run_counters; // over the simulation loop, if measured
     RunMetaData(){
 		config_time_sec = NAN;
 		init_time_sec = NAN;
@@ -141,9 +206,43 @@ struct RunMetaData{
         long long memHeap = getCurrentHeapBytes();
         printf("Peak: %lld Now: %lld Heap: %lld\n", memResidentPeak, memResidentEnd, memHeap);
 #endif
+        if( run_counters.any() ){
+            for( int i = 0; i < HardwareCounters::COUNTER_COUNT; i++ ){
+                if( run_counters.counts[i] >= 0 ) printf("%s: %lld ", HardwareCounters::Name(i), (long long) run_counters.counts[i]);
+            }
+            const int64_t cycles = run_counters.counts[HardwareCounters::CYCLES];
+            const int64_t instructions = run_counters.counts[HardwareCounters::INSTRUCTIONS];
+            if( cycles > 0 && instructions >= 0 ) printf("IPC: %.3lf", (double) instructions / cycles);
+            printf("\n");
+        }
     }
 };
 
+// Time and memory taken by each phase of the startup, in the order they happen; for the startup report.
+// Phases are either timed separately and added, or timed as laps, from the end of the previous phase.
+struct StartupPhases{
+	struct Phase{
+		std::string name;
+		int depth; // sub-phases are listed before the phase that contains them, with greater depth
+		double seconds;
+		int64_t resident_bytes; // at the end of the phase, 0 for unknown
+		int64_t peak_resident_bytes_so_far; // of the process, from its start to the end of the phase (not of the phase alone), 0 for unknown
+	};
+	std::vector<Phase> phases;
+	timeval last_end;
+
+	StartupPhases(){ gettimeofday(&last_end, NULL); }
+
+	void Add(const std::string &name, double seconds, int depth = 0);
+	void Lap(const std::string &name);
+	// start timing laps from now on, without recording a phase
+	void Restart(){ gettimeofday(&last_end, NULL); }
+
+	// as JSON, with the totals in metadata appended
+	bool WriteReport(const char *filename, const RunMetaData &metadata, int mpi_rank, int mpi_ranks) const;
+};
+extern StartupPhases startup_phases;
+
 // A very fast and chaotic RNG
 // straight from Wikipedia
 class XorShiftMul{
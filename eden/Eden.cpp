@@ -52,13 +52,17 @@ int main(int argc, char **argv){
     AbstractBackend *backend = nullptr;             // Class to handle all backend calls
     TrajectoryLogger *trajectory_logger = nullptr;  // Class to handle all output generation
     MpiBuffers *mpi_buffers = nullptr;              // Class to handle all MPI communication
+    HardwareCounters hardware_counters;             // Hardware performance counters, if requested and available
 
 //-----> Check the command line input with options
     log(LOG_MES) << "Parse command lines and Build model"<< LOG_ENDL;
-    parse_command_line_args(argc, argv, engine_config, config, model, metadata.config_time_sec);
+    parse_command_line_args(argc, argv, engine_config, config, metadata.config_time_sec);
 
 //-----> Find and check the specific engine_config
     setup_mpi(argc, argv, &engine_config);         //check if everything works fine, sorry if you use legacy cmd line args
+
+//-----> Read the model, now that each MPI node can keep just its own part of the network
+    read_model(engine_config, config, model, metadata.config_time_sec);
     if (engine_config.backend == backend_kind_gpu) {
         setup_gpu(engine_config);                   //same for gpu
     }
@@ -89,10 +93,26 @@ int main(int argc, char **argv){
             log(LOG_ERR) << "NeuroML model could not be created\n" << LOG_ENDL;
             exit(1);
         }
+        // the parsed model (with all the connections of the network) is not needed once it is laid out in the tables
+        model = Model();
         trajectory_logger = new TrajectoryLogger(engine_config); //To log results
+        startup_phases.Lap("release parsed model");
+
+        if(!config.dump_tables_filename.empty()){
+            // before the backend takes over the tables; each MPI node saves its own part of the model
+            std::string tables_filename = config.dump_tables_filename;
+            if(engine_config.use_mpi && engine_config.my_mpi.rank > 0) tables_filename += ".rank_" + std::to_string(engine_config.my_mpi.rank);
+            FILE *fout = fopen(tables_filename.c_str(), "wb");
+            if(!fout || !backend->tabs.write_to_file(fout, engine_config.dt)){
+                log(LOG_ERR) << "Could not write tables to " << tables_filename << LOG_ENDL;
+                exit(1);
+            }
+            fclose(fout);
+        }
 
         log(LOG_INFO) << "Allocating state buffers..." << LOG_ENDL;
         backend->init();
+        startup_phases.Lap("backend: allocate state");
 
         //just some timer functions to time this meta data --> encorperate this into meta data class
         metadata.init_time_sec = init_timer.delta();
@@ -101,17 +121,40 @@ int main(int argc, char **argv){
         if(config.dump_raw_layout) backend->state->dump_raw_layout(backend->tabs);
         if(config.dump_array_locations) backend->state->dump_array_locations(backend->tabs);
 
+        if(config.perf_counters){
+            if(!hardware_counters.Open()){
+                log(LOG_WARN) << "Hardware counters are not available: " << hardware_counters.error << LOG_ENDL;
+            } else if(!hardware_counters.error.empty()){
+                log(LOG_WARN) << "Some hardware counters are not available: " << hardware_counters.error << LOG_ENDL;
+            }
+        }
+        if(config.profile_kernels){
+            if (engine_config.backend == backend_kind_cpu) {
+                backend->kernel_profile = new KernelProfile(backend->tabs, *backend->state, engine_config);
+                if(hardware_counters.IsOpen()) backend->kernel_profile->counters = &hardware_counters;
+            } else {
+                log(LOG_WARN) << "Kernel profiling is only available on the CPU backend" << LOG_ENDL;
+            }
+        }
+
         //Initialize MPI
          mpi_buffers = new MpiBuffers(engine_config);
+        if (engine_config.backend == backend_kind_cpu) {
+            mpi_buffers->share_const_tables(engine_config, backend); // empty call if not enabled, or no mpi compilation
+        }
+        startup_phases.Lap("backend: communication buffers");
     }
 
 //----> Simulations loop
     log(LOG_MES) << "Starting simulation loop..."<< LOG_ENDL;
     {
         Timer run_timer;
+        HardwareCounters::Values counters_before_run;
+        hardware_counters.Read(counters_before_run);
         double time = engine_config.t_initial;
         // need multiple initialization steps, to make sure the dependency chains of all state variables are resolved
         for (long long step = -3; time <= engine_config.t_final; step++) {
+            if(backend->kernel_profile) backend->kernel_profile->steps++;
 
 //            Start and check the output logger
             if(step > 1){
@@ -123,10 +166,16 @@ int main(int argc, char **argv){
             }
 
             //init mpi communication --> empty call if no mpi compilation
-            mpi_buffers->init_communicate(engine_config, backend, config); // need to copy between backend & state when using mpi
+            mpi_buffers->init_communicate(engine_config, backend, config); // need to copy between backend & state when using mpi, only posts the messages
+
+            //execute the work items that need nothing from other nodes, while messages are in flight
+            backend->execute_work_items(engine_config, config, (int)step, time, AbstractBackend::INTERIOR_WORK_ITEMS);
 
-            //execute the actual work items
-            backend->execute_work_items(engine_config, config, (int)step, time);
+            //wait for the remote values and spikes to be delivered --> empty call if no mpi compilation
+            mpi_buffers->complete_communicate(engine_config, backend, config);
+
+            //and execute the rest of the work items
+            backend->execute_work_items(engine_config, config, (int)step, time, AbstractBackend::BOUNDARY_WORK_ITEMS);
 
             //dump to CMD CLI
             backend->dump_iteration(config, (step <= 0), time, step);
@@ -154,6 +203,8 @@ int main(int argc, char **argv){
                 /* needed on mpi: */sn_f32);
 
         metadata.run_time_sec = run_timer.delta();
+        HardwareCounters::Values counters_after_run;
+        if(hardware_counters.Read(counters_after_run)) metadata.run_counters = counters_after_run - counters_before_run;
     }
 
 
@@ -161,6 +212,19 @@ int main(int argc, char **argv){
 
 //----> Print meta overeview
     metadata.print();
+    if( backend->kernel_profile ){
+        int rank = engine_config.use_mpi ? engine_config.my_mpi.rank : 0;
+        int ranks = engine_config.use_mpi ? engine_config.my_mpi.world_size : 1;
+        backend->kernel_profile->Report( stdout, metadata.run_time_sec, rank, ranks );
+    }
+    if( !config.startup_report_filename.empty() ){
+        // each MPI node reports on its own startup, to a separate file
+        int rank = engine_config.use_mpi ? engine_config.my_mpi.rank : 0;
+        int ranks = engine_config.use_mpi ? engine_config.my_mpi.world_size : 1;
+        std::string report_filename = config.startup_report_filename;
+        if( rank > 0 ) report_filename += ".rank_" + std::to_string(rank);
+        startup_phases.WriteReport( report_filename.c_str(), metadata, rank, ranks );
+    }
 
 //-----> Terminating program
     delete backend;
@@ -50,6 +50,18 @@ struct EngineConfig{
     struct MpiContext{
         int world_size;
         int rank;
+        // how values and spikes are exchanged each step:
+        // as messages that are probed for their size, or with a neighbourhood collective over fixed-size buffers (needs MPI-3, opt-in)
+        enum ExchangeMode{
+            EXCHANGE_PROBE,
+            EXCHANGE_NEIGHBOR,
+        };
+        ExchangeMode exchange = EXCHANGE_PROBE;
+        // keep a single copy of identical constant tables per machine, in shared memory
+        bool share_const_tables = false;
+        // each node writes the trajectory columns of its own cells to a shard file, merged at the end;
+        // instead of sending them to the first node every step
+        bool sharded_output = false;
     };
 
     MpiContext my_mpi;
@@ -75,6 +87,7 @@ struct EngineConfig{
 		// std::vector<size_t> daw_positions_in_globstate; // TODO packed table entries
 		
 		size_t spike_mirror_buffer;
+		size_t spike_mirror_size; // the most spikes that can be sent in a step
 	};
 	struct RecvList_Impl{
 		size_t value_mirror_buffer;
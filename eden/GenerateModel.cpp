@@ -15,10 +15,13 @@
 
 #ifdef USE_MPI
     #include "Mpi_helpers.h"
+    #include <sys/stat.h> // for the node-local kernel directory
 #endif
 
 bool GenerateModel(const Model &model, const SimulatorConfig &config, EngineConfig &engine_config, RawTables &tabs) {
 
+    startup_phases.Restart();
+
     /*
     TODO:
         decouple derivative from integration rule
@@ -329,6 +332,7 @@ bool GenerateModel(const Model &model, const SimulatorConfig &config, EngineConf
                 GROUPED
             };
             CompartmentGrouping compartment_grouping;
+            bool split_into_parts; // the work of the cell is spread over several work items, for very large cells
 
             struct CompartmentGroupingImplementation{
 
@@ -363,6 +367,27 @@ bool GenerateModel(const Model &model, const SimulatorConfig &config, EngineConf
                 std::vector< Int > BwdEuler_ParentList;
                 std::vector< Real > BwdEuler_InvRCDiagonal;
 
+                // for the precomputed Hines solvers, the same for all instances of the cell type: per position in the elimination order,
+                std::vector< Int > Hines_OrderList; // the compartment
+                std::vector< Int > Hines_ParentList; // the position of its parent compartment, -1 for the root which is last
+                std::vector< Real > Hines_Upper; // the off-diagonal element of its row, towards the parent
+                std::vector< Real > Hines_Lower; // the multiple of its row to eliminate from the parent's row
+                std::vector< Real > Hines_InvDiagonal; // 1 / the diagonal element of its row, after elimination
+                std::vector< Real > Hines_ParentCoupling; // for Crank-Nicolson: the off-diagonal element of the parent's row, towards it
+                // when split into parts: disjoint ranges of positions that are solved in parallel, joined by the remaining positions ("junctions") that are solved in sequence.
+                // Every position in a range but the top has its parent in the range. At most one position outside has its parent in the range, the entry;
+                // the entry comes before the range, and its effect on the range is applied afterwards, through the gains of the range.
+                std::vector< Int > Hines_RangeStart;
+                std::vector< Int > Hines_RangeTop;
+                std::vector< Int > Hines_RangeEntry; // -1 if there is none
+                std::vector< Int > Hines_RangeOf; // per position, -1 for junctions
+                std::vector< Int > Hines_Interface; // the range tops and junctions, in order of position
+                std::vector< Real > Hines_EntryGain; // per position, how much of the entry's eliminated value it gets in forward elimination
+                std::vector< Real > Hines_TopGain; // per position, how much of the value of the top's parent it gets in back-substitution
+                std::vector< Int > Hines_PartRanges; // the first range of each part, plus the end
+                // or, when not split: how many instances are solved together by a part of their own, 0 if each instance solves its own
+                Int Hines_Lanes = 0;
+
             }cable_solver;
 
 
@@ -375,6 +400,9 @@ bool GenerateModel(const Model &model, const SimulatorConfig &config, EngineConf
                 size_t Index_BwdEuler_InvRCDiagonal; // table
 
                 size_t Index_BwdEuler_WorkDiagonal; // table
+                // the Hines solvers have their factorization compiled in the code, and only need a scratchpad per instance
+                size_t Index_Hines_WorkVoltage; // table
+                size_t Index_Hines_RangeCarry; // table, when split into parts: what is carried into each range from the rest of the cell
             };
             CableSolverImplementation cable_solver_implementation;
 
@@ -634,6 +662,26 @@ bool GenerateModel(const Model &model, const SimulatorConfig &config, EngineConf
         std::string code;
         IterationCallback callback;
         std::string name;
+
+        // A very large cell is split into parts, which run as separate work items in waves (see RawTables::work_item_wave).
+        // The cell's own kernel runs last.
+        enum SplitWave{
+            WAVE_COMPARTMENTS, // the internal dynamics of the compartments
+            WAVE_HINES_RANGES_FORWARD, // then forward elimination of the cable equation in each range
+            WAVE_HINES_JUNCTIONS_FORWARD, // and through the junctions,
+            WAVE_HINES_RANGES_BACKWARD, // back-substitution in each range, as if the value of the top's parent were 0
+            WAVE_HINES_JUNCTIONS_BACKWARD, // and through the junctions, to find the actual values of the top's parents
+            WAVE_HINES_RANGES_SCATTER, // to correct the ranges with
+            WAVE_HINES_LANES, // (or, for cells solved together with others of the same type, the whole cable solver)
+            WAVE_CELL // and the rest of the work for the cell
+        };
+        struct WorkItemPart{
+            std::string kernel_name;
+            int wave;
+            IterationCallback callback;
+            bool per_lane_group; // instantiated once for a group of instances, with tables of its own (see RawTables::work_item_lanes_from)
+        };
+        std::vector<WorkItemPart> split_parts;
     };
     std::vector<CellInternalSignature> cell_sigs;
 
@@ -668,6 +716,11 @@ bool GenerateModel(const Model &model, const SimulatorConfig &config, EngineConf
         input_types_per_cell[pop.component_cell][inp.segment].Addd(id_id); //TODO when work unit is compartment, probably after morpho analysis
 
     }
+    // and the kinds of inputs left out on this node, so that all nodes generate the same code
+    for( const auto &kind : net.elided_input_kinds ){
+        const auto &pop = net.populations.get(kind[1]);
+        input_types_per_cell[pop.component_cell][kind[2]].Addd( GetInputIdId( kind[0] ) );
+    }
     // and normalize input_types_per_cell lists after that
     for(size_t cell_seq = 0; cell_seq < cell_types.contents.size(); cell_seq++){
         for(auto keyval : input_types_per_cell[cell_seq]){
@@ -704,7 +757,10 @@ bool GenerateModel(const Model &model, const SimulatorConfig &config, EngineConf
         const auto &prepop = net.populations.get(proj.presynapticPopulation);
         const auto &postpop = net.populations.get(proj.postsynapticPopulation);
 
-        for(const auto &conn : proj.connections.contents){
+        // the connections kept on this node, then the kinds of those left out, so that all nodes generate the same code
+        const auto elided = proj.elided_connections();
+        for(size_t conn_seq = 0; conn_seq < proj.connections.size() + elided.size(); conn_seq++){
+            const auto conn = ( conn_seq < proj.connections.size() ) ? proj.connections[conn_seq] : elided[ conn_seq - proj.connections.size() ];
 
             // If a syn.component needs Vpeer, make indices for Vpeer
             // If a syn.component needs spike, make indices for peer to send spikes
@@ -1213,6 +1269,65 @@ bool GenerateModel(const Model &model, const SimulatorConfig &config, EngineConf
         }
         */
         // Assume inputs have already been defined, this is what the component assigns itself (derived etc.)
+        // Compute the derived variables, from the current values of state variables and requirements
+        static std::string Derived(const ComponentType &type, const DimensionSet &dimensions, const std::string &for_what, const std::string &line_prefix, Int &random_call_counter){
+            const auto &tab = line_prefix; // for a more convenient name
+            char tmps[2000];
+            std::string ret;
+
+            ret += tab+"// compute derived "+for_what+"\n";
+            for(size_t i = 0; i < type.derived_variables_topological_order.size(); i++){
+                Int seq = type.derived_variables_topological_order[i];
+                const auto &dervar = type.derived_variables.get(seq);
+
+                if(dervar.type == ComponentType::DerivedVariable::VALUE){
+                    sprintf(tmps, "Lems_derived_%ld = ", seq);
+                    assert( dervar.cases.size() == 0 );
+                    auto expression_string = ExpressionInfix(dervar.value, type, dimensions, random_call_counter);
+                    ret += tab+tmps+expression_string+";\n";
+                }
+                else if(dervar.type == ComponentType::DerivedVariable::CONDITIONAL){
+                    sprintf(tmps, "Lems_derived_%ld = 0;", seq); ret += tab + tmps;
+
+                    ret += tab + "if( 0 );\n"; // to avoid extra logic for the first 'if' and the case only 'default' case exists
+                    // conditional cases
+                    for( size_t case_seq = 0; case_seq < dervar.cases.size(); case_seq++ ){
+                        const auto &deri_case = dervar.cases[case_seq];
+                        if( (Int)case_seq == dervar.default_case ) continue;
+
+                        auto condition_string = ExpressionInfix(deri_case.condition, type, dimensions, random_call_counter);
+                        ret += tab + "else if( " + condition_string + " ){\n";
+
+                        auto value_string = ExpressionInfix(deri_case.value, type, dimensions, random_call_counter);
+                        sprintf(tmps, "\tLems_derived_%ld = ", seq);
+                        ret += tab + tmps + value_string + ";\n";
+
+                        ret += tab + "}\n";
+                    }
+                    // and default case
+                    if( dervar.default_case >= 0 ){
+                        const auto &deri_case = dervar.cases[dervar.default_case];
+
+                        ret += tab + "else{\n";
+
+                        auto value_string = ExpressionInfix(deri_case.value, type, dimensions, random_call_counter);
+                        sprintf(tmps, "\tLems_derived_%ld = ", seq);
+                        ret += tab + tmps + value_string + ";\n";
+
+                        ret += tab + "}\n";
+                    }
+                }
+                else{
+                    sprintf(tmps, "internal error: assigned derived variable %ld type %d\n", seq, dervar.type);
+                    return tmps; // why not
+                }
+                // if(debug){
+                //     sprintf(tmps, "printf(\"derived %zd = %%.17g \\n\", Lems_derived_%zd);\n", seq, seq); ret += tab+tmps;
+                // }
+            }
+
+            return ret;
+        }
         static std::string Assigned(const ComponentType &type, const DimensionSet &dimensions, const CellInternalSignature::ComponentSubSignature &subsig, const ISignatureAppender *Add, const std::string &for_what, const std::string &line_prefix, Int &random_call_counter, bool debug = false){
             const auto &tab = line_prefix; // for a more convenient name
             char tmps[2000];
@@ -1318,56 +1433,7 @@ bool GenerateModel(const Model &model, const SimulatorConfig &config, EngineConf
                 ret += tmps;
             }
 
-            ret += tab+"// compute derived "+for_what+"\n";
-            for(size_t i = 0; i < type.derived_variables_topological_order.size(); i++){
-                Int seq = type.derived_variables_topological_order[i];
-                const auto &dervar = type.derived_variables.get(seq);
-
-                if(dervar.type == ComponentType::DerivedVariable::VALUE){
-                    sprintf(tmps, "Lems_derived_%ld = ", seq);
-                    assert( dervar.cases.size() == 0 );
-                    auto expression_string = ExpressionInfix(dervar.value, type, dimensions, random_call_counter);
-                    ret += tab+tmps+expression_string+";\n";
-                }
-                else if(dervar.type == ComponentType::DerivedVariable::CONDITIONAL){
-                    sprintf(tmps, "Lems_derived_%ld = 0;", seq); ret += tab + tmps;
-
-                    ret += tab + "if( 0 );\n"; // to avoid extra logic for the first 'if' and the case only 'default' case exists
-                    // conditional cases
-                    for( size_t case_seq = 0; case_seq < dervar.cases.size(); case_seq++ ){
-                        const auto &deri_case = dervar.cases[case_seq];
-                        if( (Int)case_seq == dervar.default_case ) continue;
-
-                        auto condition_string = ExpressionInfix(deri_case.condition, type, dimensions, random_call_counter);
-                        ret += tab + "else if( " + condition_string + " ){\n";
-
-                        auto value_string = ExpressionInfix(deri_case.value, type, dimensions, random_call_counter);
-                        sprintf(tmps, "\tLems_derived_%ld = ", seq);
-                        ret += tab + tmps + value_string + ";\n";
-
-                        ret += tab + "}\n";
-                    }
-                    // and default case
-                    if( dervar.default_case >= 0 ){
-                        const auto &deri_case = dervar.cases[dervar.default_case];
-
-                        ret += tab + "else{\n";
-
-                        auto value_string = ExpressionInfix(deri_case.value, type, dimensions, random_call_counter);
-                        sprintf(tmps, "\tLems_derived_%ld = ", seq);
-                        ret += tab + tmps + value_string + ";\n";
-
-                        ret += tab + "}\n";
-                    }
-                }
-                else{
-                    sprintf(tmps, "internal error: assigned derived variable %ld type %d\n", seq, dervar.type);
-                    return tmps; // why not
-                }
-                // if(debug){
-                //     sprintf(tmps, "printf(\"derived %zd = %%.17g \\n\", Lems_derived_%zd);\n", seq, seq); ret += tab+tmps;
-                // }
-            }
+            ret += Derived( type, dimensions, for_what, tab, random_call_counter );
 
             return ret;
         }
@@ -1405,7 +1471,7 @@ bool GenerateModel(const Model &model, const SimulatorConfig &config, EngineConf
             return ret;
         }
         // Assume assigned values have already been defined, this updates state variables (rates, conditions etc.)
-        static std::string Update(EngineConfig * engine_config, const ComponentType &type, const DimensionSet &dimensions, const CellInternalSignature::ComponentSubSignature &subsig, const ISignatureAppender *Add, const std::string &for_what, const std::string &line_prefix, Int &random_call_counter, bool debug = false){
+        static std::string Update(EngineConfig * engine_config, const SimulatorConfig &config, const ComponentType &type, const DimensionSet &dimensions, const CellInternalSignature::ComponentSubSignature &subsig, const ISignatureAppender *Add, const std::string &for_what, const std::string &line_prefix, Int &random_call_counter, bool debug = false){
 
             const auto &tab = line_prefix; // for a more convenient name
             char tmps[2000];
@@ -1467,6 +1533,27 @@ bool GenerateModel(const Model &model, const SimulatorConfig &config, EngineConf
             ret += tab+"    // dynamics"+"\n";
             ret += tab+"    // (highest up is lowest priority)"+"\n";
 
+            // Higher-order and implicit schemes evaluate the derivatives again, at other values of the state variables.
+            // Derived variables are then computed again too; requirements (such as Vcomp) stay as they were at the start of the step.
+            // If random values are involved, these would be drawn again, so stick to Euler then.
+            auto UsesRandom = []( const ComponentType::ResolvedTermTable &expression ){
+                for( const auto &term : expression.tab.terms ) if( term.type == Term::RANDOM ) return true;
+                return false;
+            };
+            std::vector<size_t> continuous_vars;
+            bool uses_random = false;
+            for(size_t seq = 0; seq < type.state_variables.contents.size(); seq++){
+                const auto &state_variable = type.state_variables.get(seq);
+                if( state_variable.dynamics != ComponentType::StateVariable::DYNAMICS_CONTINUOUS ) continue;
+                continuous_vars.push_back(seq);
+                uses_random |= UsesRandom( state_variable.derivative );
+            }
+            for( const auto &dervar : type.derived_variables.contents ){
+                uses_random |= UsesRandom( dervar.value );
+                for( const auto &deri_case : dervar.cases ) uses_random |= UsesRandom( deri_case.condition ) || UsesRandom( deri_case.value );
+            }
+            const auto integrator = ( continuous_vars.empty() || uses_random ) ? SimulatorConfig::LEMS_EULER : config.lems_integrator;
+
             ret += tab+"    // time derivatives"+"\n";
             for(size_t seq = 0; seq < type.state_variables.contents.size(); seq++){
                 const auto &state_variable = type.state_variables.get(seq);
@@ -1478,7 +1565,8 @@ bool GenerateModel(const Model &model, const SimulatorConfig &config, EngineConf
                     ret += tab+tmps+"\n";
                 }
                 else if( state_variable.dynamics == ComponentType::StateVariable::DYNAMICS_CONTINUOUS ){
-                    // Euler integration, add fancier techniques LATER
+                    if( integrator != SimulatorConfig::LEMS_EULER ) continue; // see below
+                    // Euler integration
                     Dimension dim_of_derivative;
 
                     auto expression_string = ExpressionInfix(state_variable.derivative, type, dimensions, random_call_counter, dim_of_derivative);
@@ -1496,6 +1584,73 @@ bool GenerateModel(const Model &model, const SimulatorConfig &config, EngineConf
                     ret += tab+"    missing dynamics for variable "+itos(seq)+"\n";
                 }
             }
+            if( integrator != SimulatorConfig::LEMS_EULER ){
+                // Derivatives (in units of the variable per engine time unit) at the current values of the state variables, into Lems_<stage>_<seq>
+                auto EvaluateDerivatives = [&]( const char *stage ){
+                    for( size_t seq : continuous_vars ){
+                        const auto &state_variable = type.state_variables.get(seq);
+                        Dimension dim_of_derivative;
+                        auto expression_string = ExpressionInfix(state_variable.derivative, type, dimensions, random_call_counter, dim_of_derivative);
+                        LemsUnit conversion_factor = ( dimensions.GetNative(dim_of_derivative) * dimensions.GetNative(LEMS_Time) ).to( dimensions.GetNative(state_variable.dimension)) ;
+                        sprintf(tmps, "    float Lems_%s_%zd = ( ", stage, seq );
+                        ret += tab + tmps + expression_string + " )" + Convert::Suffix(conversion_factor) + ";\n";
+                    }
+                };
+                // Move the state variables to the start of the step plus a fraction of dt times the given derivatives, and update the derived variables to match
+                auto MoveState = [&]( const char *fraction, const char *stage ){
+                    for( size_t seq : continuous_vars ){
+                        sprintf(tmps, "    Lems_state_%zd = Lems_start_%zd + %s * dt * Lems_%s_%zd;\n", seq, seq, fraction, stage, seq ); ret += tab+tmps;
+                    }
+                    ret += Derived( type, dimensions, for_what, tab+"    ", random_call_counter );
+                };
+                auto SetNext = [&]( const std::string &increment_format ){
+                    for( size_t seq : continuous_vars ){
+                        auto Index = subsig.statevars_to_states.at(seq).index;
+                        sprintf(tmps, increment_format.c_str(), seq, seq, seq, seq, seq, seq);
+                        ret += tab + "    " + Add->ReferTo_StateNext(Index) + " = Lems_start_" + itos(seq) + " + " + tmps + ";\n";
+                    }
+                };
+
+                for( size_t seq : continuous_vars ){
+                    sprintf(tmps, "    const float Lems_start_%zd = Lems_state_%zd;\n", seq, seq ); ret += tab+tmps;
+                }
+                EvaluateDerivatives("k1");
+                if( integrator == SimulatorConfig::LEMS_HEUN ){
+                    ret += tab+"    // Heun's method\n";
+                    MoveState( "1.0f", "k1" ); EvaluateDerivatives("k2");
+                    SetNext( "dt * 0.5f * ( Lems_k1_%zd + Lems_k2_%zd )" );
+                }
+                else if( integrator == SimulatorConfig::LEMS_RK4 ){
+                    ret += tab+"    // classic Runge-Kutta\n";
+                    MoveState( "0.5f", "k1" ); EvaluateDerivatives("k2");
+                    MoveState( "0.5f", "k2" ); EvaluateDerivatives("k3");
+                    MoveState( "1.0f", "k3" ); EvaluateDerivatives("k4");
+                    SetNext( "dt * ( 1.0f / 6.0f ) * ( Lems_k1_%zd + 2 * Lems_k2_%zd + 2 * Lems_k3_%zd + Lems_k4_%zd )" );
+                }
+                else if( integrator == SimulatorConfig::LEMS_SEMI_IMPLICIT ){
+                    // Linearize each derivative in its own variable, by a finite difference (exact when the derivative is linear in it),
+                    // and take the decaying part implicitly: x_next = x + dt * f / ( 1 - dt * min( df/dx, 0 ) )
+                    ret += tab+"    // linearly implicit Euler\n";
+                    for( size_t seq : continuous_vars ){
+                        const auto &state_variable = type.state_variables.get(seq);
+                        Dimension dim_of_derivative;
+                        auto expression_string = ExpressionInfix(state_variable.derivative, type, dimensions, random_call_counter, dim_of_derivative);
+                        LemsUnit conversion_factor = ( dimensions.GetNative(dim_of_derivative) * dimensions.GetNative(LEMS_Time) ).to( dimensions.GetNative(state_variable.dimension)) ;
+                        sprintf(tmps, "    const float Lems_dx_%zd = 1e-3f * fabsf( Lems_start_%zd ) + 1e-6f;\n", seq, seq ); ret += tab+tmps;
+                        sprintf(tmps, "    Lems_state_%zd = Lems_start_%zd + Lems_dx_%zd;\n", seq, seq, seq ); ret += tab+tmps;
+                        ret += Derived( type, dimensions, for_what, tab+"    ", random_call_counter );
+                        sprintf(tmps, "    const float Lems_dfdx_%zd = ( ( ", seq ); ret += tab + tmps + expression_string + " )" + Convert::Suffix(conversion_factor);
+                        sprintf(tmps, " - Lems_k1_%zd ) / Lems_dx_%zd;\n", seq, seq ); ret += tmps;
+                        sprintf(tmps, "    Lems_state_%zd = Lems_start_%zd;\n", seq, seq ); ret += tab+tmps;
+                    }
+                    SetNext( "dt * Lems_k1_%zd / ( 1 - dt * fminf( Lems_dfdx_%zd, 0 ) )" );
+                }
+                // back to the start of the step, for conditions and exposures
+                for( size_t seq : continuous_vars ){
+                    sprintf(tmps, "    Lems_state_%zd = Lems_start_%zd;\n", seq, seq ); ret += tab+tmps;
+                }
+                ret += Derived( type, dimensions, for_what, tab+"    ", random_call_counter );
+            }
             // todo run conditions AND integrate in the same step, somehow;
             // though this will require two invocations of assigned variables:
             //   one to evaluate triggers to handle,
@@ -1574,6 +1729,7 @@ bool GenerateModel(const Model &model, const SimulatorConfig &config, EngineConf
         const SignatureAppender_Single &AppendSingle;
         const SignatureAppender_Table &AppendMulti;
         EngineConfig * engine_config;
+        const SimulatorConfig &config;
 
         // TODO return bool for error handling
 
@@ -1594,7 +1750,7 @@ bool GenerateModel(const Model &model, const SimulatorConfig &config, EngineConf
 
             // also add integration code here, to finish with component code (and get event outputs !)
             code += tab+"// integrate inline\n";
-            std::string lemsupdate = DescribeLems::Update(engine_config, comptype, model.dimensions, component, &AppendSingle, for_what, tab, random_call_counter, debug);
+            std::string lemsupdate = DescribeLems::Update(engine_config, config, comptype, model.dimensions, component, &AppendSingle, for_what, tab, random_call_counter, debug);
             code += lemsupdate;
 
             code += tab+"// expose inline\n";
@@ -1656,7 +1812,7 @@ bool GenerateModel(const Model &model, const SimulatorConfig &config, EngineConf
                 code += lemscode;
 
                 code += tab+"// integrate inline\n";
-                std::string lemsupdate = DescribeLems::Update(engine_config, comptype, model.dimensions, compsubsig, &AppendMulti ,for_what, tab, random_call_counter, debug);
+                std::string lemsupdate = DescribeLems::Update(engine_config, config, comptype, model.dimensions, compsubsig, &AppendMulti ,for_what, tab, random_call_counter, debug);
                 code += lemsupdate;
             }
 
@@ -1688,8 +1844,8 @@ bool GenerateModel(const Model &model, const SimulatorConfig &config, EngineConf
             return code;
         }
 
-        InlineLems_AllocatorCoder(EngineConfig & _engine_config, const Model &_m, Int &_cc, const SignatureAppender_Single &_as, const SignatureAppender_Table &_am )
-                : model(_m), random_call_counter(_cc), AppendSingle(_as), AppendMulti(_am), engine_config(&_engine_config) {
+        InlineLems_AllocatorCoder(EngineConfig & _engine_config, const SimulatorConfig &_config, const Model &_m, Int &_cc, const SignatureAppender_Single &_as, const SignatureAppender_Table &_am )
+                : model(_m), random_call_counter(_cc), AppendSingle(_as), AppendMulti(_am), engine_config(&_engine_config), config(_config) {
 
         }
     };
@@ -1787,9 +1943,8 @@ bool GenerateModel(const Model &model, const SimulatorConfig &config, EngineConf
         code += "\n";
     };
 
-    auto EmitWorkItemRoutineHeader = [ &config , &engine_config ]( std::string &code ){
+    auto EmitWorkItemRoutineHeader = [ &config , &engine_config ]( std::string &code, std::string kernel_name = "doit" ){
         (void) config; // just in case
-        std::string kernel_name = "doit";
         if (engine_config.backend == backend_kind_gpu) {
             kernel_name = "doit_single";
             code += "static ";
@@ -1904,59 +2059,284 @@ bool GenerateModel(const Model &model, const SimulatorConfig &config, EngineConf
         code += "// Generated code block END\n";
     };
 
-    // LATER analyze cell types before generating codes, for compartment as work item
-    printf("Creating cell types...\n");
-    // TODO build only the cells actually used
-    for(size_t cell_seq = 0; cell_seq < cell_types.contents.size(); cell_seq++){
-        const auto &cell_type = cell_types.contents[cell_seq];
+    // Building and loading of kernel code
+    // These are kept apart, since under MPI each kernel is built once, to be shared with all nodes
+    auto BuildKernel = [ &config, &engine_config ]( const std::string &code, const std::string &code_filename, const std::string &dll_filename ){
 
+        FILE *fout = fopen(code_filename.c_str(), "w");
+        if(!fout){
+            perror(code_filename.c_str());
+            return false;
+        }
+        if( !fprintf(fout, "%s", code.c_str() ) ){
+            perror(code_filename.c_str());
+            return false;
+        }
+        fclose(fout);
 
-        CellInternalSignature sig;
+        std::string basic_flags =
+                " -std=c11 -Wall"
+                " -Wno-attributes"
+                " -Wno-unused-variable -Wno-unused-but-set-variable -Wno-unused-function";
+        std::string dll_flags = " -shared -fpic"; //" -shared -fpic -nodefaultlibs";
+        std::string optimization_flags = " -Ofast -mcpu=native -mtune=native";
+        std::string fastbuild_flags = " -O0";
+        std::string asm_flags = " -S -masm=intel -fverbose-asm";
+        std::string lm_flags = " -lm";
+        if(config.use_icc){
+            lm_flags = " -limf"; // TODO check if SVML should be added here too
+        }
+        if( !config.use_icc && config.tweak_lmvec ){
+            // some GCC(glibc?) versions need this for vectorization https://sourceware.org/bugzilla/show_bug.cgi?id=20539
+            // also, mvec must be linked first: https://sourceware.org/glibc/wiki/libmvec
+            lm_flags = " -lmvec -lm" ; // XXX must revert automatically, if compiler is old enough
+        }
+        // TODO extra_flags, vec_report etc.
 
-        sig.name = "Cell_type_"+itos(cell_seq);
+        std::string compiler_name;
 
-        // TODO something more elegant to compile the actual code kernels:
-        // dry run, or synchronization to use the same files(beware of distributed file systems !)
-        if (engine_config.use_mpi) {
-            sig.name += "_rank_"+itos(engine_config.my_mpi.rank);
+        if (engine_config.backend == backend_kind_gpu) {
+            if(config.use_icc) {
+                fprintf(stderr, "Error can't use icc to compile CUDA kernels");
+                return false;
+            }
+            compiler_name = "nvcc";
+            basic_flags = "-std=c++11 -lm -Xcompiler -Wall,-Wno-attributes,-Wno-unused-variable,-Wno-unused-but-set-variable,-Wno-unused-function -Xcudafe --diag_suppress=177";
+            if (config.debug_gpu_kernels) {
+                basic_flags += " -g -G";
+            }
+            if (engine_config.trove) {
+                basic_flags += " -Ithirdparty";
+            }
+            dll_flags = " -Xcompiler -fPIC -shared";
+            optimization_flags = "";
+            fastbuild_flags = "";
+        } else {
+            if(config.use_icc){
+                compiler_name = "icc";
+            } else {
+                compiler_name = "gcc";
+            }
         }
 
-        printf("\nAnalyzing %s...:\n", sig.name.c_str());
+        std::string code_quality_flags = optimization_flags;
 
+        // don't bother with optimization if code is massive
+        if( code.size() > 1024 * 1024LL ){
+            printf("Choosing fast build due to code size..\n");
+            code_quality_flags = fastbuild_flags;
+        }
 
-        // cell-level work items for now
-        SignatureAppender_Single AppendSingle_CellScope( sig.cell_wig );
-        SignatureAppender_Table AppendMulti_CellScope( sig.cell_wig );
-        InlineLems_AllocatorCoder DescribeLemsInline_CellScope(engine_config, model, sig.cell_wig.random_call_counter, AppendSingle_CellScope, AppendMulti_CellScope );
+        // Check if compiler is present
+        // TODO XXX hoist this check higher up, to avoid overhead !
+        // TODO more branching to pick the method to check presence LATER, for more compilers
+        if( system((compiler_name + " --version").c_str()) != 0 ){
+            std::string complaint_line = "Could not invoke '"+compiler_name+"' compiler! Make sure it is installed, and available on PATH.";
 
-        // standardize the nomenclature, yay!
-        // <context>_<value or table>_<const, state, stateNext>
-        // Exposed Context is a slice of the data space, that's relevant for a subitem (and which subsignatures refer to)
-        // just like the work-item context is a slice of the global data space
-        // Try not to over-use, to avoid overhead! Flatten wherever possible!
-        // TODO make everything tabular, after all, and special-case flatten small vectors or sth
-        auto ExposeSubitemContext = [&engine_config]( const std::string &to_context, const std::string &from_context, const std::string &tab ){
-            std::string code;
+            std::string more_commentary;
+            // maybe mention that gcc is the default (or auto selected) LATER
 
-            const auto &by = from_context, &to = to_context;
+            // Give some instructions to the astonished user, though the most complete instructions should really be in the manual (when that is written)
+            if(config.use_icc){
+                more_commentary = "Check the instructions on how to set up ICC at Intel's website:\n"
+                                  "https://software.intel.com/content/www/us/en/develop/articles/intel-system-studio-download-and-install-intel-c-compiler.html"
+                                  "\nand on setting PATH:\n"
+                                  "https://software.intel.com/content/www/us/en/develop/documentation/cpp-compiler-developer-guide-and-reference/top/compiler-setup/using-the-command-line/specifying-the-location-of-compiler-components.html";
+            }
+            else{
+                // gcc by default
+#if defined _WIN32
+                more_commentary = "If a compiler is not already installed, a build for GCC on Windows can be downloaded from:\n";
 
+                #if INTPTR_MAX == INT32_MAX
+                more_commentary += "https://sourceforge.net/projects/mingw-w64/files/Toolchains%20targetting%20Win32/Personal%20Builds/mingw-builds/8.1.0/threads-posix/sjlj/i686-8.1.0-release-posix-sjlj-rt_v6-rev0.7z";
+                #elif INTPTR_MAX == INT64_MAX
+                more_commentary += "https://sourceforge.net/projects/mingw-w64/files/Toolchains%20targetting%20Wing4/Personal%20Builds/mingw-builds/8.1.0/threads-posix/seh/x86_64-8.1.0-release-posix-seh-rt_v6-rev0.7z";
+                #endif
+                // but still may have to detect non-PC architecture ... LATER
 
-            if (engine_config.trove) {
-                code +=   "    trove_at_index<float> "+to+"_constants("+by+"_constants, const_"+to+"_index);\n";
-                code +=   "    trove_at_index<float> "+to+"_state("+by+"_state, state_"+to+"_index);\n";
-                code +=   "    trove_at_index<float> "+to+"_stateNext("+by+"_stateNext, state_"+to+"_index);\n";
-                //code +=   "    const float *"+to+"_state     = "+by+"_state     + state_"+to+"_index;\n";
-                //code +=   "          float *"+to+"_stateNext = "+by+"_stateNext + state_"+to+"_index;\n";
-                code +=   "    \n";
+                more_commentary += "\nUnpack the file anywhere, and add the unpacked <path ...>\\bin directory to EDEN's PATH.";
+#elif defined __linux__
+                more_commentary = "GCC is usually already installed on Linux setups. It if is not installed, refer to your distribution's documentation on how to install the essentials for building from source.";
+#elif defined(__APPLE__)
+                more_commentary = "A GCC-compatible compiler cn be installed with the Command Line Developer Tools for Mac. Run the following command on the Terminal to install:\n";
+                more_commentary += "xcode-select --install\n\n";
+                more_commentary += "Alternatively, the compiler used by default, GCC, can be installed through Homebrew for Mac OS X:\n";
+                more_commentary += "brew install gcc";
+                more_commentary += "\nRefer to http://brew.sh on how to set up Homebrew. (It may already be installed, in order to install Python 3.)";
+                #else
 
-                code += tab+"\tconst long long *"+to+"_const_table_f32_sizes      = "+by+"_const_table_f32_sizes      + table_cf32_"+to+"_index;\n";
-                code += tab+"\tconst Table_F32 *"+to+"_const_table_f32_arrays     = "+by+"_const_table_f32_arrays     + table_cf32_"+to+"_index;\n";
-                code += tab+"\tconst long long *"+to+"_const_table_i64_sizes      = "+by+"_const_table_i64_sizes      + table_ci64_"+to+"_index;\n";
-                code += tab+"\tconst Table_I64 *"+to+"_const_table_i64_arrays     = "+by+"_const_table_i64_arrays     + table_ci64_"+to+"_index;\n";
-                code += tab+"\tconst long long *"+to+"_state_table_f32_sizes      = "+by+"_state_table_f32_sizes      + table_sf32_"+to+"_index;\n";
-                code += tab+"\tconst Table_F32 *"+to+"_state_table_f32_arrays     = "+by+"_state_table_f32_arrays     + table_sf32_"+to+"_index;\n";
-                code += tab+"\t      Table_F32 *"+to+"_stateNext_table_f32_arrays = "+by+"_stateNext_table_f32_arrays + table_sf32_"+to+"_index;\n";
-                code += tab+"\tconst long long *"+to+"_state_table_i64_sizes      = "+by+"_state_table_i64_sizes      + table_si64_"+to+"_index;\n";
+#endif
+            }
+            // also note ways to set path
+#if defined _WIN32
+            more_commentary += "If using the command line, PATH can be set as follows:\n"
+            "path <path to compiler executable>;%PATH%\n"
+            "eden.exe ..."; // maybe argv[0], whatever
+#elif defined __linux__
+            more_commentary += "If using the command line, PATH can be set as follows:\n"
+                               "PATH=<path to compiler executable>:$PATH eden ...";
+#endif
+
+            more_commentary += "If using Python, PATH can be set as follows:\n"
+                               "os.environ[\"PATH\"] = <path to compiler executable> + os.pathsep + os.environ[\"PATH\"]\n"
+                               "runEden(...)";
+
+            fprintf(stderr, "%s\n", complaint_line.c_str());
+            if( !more_commentary.empty() ){
+                fprintf(stderr, "%s\n", more_commentary.c_str());
+            }
+
+            return false;
+        }
+
+        // NOTE -lm must be put last, after other obj files (like source code) have stated their dependencies on libm
+        // further reading: https://eli.thegreenplace.net/2013/07/09/library-order-in-static-linking
+        std::string cmdline =     compiler_name + " " + basic_flags + dll_flags + code_quality_flags + " -o " + dll_filename + " " + code_filename + lm_flags;
+        printf("%s\n", cmdline.c_str());
+        std::string cmdline_asm = compiler_name + " " + basic_flags + dll_flags + code_quality_flags + asm_flags + " " + code_filename + lm_flags;
+        if(config.output_assembly){
+            if( system(cmdline_asm.c_str()) != 0 ){
+                fprintf(stderr, "Could not build %s assembly\n", dll_filename.c_str());
+                return false;
+            }
+        }
+        if( system(cmdline.c_str()) != 0 ){
+            fprintf(stderr, "Could not build %s\n", dll_filename.c_str());
+            return false;
+        }
+
+        return true;
+    };
+    auto LoadKernel = [ ]( const std::string &dll_path, IterationCallback &callback, const std::string &function_name = "doit" ){
+        // load the code
+        callback = NULL;
+
+#if defined (__linux__) || defined(__APPLE__)
+        void *dll_handle = dlopen(dll_path.c_str(), RTLD_NOW);
+        if(!dll_handle){
+            fprintf(stderr, "Error loading %s: %s\n", dll_path.c_str(), dlerror());
+            return false;
+        }
+        *(void**)(& callback ) = dlsym(dll_handle, function_name.c_str()); // C-style voodoo to make a "valid" cast
+        if(!callback){
+            fprintf(stderr, "Error loading %s symbol %s: %s\n", dll_path.c_str(), function_name.c_str(), dlerror());
+            dlclose(dll_handle);
+            return false;
+        }
+#endif
+#ifdef _WIN32
+        // TODO normalize paths to place dll's somewhere else than cwd !
+        // TODO Unicode support, with MultiByteToWideChar
+        HMODULE dll_handle = LoadLibraryA(dll_path.c_str());
+        if(!dll_handle){
+            DWORD errCode = GetLastError();
+            fprintf(stderr, "Error loading %s: %s\n", dll_path.c_str(), DescribeErrorCode_Windows(errCode).c_str());
+            return false;
+        }
+        *(void**)(& callback ) = (void*)GetProcAddress(dll_handle, function_name.c_str());
+        if(!callback){
+            DWORD errCode = GetLastError();
+            fprintf(stderr, "Error loading %s symbol %s: %s\n", dll_path.c_str(), function_name.c_str(), DescribeErrorCode_Windows(errCode).c_str());
+            FreeLibrary(dll_handle);
+            return false;
+        }
+#endif
+
+        if(!callback){
+            // which is already guarded against in platform specific code.
+            // the only reason this should happen is if the platform is not supported
+            fprintf(stderr, "Error loading %s: %s\n", dll_path.c_str(), "internal error");
+            return false;
+        }
+
+        // LATER keep a set of dynamic libraries loaded, to cleanup
+        // though it's pointless in this sort of application
+        return true;
+    };
+
+    // and the parts of a split cell, from the same library
+    auto LoadCellKernels = [ &LoadKernel ]( const std::string &dll_path, CellInternalSignature &sig ){
+        if( !LoadKernel( dll_path, sig.callback ) ) return false;
+        for( auto &part : sig.split_parts ){
+            if( !LoadKernel( dll_path, part.callback, part.kernel_name ) ) return false;
+        }
+        return true;
+    };
+
+    // the path to load a library built in the working directory
+    auto LocalDllPath = []( const std::string &dll_filename ){
+#if defined _WIN32
+        return ".\\"+dll_filename; // TODO normalize paths to place dll's somewhere else than cwd !
+#else
+        return "./"+dll_filename;
+#endif
+    };
+
+#ifdef USE_MPI
+    // kernels waiting to be built and shared among nodes
+    struct KernelToShare{
+        size_t sig_seq;
+        std::string code_filename;
+        std::string dll_filename;
+    };
+    std::vector<KernelToShare> kernels_to_share;
+#endif
+
+
+    // LATER analyze cell types before generating codes, for compartment as work item
+    startup_phases.Lap("model: analysis");
+    printf("Creating cell types...\n");
+    Timer cell_types_timer;
+    // TODO build only the cells actually used
+    for(size_t cell_seq = 0; cell_seq < cell_types.contents.size(); cell_seq++){
+        const auto &cell_type = cell_types.contents[cell_seq];
+        // breakdown per cell type, for the startup report
+        Timer cell_type_timer;
+        double cell_type_analysis_sec = 0; // the rest of the time until compilation is code generation
+
+
+        CellInternalSignature sig;
+
+        sig.name = "Cell_type_"+itos(cell_seq);
+        // NB: the same name is used on all nodes, kernels are built once and shared when using MPI
+
+        printf("\nAnalyzing %s...:\n", sig.name.c_str());
+
+
+        // cell-level work items for now
+        SignatureAppender_Single AppendSingle_CellScope( sig.cell_wig );
+        SignatureAppender_Table AppendMulti_CellScope( sig.cell_wig );
+        InlineLems_AllocatorCoder DescribeLemsInline_CellScope(engine_config, config, model, sig.cell_wig.random_call_counter, AppendSingle_CellScope, AppendMulti_CellScope );
+
+        // standardize the nomenclature, yay!
+        // <context>_<value or table>_<const, state, stateNext>
+        // Exposed Context is a slice of the data space, that's relevant for a subitem (and which subsignatures refer to)
+        // just like the work-item context is a slice of the global data space
+        // Try not to over-use, to avoid overhead! Flatten wherever possible!
+        // TODO make everything tabular, after all, and special-case flatten small vectors or sth
+        auto ExposeSubitemContext = [&engine_config]( const std::string &to_context, const std::string &from_context, const std::string &tab ){
+            std::string code;
+
+            const auto &by = from_context, &to = to_context;
+
+
+            if (engine_config.trove) {
+                code +=   "    trove_at_index<float> "+to+"_constants("+by+"_constants, const_"+to+"_index);\n";
+                code +=   "    trove_at_index<float> "+to+"_state("+by+"_state, state_"+to+"_index);\n";
+                code +=   "    trove_at_index<float> "+to+"_stateNext("+by+"_stateNext, state_"+to+"_index);\n";
+                //code +=   "    const float *"+to+"_state     = "+by+"_state     + state_"+to+"_index;\n";
+                //code +=   "          float *"+to+"_stateNext = "+by+"_stateNext + state_"+to+"_index;\n";
+                code +=   "    \n";
+
+                code += tab+"\tconst long long *"+to+"_const_table_f32_sizes      = "+by+"_const_table_f32_sizes      + table_cf32_"+to+"_index;\n";
+                code += tab+"\tconst Table_F32 *"+to+"_const_table_f32_arrays     = "+by+"_const_table_f32_arrays     + table_cf32_"+to+"_index;\n";
+                code += tab+"\tconst long long *"+to+"_const_table_i64_sizes      = "+by+"_const_table_i64_sizes      + table_ci64_"+to+"_index;\n";
+                code += tab+"\tconst Table_I64 *"+to+"_const_table_i64_arrays     = "+by+"_const_table_i64_arrays     + table_ci64_"+to+"_index;\n";
+                code += tab+"\tconst long long *"+to+"_state_table_f32_sizes      = "+by+"_state_table_f32_sizes      + table_sf32_"+to+"_index;\n";
+                code += tab+"\tconst Table_F32 *"+to+"_state_table_f32_arrays     = "+by+"_state_table_f32_arrays     + table_sf32_"+to+"_index;\n";
+                code += tab+"\t      Table_F32 *"+to+"_stateNext_table_f32_arrays = "+by+"_stateNext_table_f32_arrays + table_sf32_"+to+"_index;\n";
+                code += tab+"\tconst long long *"+to+"_state_table_i64_sizes      = "+by+"_state_table_i64_sizes      + table_si64_"+to+"_index;\n";
                 code += tab+"\t      Table_I64 *"+to+"_state_table_i64_arrays     = "+by+"_state_table_i64_arrays     + table_si64_"+to+"_index;\n";
                 code += tab+"\t      Table_I64 *"+to+"_stateNext_table_i64_arrays = "+by+"_stateNext_table_i64_arrays + table_si64_"+to+"_index;\n";
             } else {
@@ -3031,6 +3411,179 @@ bool GenerateModel(const Model &model, const SimulatorConfig &config, EngineConf
             if( cell_cable_solver == SimulatorConfig::CABLE_SOLVER_AUTO ){
                 cell_cable_solver = SimulatorConfig::CABLE_BWD_EULER; // TODO
             }
+            // large cells are split into parts of up to split_cells_compartments compartments, which run as separate work items;
+            // GPU kernels are one thread per work item for now
+            pig.split_into_parts = config.split_cells_compartments > 0 && engine_config.backend != backend_kind_gpu
+                && (long long) segment_compartments.size() > config.split_cells_compartments;
+            if( pig.split_into_parts ){
+                printf("Splitting the %zd compartments of %s into parts of up to %lld\n", segment_compartments.size(), sig.name.c_str(), config.split_cells_compartments);
+                if(!( cell_cable_solver == SimulatorConfig::CABLE_BWD_EULER_HINES || cell_cable_solver == SimulatorConfig::CABLE_CRANK_NICOLSON )){
+                    printf("\tthe cable solver stays in one part; bwd_euler_hines and crank_nicolson can be split too\n");
+                }
+            }
+            if( cell_cable_solver == SimulatorConfig::CABLE_BWD_EULER_HINES || cell_cable_solver == SimulatorConfig::CABLE_CRANK_NICOLSON ){
+                // Factorize the cable matrix ( I - h * A ) once, since dt does not change during the simulation;
+                // h = dt for backward Euler, and dt/2 for Crank-Nicolson which also applies ( I + h * A ) to the voltages at the start of the step.
+                // Compartments are taken in the same elimination order as bwd_euler, where children come before their parent.
+                const bool crank_nicolson = ( cell_cable_solver == SimulatorConfig::CABLE_CRANK_NICOLSON );
+                const double h = ( Scales<Time>::native * Scales<Frequency>::native ).ConvertTo( sim.step, Scales<Dimensionless>::native ) * ( crank_nicolson ? 0.5 : 1.0 );
+                const auto &elim_order = pig.cable_solver.BwdEuler_OrderList;
+                const auto &elim_parent = pig.cable_solver.BwdEuler_ParentList;
+                const size_t Compartments = elim_order.size();
+                if( Compartments != segment_compartments.size() ){
+                    printf("error: Cell type %zd has compartments not connected to the root, cannot use the Hines cable solver\n", cell_seq);
+                    return false;
+                }
+
+                std::vector< Int > position_of( Compartments, -1 );
+                for( size_t k = 0; k < Compartments; k++ ) position_of[ elim_order[k] ] = k;
+
+                auto &cabl_def = pig.cable_solver;
+                cabl_def.Hines_OrderList = elim_order;
+                cabl_def.Hines_ParentList.assign( Compartments, -1 );
+                cabl_def.Hines_Upper.assign( Compartments, 0 );
+                cabl_def.Hines_Lower.assign( Compartments, 0 );
+                cabl_def.Hines_InvDiagonal.assign( Compartments, 0 );
+                if( crank_nicolson ) cabl_def.Hines_ParentCoupling.assign( Compartments, 0 );
+
+                std::vector< double > diagonal( Compartments );
+                for( size_t k = 0; k < Compartments; k++ ){
+                    diagonal[k] = 1 + h * pig.cable_solver.BwdEuler_InvRCDiagonal[ elim_order[k] ];
+                }
+                for( size_t k = 0; k + 1 < Compartments; k++ ){
+                    Int i = elim_order[k];
+                    Int j = elim_parent[i];
+                    Int p = position_of[j];
+                    auto R = inter_segment_axial_resistance[ std::max( i, j ) ];
+                    auto InvRC = [ &R ]( double C ){
+                        return ( (Scales<Resistance>::native * Scales<Capacitance>::native)^(-1) ).ConvertTo( 1/(R*C), Scales<Frequency>::native );
+                    };
+                    double upper = - h * InvRC( segment_capacitance[i] ); // row i, column j
+                    double lower = - h * InvRC( segment_capacitance[j] ); // row j, column i
+                    double ratio = lower / diagonal[k];
+                    diagonal[p] -= ratio * upper;
+
+                    cabl_def.Hines_ParentList[k] = p;
+                    cabl_def.Hines_Upper[k] = upper;
+                    cabl_def.Hines_Lower[k] = ratio;
+                    if( crank_nicolson ) cabl_def.Hines_ParentCoupling[k] = lower;
+                }
+                for( size_t k = 0; k < Compartments; k++ ) cabl_def.Hines_InvDiagonal[k] = 1 / diagonal[k];
+
+                if( pig.split_into_parts ){
+                    // Split the positions into ranges of up to split_cells_compartments, to be solved in parallel, and junctions to join them in sequence.
+                    // This relies on the positions being in depth-first post-order, so that each subtree is a contiguous range of positions that ends with its root;
+                    // and that an unbranched stretch is too.
+                    const Int max_range = (Int) config.split_cells_compartments;
+                    std::vector< std::vector< Int > > children( Compartments );
+                    std::vector< Int > subtree_size( Compartments, 1 );
+                    for( size_t k = 0; k + 1 < Compartments; k++ ){
+                        Int p = cabl_def.Hines_ParentList[k];
+                        children[p].push_back( k );
+                        subtree_size[p] += subtree_size[k]; // children come first
+                    }
+                    bool post_order = true;
+                    for( size_t k = 0; k < Compartments; k++ ){
+                        // the children's subtrees must tile the positions before k, from the last child down
+                        Int expected = (Int) k - 1;
+                        for( auto it = children[k].rbegin(); it != children[k].rend(); it++ ){
+                            if( *it != expected ) post_order = false;
+                            expected -= subtree_size[*it];
+                        }
+                        if( expected != (Int) k - subtree_size[k] ) post_order = false;
+                    }
+
+                    struct Range{ Int start, top, entry; };
+                    std::vector< Range > ranges;
+                    // cut an unbranched stretch into ranges from the top; each range is entered from the position right below it
+                    auto AddChain = [ &ranges, max_range ]( Int bottom, Int top, Int entry_below ){
+                        for( Int t = top; t >= bottom; t -= max_range ){
+                            Int start = std::max( bottom, t - max_range + 1 );
+                            ranges.push_back( { start, t, ( start > bottom ) ? start - 1 : entry_below } );
+                        }
+                    };
+                    // the root is always a junction, start from its branches
+                    std::vector< Int > pending = children[ Compartments - 1 ];
+                    while( post_order && !pending.empty() ){
+                        Int k = pending.back(); pending.pop_back();
+                        if( subtree_size[k] <= max_range ){
+                            ranges.push_back( { k - subtree_size[k] + 1, k, -1 } );
+                            continue;
+                        }
+                        // follow the unbranched stretch down to the next branch point
+                        Int n = k;
+                        while( children[n].size() == 1 ) n = children[n][0];
+                        if( children[n].empty() ){
+                            // a long unbranched cable
+                            AddChain( n, k, -1 );
+                            continue;
+                        }
+                        // the branch point joins its branches as a junction, the stretch above it is cut into ranges too
+                        if( k > n ) AddChain( n + 1, k, n );
+                        pending.insert( pending.end(), children[n].begin(), children[n].end() );
+                    }
+                    std::sort( ranges.begin(), ranges.end(), []( const Range &a, const Range &b ){ return a.top < b.top; } );
+
+                    if( !post_order || ranges.size() < 2 ){
+                        printf("\tthe cable solver stays in one part, %s\n", post_order ? "it has too few ranges to split into" : "since the compartments are not in depth-first order");
+                    }
+                    else{
+                        cabl_def.Hines_RangeOf.assign( Compartments, -1 );
+                        cabl_def.Hines_EntryGain.assign( Compartments, 0 );
+                        cabl_def.Hines_TopGain.assign( Compartments, 0 );
+                        for( size_t s = 0; s < ranges.size(); s++ ){
+                            const Range &range = ranges[s];
+                            cabl_def.Hines_RangeStart.push_back( range.start );
+                            cabl_def.Hines_RangeTop.push_back( range.top );
+                            cabl_def.Hines_RangeEntry.push_back( range.entry );
+                            for( Int k = range.start; k <= range.top; k++ ) cabl_def.Hines_RangeOf[k] = s;
+
+                            // the entry's eliminated value is passed up along the path to the top
+                            if( range.entry >= 0 ){
+                                double gain = 1;
+                                for( Int k = range.entry; k != range.top; ){
+                                    gain *= -cabl_def.Hines_Lower[k];
+                                    k = cabl_def.Hines_ParentList[k];
+                                    cabl_def.Hines_EntryGain[k] = gain;
+                                }
+                            }
+                            // and the value of the top's parent is passed down to all of the range
+                            std::vector< double > top_gain( range.top - range.start + 1 );
+                            for( Int k = range.top; k >= range.start; k-- ){
+                                double from_parent = ( k == range.top ) ? 1 : top_gain[ cabl_def.Hines_ParentList[k] - range.start ];
+                                top_gain[ k - range.start ] = -cabl_def.Hines_Upper[k] * cabl_def.Hines_InvDiagonal[k] * from_parent;
+                                cabl_def.Hines_TopGain[k] = top_gain[ k - range.start ];
+                            }
+                        }
+                        size_t junctions = 0;
+                        for( size_t k = 0; k + 1 < Compartments; k++ ){
+                            Int s = cabl_def.Hines_RangeOf[k];
+                            if( s < 0 ) junctions++;
+                            if( s < 0 || (Int) k == ranges[s].top ) cabl_def.Hines_Interface.push_back( k );
+                        }
+                        // and bundle consecutive ranges into parts, up to the same size
+                        Int part_compartments = 0;
+                        for( size_t s = 0; s < ranges.size(); s++ ){
+                            Int range_compartments = ranges[s].top - ranges[s].start + 1;
+                            if( s == 0 || part_compartments + range_compartments > max_range ){
+                                cabl_def.Hines_PartRanges.push_back( s );
+                                part_compartments = 0;
+                            }
+                            part_compartments += range_compartments;
+                        }
+                        cabl_def.Hines_PartRanges.push_back( ranges.size() );
+
+                        printf("\tthe cable solver is split into %zd ranges in %zd parts, joined by %zd compartments in sequence\n",
+                            ranges.size(), cabl_def.Hines_PartRanges.size() - 1, junctions + 1 );
+                    }
+                }
+                else if( config.hines_lanes > 1 && engine_config.backend != backend_kind_gpu ){
+                    // The instances share the factorization, so the same elimination can run for several of them at once, one per SIMD lane.
+                    // Their compartments are then integrated in a part of each instance, before the part that solves the group.
+                    cabl_def.Hines_Lanes = config.hines_lanes;
+                    printf("Solving the cable equations of %s in groups of up to %lld instances\n", sig.name.c_str(), config.hines_lanes);
+                }
+            }
             // bool postupdate_inside_cell = false; // LATER
 
             // cell analysis complete
@@ -3062,11 +3615,51 @@ bool GenerateModel(const Model &model, const SimulatorConfig &config, EngineConf
 
             // now on to parts of the physical cell
 
+            cell_type_analysis_sec = cell_type_timer.delta();
+            cell_type_timer = Timer();
             printf("Generating code for %s...:\n", sig.name.c_str());
             char tmps[10000]; // buffer for a single code line
 
             EmitKernelFileHeader( sig.code );
+            if( cell_cable_solver == SimulatorConfig::CABLE_BWD_EULER_HINES || cell_cable_solver == SimulatorConfig::CABLE_CRANK_NICOLSON ){
+                // the precomputed cable solver, shared by all instances
+                const auto &cabl_def = pig.cable_solver;
+                auto EmitArray = [ &sig, &tmps ]( const char *type, const char *name, const auto &values ){
+                    sig.code += std::string("static DEVICE_FUNC const ")+type+" "+name+"["+std::to_string(values.size())+"] = {";
+                    for( size_t i = 0; i < values.size(); i++ ){
+                        if( i % 8 == 0 ) sig.code += "\n   ";
+                        sprintf(tmps, " %.9g%s", (double) values[i], ( i + 1 < values.size() ) ? "," : ""); sig.code += tmps;
+                    }
+                    sig.code += "\n};\n";
+                };
+                EmitArray( "int", "Hines_Order", cabl_def.Hines_OrderList );
+                EmitArray( "int", "Hines_Parent", cabl_def.Hines_ParentList );
+                EmitArray( "float", "Hines_Upper", cabl_def.Hines_Upper );
+                EmitArray( "float", "Hines_Lower", cabl_def.Hines_Lower );
+                EmitArray( "float", "Hines_InvDiagonal", cabl_def.Hines_InvDiagonal );
+                if( cell_cable_solver == SimulatorConfig::CABLE_CRANK_NICOLSON ) EmitArray( "float", "Hines_Coupling", cabl_def.Hines_ParentCoupling );
+                if( !cabl_def.Hines_RangeTop.empty() ){
+                    EmitArray( "int", "Hines_RangeStart", cabl_def.Hines_RangeStart );
+                    EmitArray( "int", "Hines_RangeTop", cabl_def.Hines_RangeTop );
+                    EmitArray( "int", "Hines_RangeEntry", cabl_def.Hines_RangeEntry );
+                    EmitArray( "int", "Hines_RangeOf", cabl_def.Hines_RangeOf );
+                    EmitArray( "int", "Hines_Interface", cabl_def.Hines_Interface );
+                    EmitArray( "float", "Hines_EntryGain", cabl_def.Hines_EntryGain );
+                    EmitArray( "float", "Hines_TopGain", cabl_def.Hines_TopGain );
+                }
+            }
+            // tables of rates for HH gates go here, once the gates are known
+            const size_t rate_tables_position = sig.code.size();
+            struct{
+                std::string code;
+                std::map< std::string, std::string > names; // by formula
+                long long points;
+                float max_error, max_relative_error;
+            } rate_tables = { "", {}, (long long) std::ceil( ( config.rate_table_max - config.rate_table_min ) / config.rate_table_step ) + 1, 0, 0 };
             EmitWorkItemRoutineHeader( sig.code );
+            // the parts of a split cell start the same way, and follow the cell's own kernel
+            const size_t part_prologue_start = sig.code.size();
+            std::string parts_code;
 
 
             const std::string tab = "\t";
@@ -3120,7 +3713,7 @@ bool GenerateModel(const Model &model, const SimulatorConfig &config, EngineConf
                     &config,
                     &model, &ion_channels, &conc_models, &ion_species, &dimensions, &component_types, &microns,
                     &ImplementSynapseType, &ImplementInputSource,
-                    &engine_config
+                    &engine_config, &rate_tables
             ](
                     const SignatureAppender_Single &AppendSingle, const SignatureAppender_Table &AppendMulti,
                     const InlineLems_AllocatorCoder &DescribeLemsInline,
@@ -3467,6 +4060,44 @@ bool GenerateModel(const Model &model, const SimulatorConfig &config, EngineConf
                                 }
                             }
                         };
+                        // Tabulate a voltage-dependent rate over the voltage grid, if not already done for this cell type, and return the name of the table.
+                        // Also track how far linear interpolation can be from the exact rate, between the grid points.
+                        auto RateTableName = [&]( const IonChannel::Rate &rate, const std::string &for_what ){
+                            char tmps[200];
+                            sprintf(tmps, "%d %.17g %.17g %.17g", (int) rate.type, rate.formula.rate, rate.formula.midpoint, rate.formula.scale);
+                            auto it = rate_tables.names.find(tmps);
+                            if( it != rate_tables.names.end() ) return it->second;
+
+                            const std::string name = "RateTable_" + itos(rate_tables.names.size());
+                            rate_tables.names[tmps] = name;
+                            const float vstep = config.rate_table_step;
+                            const long long points = rate_tables.points;
+                            std::vector<float> values( points );
+                            for( long long i = 0; i < points; i++ ) values[i] = DescribeRateThing::Value( config.rate_table_min + i * vstep, rate );
+
+                            float max_value = 0, max_error = 0;
+                            for( float value : values ) max_value = std::max( max_value, std::fabs( value ) );
+                            const int SUBPOINTS = 4;
+                            for( long long i = 0; i + 1 < points; i++ ){
+                                for( int sub = 1; sub < SUBPOINTS; sub++ ){
+                                    float frac = sub / (float) SUBPOINTS;
+                                    float interpolated = values[i] + frac * ( values[i+1] - values[i] );
+                                    float exact = DescribeRateThing::Value( config.rate_table_min + ( i + frac ) * vstep, rate );
+                                    max_error = std::max( max_error, std::fabs( interpolated - exact ) );
+                                }
+                            }
+                            rate_tables.max_error = std::max( rate_tables.max_error, max_error );
+                            if( max_value > 0 ) rate_tables.max_relative_error = std::max( rate_tables.max_relative_error, max_error / max_value );
+                            if( config.verbose ) printf("%s for %s: max. interpolation error %g, of max. value %g\n", name.c_str(), for_what.c_str(), max_error, max_value);
+
+                            rate_tables.code += "static DEVICE_FUNC const float "+name+"["+std::to_string(points)+"] = {";
+                            for( long long i = 0; i < points; i++ ){
+                                if( i % 8 == 0 ) rate_tables.code += "\n   ";
+                                sprintf(tmps, " %.9g%s", values[i], ( i + 1 < points ) ? "," : ""); rate_tables.code += tmps;
+                            }
+                            rate_tables.code += "\n};\n";
+                            return name;
+                        };
                         auto DescribeRate_Thing = [&]( const IonChannel::Rate &rate, const std::string &tab, const std::string &for_what, const char *thing_name,  CellInternalSignature::ComponentSubSignature &component ){
                             std::string rate_code;
                             char tmps[2000];
@@ -3479,12 +4110,24 @@ bool GenerateModel(const Model &model, const SimulatorConfig &config, EngineConf
                             }
                             else{
                                 // it is a built-in type
-                                sprintf(tmps, "%s = ", thing_name); rate_code += tab+tmps;
-                                if(
+                                const bool formula_rate = (
                                         rate.type == IonChannel::Rate::EXPONENTIAL
                                         || rate.type == IonChannel::Rate::EXPLINEAR
                                         || rate.type == IonChannel::Rate::SIGMOID
-                                        ){
+                                );
+                                // the formulas depend on voltage alone, so they can be looked up on a grid
+                                const bool use_rate_table = config.rate_tables && formula_rate;
+                                if( use_rate_table ){
+                                    // interpolate on the grid, and use the formula below only off the grid
+                                    const std::string table = RateTableName( rate, for_what );
+                                    sprintf(tmps, "{ const float Vtab = ( Vcomp - (%.9ef) ) * %.9ef;\n", config.rate_table_min, 1 / config.rate_table_step); rate_code += tab+tmps;
+                                    sprintf(tmps, "if( Vtab >= 0 && Vtab < %lld ){ const int i = (int) Vtab; %s = %s[i] + ( Vtab - i ) * ( %s[i+1] - %s[i] ); }\n", rate_tables.points - 1, thing_name, table.c_str(), table.c_str(), table.c_str()); rate_code += tab+tmps;
+                                    sprintf(tmps, "else %s = ", thing_name); rate_code += tab+tmps;
+                                }
+                                else{
+                                    sprintf(tmps, "%s = ", thing_name); rate_code += tab+tmps;
+                                }
+                                if( formula_rate ){
                                     std::size_t Index_Gate_BaseRate = AppendConstant(rate.formula.rate,     for_what + " Base" );
                                     std::size_t Index_Gate_Midpoint = AppendConstant(rate.formula.midpoint, for_what + " Mid" );
                                     std::size_t Index_Gate_Scale    = AppendConstant(rate.formula.scale,    for_what + " Scale");
@@ -3498,6 +4141,7 @@ bool GenerateModel(const Model &model, const SimulatorConfig &config, EngineConf
                                     else if(rate.type == IonChannel::Rate::SIGMOID){
                                         sprintf(tmps, "local_constants[%zd] / (1 + expf( (local_constants[%zd] - Vcomp ) / local_constants[%zd] ) );\n", Index_Gate_BaseRate, Index_Gate_Midpoint, Index_Gate_Scale); rate_code += tmps;
                                     }
+                                    if( use_rate_table ) rate_code += tab+"}\n";
                                 }
                                 else if( rate.type == IonChannel::Rate::FIXED ){
                                     std::size_t Index_Gate_Constant = AppendConstant(rate.formula.constant, for_what + " Fixed");
@@ -3558,7 +4202,7 @@ bool GenerateModel(const Model &model, const SimulatorConfig &config, EngineConf
                                     (( Scales<Time>::native ^ -1 ) * Scales<Time>::native ) // to unitless
                             );
 
-                            auto Update_TauInf_Inline = [ &TauInf_suffix ]( auto Index_Q, const std::string &tab){
+                            auto Update_TauInf_Inline = [ &TauInf_suffix, &config ]( auto Index_Q, const std::string &tab){
                                 std::string tauinf_code;
                                 char tmps[1000];
 
@@ -3566,7 +4210,13 @@ bool GenerateModel(const Model &model, const SimulatorConfig &config, EngineConf
                                 sprintf(tmps, "    local_stateNext[%ld] = inf;\n", Index_Q); tauinf_code += tab+tmps;
                                 tauinf_code +=   tab+"}else{\n";
                                 //sprintf(tmps, "    local_stateNext[%zd] = %s + dt * ( alpha * ( 1 - %s ) - beta * (%s) ) * q10 %s;\n", Index_Q, fana, fana, fana, Rate_suffix.c_str() ); ccde += tab+tmps;
-                                sprintf(tmps, "    local_stateNext[%ld] = local_state[%ld] + dt * ( ( inf - local_state[%ld] ) / tau ) * q10 %s;\n", Index_Q, Index_Q, Index_Q, TauInf_suffix.c_str() ); tauinf_code += tab+tmps;
+                                if( config.gate_solver == SimulatorConfig::GATE_EXP_EULER ){
+                                    // stable for any dt, and tau = 0 just sets the gate to inf
+                                    sprintf(tmps, "    local_stateNext[%ld] = inf + ( local_state[%ld] - inf ) * expf( - dt * q10 %s / tau );\n", Index_Q, Index_Q, TauInf_suffix.c_str() ); tauinf_code += tab+tmps;
+                                }
+                                else{
+                                    sprintf(tmps, "    local_stateNext[%ld] = local_state[%ld] + dt * ( ( inf - local_state[%ld] ) / tau ) * q10 %s;\n", Index_Q, Index_Q, Index_Q, TauInf_suffix.c_str() ); tauinf_code += tab+tmps;
+                                }
                                 tauinf_code +=   "        }\n";
 
                                 return tauinf_code;
@@ -4230,7 +4880,7 @@ bool GenerateModel(const Model &model, const SimulatorConfig &config, EngineConf
                         ionpool_code += lemscode;
 
                         // numerical integration code here
-                        std::string lemsupdate = DescribeLems::Update(&engine_config, comptype, model.dimensions, distimpl.component, &AppendSingle, for_what, tab, random_call_counter, config.debug );
+                        std::string lemsupdate = DescribeLems::Update(&engine_config, config, comptype, model.dimensions, distimpl.component, &AppendSingle, for_what, tab, random_call_counter, config.debug );
                         ionpool_code += lemsupdate;
 
                         ionpool_code += DescribeLems::Exposures(comptype, for_what, tab, config.debug);
@@ -4346,6 +4996,7 @@ bool GenerateModel(const Model &model, const SimulatorConfig &config, EngineConf
                     const std::string &for_what,
                     const std::string &tab,
                     const SimulatorConfig::CableEquationSolver &cell_cable_solver,
+                    const CellInternalSignature::PhysicalCell::CableSolverDefinition &cabl_def,
                     CellInternalSignature::PhysicalCell::CableSolverImplementation &cabl_impl,
                     std::string &code
             ){
@@ -4446,12 +5097,210 @@ bool GenerateModel(const Model &model, const SimulatorConfig &config, EngineConf
 
                     code += tab+"}\n";
                 }
+                else if( cell_cable_solver == SimulatorConfig::CABLE_BWD_EULER_HINES || cell_cable_solver == SimulatorConfig::CABLE_CRANK_NICOLSON ){
+                    // the factorization is the same for all instances of the cell type, in static arrays emitted with the kernel
+                    const bool crank_nicolson = ( cell_cable_solver == SimulatorConfig::CABLE_CRANK_NICOLSON );
+                    if( cabl_def.Hines_Lanes > 0 ){
+                        // the instance is solved with others, by the part of the group (see ImplementLaneGroupCableEq)
+                        return true;
+                    }
+                    // the scratchpad is in the state of each instance, since a cell may have too many compartments for the stack (or GPU thread)
+                    cabl_impl.Index_Hines_WorkVoltage = AppendMulti.StateVariable("Hines Voltage Scratchpad");
+                    if( !cabl_def.Hines_RangeTop.empty() ){
+                        // the cell is split into parts, and so is the solver (see ImplementSplitCableEqPart)
+                        cabl_impl.Index_Hines_RangeCarry = AppendMulti.StateVariable("Hines Range Carry");
+                        return true;
+                    }
+                    code += tab+"{\n";
+                    sprintf(tmps, "    const long long Compartments = %zd;\n", cabl_def.Hines_OrderList.size() ); code += tmps;
+                    sprintf(tmps, "    Table_F32 X = cell_state_table_f32_arrays[%zd];\n", cabl_impl.Index_Hines_WorkVoltage ); code += tmps;
+
+                    // gather the voltages after internal currents, in elimination order
+                    code += tab+"for( long long k = 0; k < Compartments; k++ ) X[k] = V_next[ Hines_Order[k] ];\n";
+                    if( crank_nicolson ){
+                        // explicit half of the axial currents, from the voltages at the start of the step
+                        code += tab+"for( long long k = 0; k < Compartments - 1; k++ ){\n";
+                        code += tab+"    long long p = Hines_Parent[k];\n";
+                        code += tab+"    float dV = V[ Hines_Order[p] ] - V[ Hines_Order[k] ];\n";
+                        code += tab+"    X[k] -= Hines_Upper[k] * dV;\n";
+                        code += tab+"    X[p] += Hines_Coupling[k] * dV;\n";
+                        code += tab+"}\n";
+                    }
+                    // the matrix is already factorized, what is left is to apply the elimination to the right-hand side and substitute back
+                    code += tab+"for( long long k = 0; k < Compartments - 1; k++ ) X[ Hines_Parent[k] ] -= Hines_Lower[k] * X[k];\n";
+                    code += tab+"X[ Compartments - 1 ] *= Hines_InvDiagonal[ Compartments - 1 ];\n";
+                    code += tab+"for( long long k = Compartments - 2; k >= 0; k-- ) X[k] = ( X[k] - Hines_Upper[k] * X[ Hines_Parent[k] ] ) * Hines_InvDiagonal[k];\n";
+                    code += tab+"for( long long k = 0; k < Compartments; k++ ) V_next[ Hines_Order[k] ] = X[k];\n";
+                    if( config.debug ){
+                        code += tab+"for( long long k = 0; k < Compartments; k++ ) printf(\"%lld %lld %g \\n\", k, (long long) Hines_Order[k], X[k]);\n";
+                    }
+                    code += tab+"}\n";
+                }
                 else{
                     // no post-internal solver needed
                 }
 
                 return true;
             };
+            // the part of the split Hines solver for a wave, for ranges [ first_range, end_range ) if it's one of the parallel waves
+            auto ImplementSplitCableEqPart = [ ](
+                    const std::string &tab,
+                    const SimulatorConfig::CableEquationSolver &cell_cable_solver,
+                    const CellInternalSignature::PhysicalCell::CableSolverDefinition &cabl_def,
+                    const CellInternalSignature::PhysicalCell::CableSolverImplementation &cabl_impl,
+                    int wave, Int first_range, Int end_range,
+                    std::string &code
+            ){
+                char tmps[2000];
+                const bool crank_nicolson = ( cell_cable_solver == SimulatorConfig::CABLE_CRANK_NICOLSON );
+                code += tab+"{\n";
+                sprintf(tmps, "    const long long Compartments = %zd;\n", cabl_def.Hines_OrderList.size() ); code += tmps;
+                sprintf(tmps, "    const int Interfaces = %zd;\n", cabl_def.Hines_Interface.size() ); code += tmps;
+                sprintf(tmps, "    Table_F32 X = cell_state_table_f32_arrays[%zd];\n", cabl_impl.Index_Hines_WorkVoltage ); code += tmps;
+                sprintf(tmps, "    Table_F32 Carry = cell_state_table_f32_arrays[%zd];\n", cabl_impl.Index_Hines_RangeCarry ); code += tmps;
+                const std::string for_ranges = tab+"for( int s = "+itos(first_range)+"; s < "+itos(end_range)+"; s++ ){\n"
+                    +tab+"    const long long start = Hines_RangeStart[s], top = Hines_RangeTop[s], entry = Hines_RangeEntry[s];\n";
+
+                if( wave == CellInternalSignature::WAVE_HINES_RANGES_FORWARD ){
+                    // gather the voltages after internal currents and eliminate within each range, as if the entry was 0
+                    code += for_ranges;
+                    code += tab+"    for( long long k = start; k <= top; k++ ) X[k] = V_next[ Hines_Order[k] ];\n";
+                    if( crank_nicolson ){
+                        // explicit half of the axial currents, for the positions in the range
+                        code += tab+"    for( long long k = start; k <= top; k++ ){\n";
+                        code += tab+"        long long p = Hines_Parent[k];\n";
+                        code += tab+"        float dV = V[ Hines_Order[p] ] - V[ Hines_Order[k] ];\n";
+                        code += tab+"        X[k] -= Hines_Upper[k] * dV;\n";
+                        code += tab+"        if( k < top ) X[p] += Hines_Coupling[k] * dV;\n";
+                        code += tab+"    }\n";
+                        code += tab+"    if( entry >= 0 ){\n";
+                        code += tab+"        long long p = Hines_Parent[entry];\n";
+                        code += tab+"        X[p] += Hines_Coupling[entry] * ( V[ Hines_Order[p] ] - V[ Hines_Order[entry] ] );\n";
+                        code += tab+"    }\n";
+                    }
+                    code += tab+"    for( long long k = start; k < top; k++ ) X[ Hines_Parent[k] ] -= Hines_Lower[k] * X[k];\n";
+                    code += tab+"}\n";
+                }
+                else if( wave == CellInternalSignature::WAVE_HINES_JUNCTIONS_FORWARD ){
+                    // gather the junctions
+                    code += tab+"for( int i = 0; i < Interfaces; i++ ){\n";
+                    code += tab+"    long long k = Hines_Interface[i];\n";
+                    code += tab+"    if( Hines_RangeOf[k] >= 0 ) continue;\n";
+                    code += tab+"    X[k] = V_next[ Hines_Order[k] ];\n";
+                    if( crank_nicolson ) code += tab+"    X[k] -= Hines_Upper[k] * ( V[ Hines_Order[ Hines_Parent[k] ] ] - V[ Hines_Order[k] ] );\n";
+                    code += tab+"}\n";
+                    code += tab+"X[ Compartments - 1 ] = V_next[ Hines_Order[ Compartments - 1 ] ];\n";
+                    // then go up, finishing the tops of the ranges with what their entries (which come first) pass on to them
+                    code += tab+"for( int i = 0; i < Interfaces; i++ ){\n";
+                    code += tab+"    long long k = Hines_Interface[i], p = Hines_Parent[k];\n";
+                    code += tab+"    int s = Hines_RangeOf[k];\n";
+                    code += tab+"    if( s >= 0 ){\n";
+                    code += tab+"        long long entry = Hines_RangeEntry[s];\n";
+                    code += tab+"        Carry[s] = ( entry >= 0 ) ? X[entry] : 0;\n";
+                    code += tab+"        X[k] += Hines_EntryGain[k] * Carry[s];\n";
+                    code += tab+"    }\n";
+                    // an entry is taken into its range through the gains instead
+                    code += tab+"    if( Hines_RangeOf[p] < 0 ){\n";
+                    if( crank_nicolson ) code += tab+"        X[p] += Hines_Coupling[k] * ( V[ Hines_Order[p] ] - V[ Hines_Order[k] ] );\n";
+                    code += tab+"        X[p] -= Hines_Lower[k] * X[k];\n";
+                    code += tab+"    }\n";
+                    code += tab+"}\n";
+                    code += tab+"X[ Compartments - 1 ] *= Hines_InvDiagonal[ Compartments - 1 ];\n";
+                }
+                else if( wave == CellInternalSignature::WAVE_HINES_RANGES_BACKWARD ){
+                    // finish elimination along the path from the entry, then substitute back as if the top's parent was 0
+                    code += for_ranges;
+                    code += tab+"    const float entry_value = Carry[s];\n";
+                    code += tab+"    for( long long k = start; k < top; k++ ) X[k] += Hines_EntryGain[k] * entry_value;\n";
+                    code += tab+"    X[top] *= Hines_InvDiagonal[top];\n";
+                    code += tab+"    for( long long k = top - 1; k >= start; k-- ) X[k] = ( X[k] - Hines_Upper[k] * X[ Hines_Parent[k] ] ) * Hines_InvDiagonal[k];\n";
+                    code += tab+"}\n";
+                }
+                else if( wave == CellInternalSignature::WAVE_HINES_JUNCTIONS_BACKWARD ){
+                    // go down, keeping the value of each top's parent for its range, and finishing the junctions
+                    code += tab+"V_next[ Hines_Order[ Compartments - 1 ] ] = X[ Compartments - 1 ];\n";
+                    code += tab+"for( int i = Interfaces - 1; i >= 0; i-- ){\n";
+                    code += tab+"    long long k = Hines_Interface[i], p = Hines_Parent[k];\n";
+                    code += tab+"    int s = Hines_RangeOf[k], sp = Hines_RangeOf[p];\n";
+                    code += tab+"    const float Xp = ( sp < 0 ) ? X[p] : X[p] + Hines_TopGain[p] * Carry[sp];\n";
+                    code += tab+"    if( s >= 0 ) Carry[s] = Xp;\n";
+                    code += tab+"    else{\n";
+                    code += tab+"        X[k] = ( X[k] - Hines_Upper[k] * Xp ) * Hines_InvDiagonal[k];\n";
+                    code += tab+"        V_next[ Hines_Order[k] ] = X[k];\n";
+                    code += tab+"    }\n";
+                    code += tab+"}\n";
+                }
+                else if( wave == CellInternalSignature::WAVE_HINES_RANGES_SCATTER ){
+                    code += for_ranges;
+                    code += tab+"    const float parent_value = Carry[s];\n";
+                    code += tab+"    for( long long k = start; k <= top; k++ ){\n";
+                    code += tab+"        X[k] += Hines_TopGain[k] * parent_value;\n";
+                    code += tab+"        V_next[ Hines_Order[k] ] = X[k];\n";
+                    code += tab+"    }\n";
+                    code += tab+"}\n";
+                }
+                code += tab+"}\n";
+                return true;
+            };
+            // the cable solver for a group of up to Hines_Lanes instances, that runs as a part of its own.
+            // The group part has one const i64 table, with where the voltages of each instance are in the flat state,
+            // and one state f32 table, the scratchpad of all instances with position k of instance l at k * Lanes + l.
+            // The instances past the end of a partial group are left at 0, which stays 0 through the elimination.
+            auto ImplementLaneGroupCableEq = [ ](
+                    const std::string &tab,
+                    const SimulatorConfig::CableEquationSolver &cell_cable_solver,
+                    const CellInternalSignature::PhysicalCell::CableSolverDefinition &cabl_def,
+                    std::string &code
+            ){
+                char tmps[2000];
+                const bool crank_nicolson = ( cell_cable_solver == SimulatorConfig::CABLE_CRANK_NICOLSON );
+                code += tab+"{\n";
+                sprintf(tmps, "    const long long Compartments = %zd;\n", cabl_def.Hines_OrderList.size() ); code += tmps;
+                sprintf(tmps, "    const int Lanes = %lld;\n", (long long) cabl_def.Hines_Lanes ); code += tmps;
+                code += tab+"const Table_I64 Lane_Voltages = global_const_table_i64_arrays[table_ci64_local_index];\n";
+                code += tab+"const long long Instances = global_const_table_i64_sizes[table_ci64_local_index];\n";
+                code += tab+"Table_F32 X = global_state_table_f32_arrays[table_sf32_local_index];\n";
+
+                // gather the voltages after internal currents, in elimination order
+                code += tab+"for( long long l = 0; l < Instances; l++ ){\n";
+                code += tab+"    const float *V_next = global_stateNext + Lane_Voltages[l];\n";
+                code += tab+"    for( long long k = 0; k < Compartments; k++ ) X[ k * Lanes + l ] = V_next[ Hines_Order[k] ];\n";
+                if( crank_nicolson ){
+                    code += tab+"    const float *V = global_state + Lane_Voltages[l];\n";
+                    code += tab+"    for( long long k = 0; k < Compartments - 1; k++ ){\n";
+                    code += tab+"        long long p = Hines_Parent[k];\n";
+                    code += tab+"        float dV = V[ Hines_Order[p] ] - V[ Hines_Order[k] ];\n";
+                    code += tab+"        X[ k * Lanes + l ] -= Hines_Upper[k] * dV;\n";
+                    code += tab+"        X[ p * Lanes + l ] += Hines_Coupling[k] * dV;\n";
+                    code += tab+"    }\n";
+                }
+                code += tab+"}\n";
+                // then eliminate and substitute back for all lanes together, in the inner loops
+                code += tab+"for( long long k = 0; k < Compartments - 1; k++ ){\n";
+                code += tab+"    const float *Xk = X + k * Lanes;\n";
+                code += tab+"    float *Xp = X + Hines_Parent[k] * Lanes;\n";
+                code += tab+"    const float lower = Hines_Lower[k];\n";
+                code += tab+"    for( int l = 0; l < Lanes; l++ ) Xp[l] -= lower * Xk[l];\n";
+                code += tab+"}\n";
+                code += tab+"{\n";
+                code += tab+"    float *Xr = X + ( Compartments - 1 ) * Lanes;\n";
+                code += tab+"    const float inv_diagonal = Hines_InvDiagonal[ Compartments - 1 ];\n";
+                code += tab+"    for( int l = 0; l < Lanes; l++ ) Xr[l] *= inv_diagonal;\n";
+                code += tab+"}\n";
+                code += tab+"for( long long k = Compartments - 2; k >= 0; k-- ){\n";
+                code += tab+"    float *Xk = X + k * Lanes;\n";
+                code += tab+"    const float *Xp = X + Hines_Parent[k] * Lanes;\n";
+                code += tab+"    const float upper = Hines_Upper[k], inv_diagonal = Hines_InvDiagonal[k];\n";
+                code += tab+"    for( int l = 0; l < Lanes; l++ ) Xk[l] = ( Xk[l] - upper * Xp[l] ) * inv_diagonal;\n";
+                code += tab+"}\n";
+                // and scatter the results back
+                code += tab+"for( long long l = 0; l < Instances; l++ ){\n";
+                code += tab+"    float *V_next = global_stateNext + Lane_Voltages[l];\n";
+                code += tab+"    for( long long k = 0; k < Compartments; k++ ) V_next[ Hines_Order[k] ] = X[ k * Lanes + l ];\n";
+                code += tab+"}\n";
+                code += tab+"}\n";
+                return true;
+            };
             // lastly, add post-integration event handlers
             auto AllocateCreatePostIntegrationCode = [ &config, &ImplementSpikeSender, &cell_seq ](
                     const SignatureAppender_Table &AppendMulti,
@@ -4487,6 +5336,8 @@ bool GenerateModel(const Model &model, const SimulatorConfig &config, EngineConf
             };
 
             auto &compartment_grouping = pig.compartment_grouping = CellInternalSignature::CompartmentGrouping::AUTO;
+            // the parts of a split cell (or of one solved with others) are made from the loops over grouped compartments
+            if( pig.split_into_parts || pig.cable_solver.Hines_Lanes > 0 ) compartment_grouping = CellInternalSignature::CompartmentGrouping::GROUPED;
             if( compartment_grouping == CellInternalSignature::CompartmentGrouping::AUTO ){
                 // TODO more sophisticated analysis, cmd line/config options, etc etc.
                 if( segment_compartments.size() <= 10 ) compartment_grouping = CellInternalSignature::CompartmentGrouping::FLAT;
@@ -4524,7 +5375,7 @@ bool GenerateModel(const Model &model, const SimulatorConfig &config, EngineConf
                 std::string cable_solver_code;
                 if( !ImplementPostInternalCableEqIntegration(
                         AppendMulti_CellScope, "", tab, cell_cable_solver,
-                        pig.cable_solver_implementation, cable_solver_code
+                        pig.cable_solver, pig.cable_solver_implementation, cable_solver_code
                 ) ) return false;
                 sig.code += cable_solver_code;
 
@@ -4563,7 +5414,7 @@ bool GenerateModel(const Model &model, const SimulatorConfig &config, EngineConf
                 // isolate/generate the per-compartment code block, to group identical ones
                 auto AllocateCreateFullSegmentCode = [
                         &ImplementInternalCompartmentIntegration, &AllocateCreatePostIntegrationCode,
-                        &model, &cell_cable_solver, &bioph, &engine_config
+                        &model, &cell_cable_solver, &bioph, &engine_config, &config
                 ](
                         size_t comp_seq,
                         const std::string &for_what,
@@ -4577,7 +5428,7 @@ bool GenerateModel(const Model &model, const SimulatorConfig &config, EngineConf
                     SignatureAppender_Single AppendSingle_CompScope( wig );
                     SignatureAppender_Table AppendMulti_CompScope( wig );
 
-                    InlineLems_AllocatorCoder DescribeLemsInline_CompScope(engine_config, model, wig.random_call_counter, AppendSingle_CompScope, AppendMulti_CompScope );
+                    InlineLems_AllocatorCoder DescribeLemsInline_CompScope(engine_config, config, model, wig.random_call_counter, AppendSingle_CompScope, AppendMulti_CompScope );
 
                     if( !ImplementInternalCompartmentIntegration(
                             AppendSingle_CompScope, AppendMulti_CompScope, DescribeLemsInline_CompScope,
@@ -4651,6 +5502,7 @@ bool GenerateModel(const Model &model, const SimulatorConfig &config, EngineConf
                 sig.code +=    tab+"const Table_I64 Comp_CI64off = cell_const_table_i64_arrays["+itos( gp.Index_CI64off )+"];\n";
                 sig.code +=    tab+"const Table_I64 Comp_SI64off = cell_const_table_i64_arrays["+itos( gp.Index_SI64off )+"];\n";
                 sig.code +=    tab+"const Table_I64 Comp_Roff    = cell_const_table_i64_arrays["+itos( gp.Index_Roff    )+"];\n";
+                const std::string part_prologue = sig.code.substr( part_prologue_start );
 
                 gp.preupdate_codes.resize ( gp.distinct_compartment_types.size() );
                 gp.postupdate_codes.resize( gp.distinct_compartment_types.size() );
@@ -4660,7 +5512,8 @@ bool GenerateModel(const Model &model, const SimulatorConfig &config, EngineConf
                 auto LoopOverCompartmentsCode = [ & ](
                         size_t comptype_seq,
                         std::string inner_code,
-                        std::string &ctde
+                        std::string &ctde,
+                        long long first_compartment = 0, long long end_compartment = -1 // of this type, for a part of a split cell
                 ){
                     // interlace it with compartment's tables, why not
                     const auto Index_List = gp.Index_CompList[ comptype_seq ];
@@ -4671,7 +5524,12 @@ bool GenerateModel(const Model &model, const SimulatorConfig &config, EngineConf
                     ctde +=    tab+"const Table_I64 Comp_List    = cell_const_table_i64_arrays["+itos( Index_List    )+"];\n";
                     ctde +=    tab+"const long long Type_Compartments    = cell_const_table_i64_sizes ["+itos( Index_List    )+"];\n";
 
-                    ctde +=    tab+"for( long long CompIdx = 0; CompIdx < Type_Compartments; CompIdx++ ){\n";
+                    if( end_compartment < 0 ){
+                        ctde +=    tab+"for( long long CompIdx = 0; CompIdx < Type_Compartments; CompIdx++ ){\n";
+                    }
+                    else{
+                        ctde +=    tab+"for( long long CompIdx = "+itos(first_compartment)+"; CompIdx < "+itos(end_compartment)+"; CompIdx++ ){\n";
+                    }
 
                     ctde +=    tab+"    int comp = (int) Comp_List[CompIdx];\n";
 
@@ -4792,20 +5650,79 @@ bool GenerateModel(const Model &model, const SimulatorConfig &config, EngineConf
                 }
 
                 // and append the internal dynamics codes
+                // (each compartment only writes to its own state, so a split cell can have them in parts of any size)
+                auto AddSplitPart = [ &sig, &part_prologue, &EmitWorkItemRoutineHeader, &EmitWorkItemRoutineFooter, &parts_code ]( int wave, const std::string &code ){
+                    CellInternalSignature::WorkItemPart part;
+                    part.kernel_name = "doit_part_"+itos( sig.split_parts.size() );
+                    part.wave = wave;
+                    part.callback = NULL;
+                    part.per_lane_group = false;
+                    sig.split_parts.push_back( part );
+
+                    EmitWorkItemRoutineHeader( parts_code, part.kernel_name );
+                    parts_code += part_prologue;
+                    parts_code += code;
+                    EmitWorkItemRoutineFooter( parts_code );
+                };
+                const bool solved_in_lanes = ( pig.cable_solver.Hines_Lanes > 0 );
+                std::string lanes_compartments_code; // all in one part, if the cell is solved with others
                 for( size_t comptype_seq = 0; comptype_seq < gp.distinct_compartment_types.size(); comptype_seq++ ){
 
+                    if( pig.split_into_parts ){
+                        const long long type_compartments = gp.distinct_compartment_types[comptype_seq].Count();
+                        for( long long first = 0; first < type_compartments; first += config.split_cells_compartments ){
+                            std::string comptype_inner_code;
+                            if( !LoopOverCompartmentsCode( comptype_seq, gp.preupdate_codes[comptype_seq], comptype_inner_code,
+                                first, std::min( type_compartments, first + config.split_cells_compartments ) ) ) return false;
+                            AddSplitPart( CellInternalSignature::WAVE_COMPARTMENTS, comptype_inner_code );
+                        }
+                        continue;
+                    }
+
                     std::string comptype_inner_code;
                     if( !LoopOverCompartmentsCode( comptype_seq, gp.preupdate_codes[comptype_seq], comptype_inner_code ) ) return false;
 
-                    sig.code += comptype_inner_code;
+                    if( solved_in_lanes ) lanes_compartments_code += comptype_inner_code;
+                    else sig.code += comptype_inner_code;
                 }
+                if( solved_in_lanes ) AddSplitPart( CellInternalSignature::WAVE_COMPARTMENTS, lanes_compartments_code );
                 // and the cable solver, if it's a separate step
                 std::string cable_solver_code;
                 if( !ImplementPostInternalCableEqIntegration(
                         AppendMulti_CellScope, "", tab, cell_cable_solver,
-                        pig.cable_solver_implementation, cable_solver_code
+                        pig.cable_solver, pig.cable_solver_implementation, cable_solver_code
                 ) ) return false;
                 sig.code += cable_solver_code;
+                if( !pig.cable_solver.Hines_RangeTop.empty() ){
+                    // or the parts of it, if the cell is split
+                    const auto &cabl_def = pig.cable_solver;
+                    for( int wave = CellInternalSignature::WAVE_HINES_RANGES_FORWARD; wave <= CellInternalSignature::WAVE_HINES_RANGES_SCATTER; wave++ ){
+                        const bool over_ranges = !( wave == CellInternalSignature::WAVE_HINES_JUNCTIONS_FORWARD || wave == CellInternalSignature::WAVE_HINES_JUNCTIONS_BACKWARD );
+                        const size_t parts = over_ranges ? cabl_def.Hines_PartRanges.size() - 1 : 1;
+                        for( size_t part_seq = 0; part_seq < parts; part_seq++ ){
+                            std::string part_code;
+                            if( !ImplementSplitCableEqPart(
+                                    tab, cell_cable_solver, cabl_def, pig.cable_solver_implementation, wave,
+                                    cabl_def.Hines_PartRanges[part_seq], cabl_def.Hines_PartRanges[part_seq + 1],
+                                    part_code
+                            ) ) return false;
+                            AddSplitPart( wave, part_code );
+                        }
+                    }
+                }
+                if( solved_in_lanes ){
+                    // or the part of the group, which does not run on the tables of the cell
+                    CellInternalSignature::WorkItemPart part;
+                    part.kernel_name = "doit_part_"+itos( sig.split_parts.size() );
+                    part.wave = CellInternalSignature::WAVE_HINES_LANES;
+                    part.callback = NULL;
+                    part.per_lane_group = true;
+                    sig.split_parts.push_back( part );
+
+                    EmitWorkItemRoutineHeader( parts_code, part.kernel_name );
+                    if( !ImplementLaneGroupCableEq( tab, cell_cable_solver, pig.cable_solver, parts_code ) ) return false;
+                    EmitWorkItemRoutineFooter( parts_code );
+                }
 
                 // and finally the postupdate codes
                 for( size_t comptype_seq = 0; comptype_seq < gp.distinct_compartment_types.size(); comptype_seq++ ){
@@ -4824,7 +5741,13 @@ bool GenerateModel(const Model &model, const SimulatorConfig &config, EngineConf
                 printf("internal error: unknown compartment grouping %d for cell type %d", (int) compartment_grouping, (int) cell_seq);
                 return false;
             }
+            if( !rate_tables.names.empty() ){
+                sig.code.insert( rate_tables_position, rate_tables.code );
+                printf("Tabulated %zd HH gate rates for %s; max. interpolation error %g (%g of max. rate)\n",
+                    rate_tables.names.size(), sig.name.c_str(), rate_tables.max_error, rate_tables.max_relative_error);
+            }
             EmitWorkItemRoutineFooter( sig.code );
+            sig.code += parts_code;
             EmitKernelFileFooter( sig.code );
             // done with code generation for this work item
 
@@ -4844,6 +5767,8 @@ bool GenerateModel(const Model &model, const SimulatorConfig &config, EngineConf
             auto &AppendMulti  = AppendMulti_CellScope;
             auto &DescribeLemsInline  = DescribeLemsInline_CellScope;
 
+            cell_type_analysis_sec = cell_type_timer.delta();
+            cell_type_timer = Timer();
             printf("Generating code for %s...:\n", sig.name.c_str());
 
             EmitKernelFileHeader( sig.code );
@@ -5064,7 +5989,7 @@ bool GenerateModel(const Model &model, const SimulatorConfig &config, EngineConf
 
                     // also add integration code here, to finish with component code (and get event outputs !)
                     ccde += tab+"// integrate inline\n";
-                    std::string lemsupdate = DescribeLems::Update(&engine_config, comptype, model.dimensions, component, &AppendSingle, for_what, tab, cell_wig.random_call_counter, config.debug && 0 );
+                    std::string lemsupdate = DescribeLems::Update(&engine_config, config, comptype, model.dimensions, component, &AppendSingle, for_what, tab, cell_wig.random_call_counter, config.debug && 0 );
                     ccde += lemsupdate;
 
                     ccde += tab+"// expose inline\n";
@@ -5143,6 +6068,11 @@ bool GenerateModel(const Model &model, const SimulatorConfig &config, EngineConf
             PrintWorkItemSignature(sig.cell_wig);
         }
 
+        // NB: the names in the model can't be used, they point into the NeuroML files that are unloaded by now
+        const std::string cell_type_phase = "model: " + sig.name;
+        startup_phases.Add( cell_type_phase + ": analysis", cell_type_analysis_sec, 1 );
+        startup_phases.Add( cell_type_phase + ": code", cell_type_timer.delta(), 1 );
+
         // output model code for all present cells TODO
         std::string code_id = sig.name + "_code";
         std::string code_filename, dll_filename;
@@ -5154,204 +6084,225 @@ bool GenerateModel(const Model &model, const SimulatorConfig &config, EngineConf
             dll_filename = code_id+ ".gen.so";
         }
 
-        FILE *fout = fopen(code_filename.c_str(), "w");
-        if(!fout){
-            perror(code_filename.c_str());
-            return false;
-        }
-        if( !fprintf(fout, "%s", sig.code.c_str() ) ){
-            perror(code_filename.c_str());
-            return false;
+#ifdef USE_MPI
+        if (engine_config.use_mpi) {
+            // all nodes generate the same code, build it just once for all of them when all cell types are done
+            kernels_to_share.push_back( { cell_sigs.size(), code_filename, dll_filename } );
+            cell_sigs.push_back(sig);
+            continue;
         }
-        fclose(fout);
+#endif
 
         // build the code
         timeval compile_start, compile_end;
         gettimeofday(&compile_start, NULL);
 
-        std::string basic_flags =
-                " -std=c11 -Wall"
-                " -Wno-attributes"
-                " -Wno-unused-variable -Wno-unused-but-set-variable -Wno-unused-function";
-        std::string dll_flags = " -shared -fpic"; //" -shared -fpic -nodefaultlibs";
-        std::string optimization_flags = " -Ofast -mcpu=native -mtune=native";
-        std::string fastbuild_flags = " -O0";
-        std::string asm_flags = " -S -masm=intel -fverbose-asm";
-        std::string lm_flags = " -lm";
-        if(config.use_icc){
-            lm_flags = " -limf"; // TODO check if SVML should be added here too
-        }
-        if( !config.use_icc && config.tweak_lmvec ){
-            // some GCC(glibc?) versions need this for vectorization https://sourceware.org/bugzilla/show_bug.cgi?id=20539
-            // also, mvec must be linked first: https://sourceware.org/glibc/wiki/libmvec
-            lm_flags = " -lmvec -lm" ; // XXX must revert automatically, if compiler is old enough
-        }
-        // TODO extra_flags, vec_report etc.
+        Timer build_timer;
+        if( !BuildKernel( sig.code, code_filename, dll_filename ) ) return false;
+        startup_phases.Add( cell_type_phase + ": compile", build_timer.delta(), 1 );
 
-        std::string compiler_name;
+        Timer load_timer;
+        if( !LoadCellKernels( LocalDllPath( dll_filename ), sig ) ) return false;
+        startup_phases.Add( cell_type_phase + ": load", load_timer.delta(), 1 );
 
-        if (engine_config.backend == backend_kind_gpu) {
-            if(config.use_icc) {
-                fprintf(stderr, "Error can't use icc to compile CUDA kernels");
-                return false;
-            }
-            compiler_name = "nvcc";
-            basic_flags = "-std=c++11 -lm -Xcompiler -Wall,-Wno-attributes,-Wno-unused-variable,-Wno-unused-but-set-variable,-Wno-unused-function -Xcudafe --diag_suppress=177";
-            if (config.debug_gpu_kernels) {
-                basic_flags += " -g -G";
-            }
-            if (engine_config.trove) {
-                basic_flags += " -Ithirdparty";
-            }
-            dll_flags = " -Xcompiler -fPIC -shared";
-            optimization_flags = "";
-            fastbuild_flags = "";
-        } else {
-            if(config.use_icc){
-                compiler_name = "icc";
-            } else {
-                compiler_name = "gcc";
-            }
-        }
-
-        std::string code_quality_flags = optimization_flags;
-
-        // don't bother with optimization if code is massive
-        if( sig.code.size() > 1024 * 1024LL ){
-            printf("Choosing fast build due to code size..\n");
-            code_quality_flags = fastbuild_flags;
-        }
+        gettimeofday(&compile_end, NULL);
+        printf("Compiled and loaded %s in %.2lf seconds\n", code_id.c_str(), TimevalDeltaSec(compile_start, compile_end));
 
-        // Check if compiler is present
-        // TODO XXX hoist this check higher up, to avoid overhead !
-        // TODO more branching to pick the method to check presence LATER, for more compilers
-        if( system((compiler_name + " --version").c_str()) != 0 ){
-            std::string complaint_line = "Could not invoke '"+compiler_name+"' compiler! Make sure it is installed, and available on PATH.";
 
-            std::string more_commentary;
-            // maybe mention that gcc is the default (or auto selected) LATER
+        cell_sigs.push_back(sig);
+    }
+    // LATER further specialize cell types with synapse and input components INSIDE the per-cell code block, for better legibility, but how?
 
-            // Give some instructions to the astonished user, though the most complete instructions should really be in the manual (when that is written)
-            if(config.use_icc){
-                more_commentary = "Check the instructions on how to set up ICC at Intel's website:\n"
-                                  "https://software.intel.com/content/www/us/en/develop/articles/intel-system-studio-download-and-install-intel-c-compiler.html"
-                                  "\nand on setting PATH:\n"
-                                  "https://software.intel.com/content/www/us/en/develop/documentation/cpp-compiler-developer-guide-and-reference/top/compiler-setup/using-the-command-line/specifying-the-location-of-compiler-components.html";
+#ifdef USE_MPI
+    // Now build the kernels once for the whole job: each distinct kernel is compiled on one node, broadcast as a binary,
+    // and loaded by the nodes from a node-local directory (to not stress or race on a shared file system)
+    // NB: this assumes a homogeneous cluster, same as the rest of the MPI setup
+    if( engine_config.use_mpi && !kernels_to_share.empty() ){
+        timeval share_start, share_end;
+        gettimeofday(&share_start, NULL);
+
+        const int my_rank = engine_config.my_mpi.rank;
+        const int world_size = engine_config.my_mpi.world_size;
+
+        // a plain FNV-1a hash is enough to check that all nodes generated the same code
+        auto HashCode = []( const std::string &code ){
+            unsigned long long hash = 14695981039346656037ULL;
+            for( unsigned char c : code ){
+                hash ^= c;
+                hash *= 1099511628211ULL;
+            }
+            return hash;
+        };
+        std::vector<unsigned long long> code_hashes, code_hashes_min, code_hashes_max;
+        for( const auto &kernel : kernels_to_share ) code_hashes.push_back( HashCode( cell_sigs[kernel.sig_seq].code ) );
+        code_hashes_min.resize( code_hashes.size() );
+        code_hashes_max.resize( code_hashes.size() );
+        MPI_Allreduce( code_hashes.data(), code_hashes_min.data(), (int)code_hashes.size(), MPI_UNSIGNED_LONG_LONG, MPI_MIN, MPI_COMM_WORLD );
+        MPI_Allreduce( code_hashes.data(), code_hashes_max.data(), (int)code_hashes.size(), MPI_UNSIGNED_LONG_LONG, MPI_MAX, MPI_COMM_WORLD );
+
+        if( code_hashes_min != code_hashes_max ){
+            // should not happen, unless code generation depends on the node somehow
+            // then just build on every node, with separate file names
+            printf("Generated code differs across nodes, building kernels on each node\n");
+            bool build_ok = true;
+            for( const auto &kernel : kernels_to_share ){
+                auto &sig = cell_sigs[kernel.sig_seq];
+                std::string rank_suffix = "_rank_"+itos(my_rank);
+                std::string code_id = sig.name + rank_suffix + "_code";
+                std::string code_filename = sig.name + rank_suffix + kernel.code_filename.substr( sig.name.size() );
+                std::string dll_filename  = sig.name + rank_suffix + kernel.dll_filename .substr( sig.name.size() );
+
+                if( !BuildKernel( sig.code, code_filename, dll_filename ) || !LoadCellKernels( LocalDllPath( dll_filename ), sig ) ){
+                    build_ok = false;
+                    break;
+                }
+                printf("Compiled and loaded %s\n", code_id.c_str());
             }
-            else{
-                // gcc by default
-#if defined _WIN32
-                more_commentary = "If a compiler is not already installed, a build for GCC on Windows can be downloaded from:\n";
-
-                #if INTPTR_MAX == INT32_MAX
-                more_commentary += "https://sourceforge.net/projects/mingw-w64/files/Toolchains%20targetting%20Win32/Personal%20Builds/mingw-builds/8.1.0/threads-posix/sjlj/i686-8.1.0-release-posix-sjlj-rt_v6-rev0.7z";
-                #elif INTPTR_MAX == INT64_MAX
-                more_commentary += "https://sourceforge.net/projects/mingw-w64/files/Toolchains%20targetting%20Wing4/Personal%20Builds/mingw-builds/8.1.0/threads-posix/seh/x86_64-8.1.0-release-posix-seh-rt_v6-rev0.7z";
-                #endif
-                // but still may have to detect non-PC architecture ... LATER
 
-                more_commentary += "\nUnpack the file anywhere, and add the unpacked <path ...>\\bin directory to EDEN's PATH.";
-#elif defined __linux__
-                more_commentary = "GCC is usually already installed on Linux setups. It if is not installed, refer to your distribution's documentation on how to install the essentials for building from source.";
-#elif defined(__APPLE__)
-                more_commentary = "A GCC-compatible compiler cn be installed with the Command Line Developer Tools for Mac. Run the following command on the Terminal to install:\n";
-                more_commentary += "xcode-select --install\n\n";
-                more_commentary += "Alternatively, the compiler used by default, GCC, can be installed through Homebrew for Mac OS X:\n";
-                more_commentary += "brew install gcc";
-                more_commentary += "\nRefer to http://brew.sh on how to set up Homebrew. (It may already be installed, in order to install Python 3.)";
-                #else
+            // bail out together, rather than leaving the other nodes hanging
+            int all_build_ok = build_ok;
+            MPI_Allreduce( MPI_IN_PLACE, &all_build_ok, 1, MPI_INT, MPI_LAND, MPI_COMM_WORLD );
+            if( !all_build_ok ) return false;
+        }
+        else{
+            // identical kernels (eg. for cells that differ only in name) are built only once
+            std::vector<size_t> distinct_kernels; // index in kernels_to_share
+            std::vector<size_t> kernel_to_distinct; // for each of kernels_to_share
+            for( size_t i = 0; i < kernels_to_share.size(); i++ ){
+                size_t d = 0;
+                for( ; d < distinct_kernels.size(); d++ ){
+                    const size_t other = distinct_kernels[d];
+                    if( code_hashes[other] == code_hashes[i] && cell_sigs[kernels_to_share[other].sig_seq].code == cell_sigs[kernels_to_share[i].sig_seq].code ) break;
+                }
+                if( d == distinct_kernels.size() ) distinct_kernels.push_back(i);
+                kernel_to_distinct.push_back(d);
+            }
+
+            // spread the building over the nodes, so the compiler runs in parallel
+            auto BuilderOf = [ world_size ]( size_t distinct_seq ){ return (int)( distinct_seq % world_size ); };
+            std::vector< std::vector<char> > dll_contents( distinct_kernels.size() );
+            std::vector< bool > build_ok( distinct_kernels.size(), true );
+            for( size_t d = 0; d < distinct_kernels.size(); d++ ){
+                if( BuilderOf(d) != my_rank ) continue;
+                const auto &kernel = kernels_to_share[ distinct_kernels[d] ];
+
+                build_ok[d] = BuildKernel( cell_sigs[kernel.sig_seq].code, kernel.code_filename, kernel.dll_filename );
+                if( !build_ok[d] ) continue;
+
+                FILE *fin = fopen( kernel.dll_filename.c_str(), "rb" );
+                if( !fin ){
+                    perror( kernel.dll_filename.c_str() );
+                    build_ok[d] = false;
+                    continue;
+                }
+                char buf[65536];
+                size_t nread;
+                while( ( nread = fread( buf, 1, sizeof(buf), fin ) ) > 0 ){
+                    dll_contents[d].insert( dll_contents[d].end(), buf, buf + nread );
+                }
+                fclose(fin);
+            }
+
+            // one node-local directory for the binaries, handled by one rank per node
+            MPI_Comm node_comm;
+            MPI_Comm_split_type( MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, my_rank, MPI_INFO_NULL, &node_comm );
+            int node_rank;
+            MPI_Comm_rank( node_comm, &node_rank );
+            long long node_leader_ids[2] = { my_rank, (long long) getpid() };
+            MPI_Bcast( node_leader_ids, 2, MPI_LONG_LONG, 0, node_comm );
+
+            std::string kernel_dir;
+            {
+                const char *tmpdir = getenv("TMPDIR");
+                kernel_dir = ( tmpdir && *tmpdir ) ? tmpdir : "/tmp";
+                kernel_dir += "/eden_kernels_"+itos(node_leader_ids[1])+"_"+itos(node_leader_ids[0]);
+            }
+            bool dir_ok = true;
+            if( node_rank == 0 ){
+                if( mkdir( kernel_dir.c_str(), 0700 ) != 0 ){
+                    perror( kernel_dir.c_str() );
+                    dir_ok = false;
+                }
+            }
+
+            bool share_ok = true;
+            std::vector<std::string> kernel_paths( distinct_kernels.size() );
+            for( size_t d = 0; d < distinct_kernels.size(); d++ ){
+                const auto &kernel = kernels_to_share[ distinct_kernels[d] ];
+                const int builder = BuilderOf(d);
+
+                // size -1 means the build failed, then all nodes must bail out together
+                long long dll_size = build_ok[d] ? (long long) dll_contents[d].size() : -1;
+                MPI_Bcast( &dll_size, 1, MPI_LONG_LONG, builder, MPI_COMM_WORLD );
+                if( dll_size < 0 ){
+                    if( my_rank == 0 ) fprintf(stderr, "Could not build %s on node %d\n", kernel.dll_filename.c_str(), builder);
+                    share_ok = false;
+                    break;
+                }
+                dll_contents[d].resize( dll_size );
+                // NB: size is limited to INT_MAX for a single broadcast, that is plenty for a kernel
+                MPI_Bcast( dll_contents[d].data(), (int) dll_size, MPI_BYTE, builder, MPI_COMM_WORLD );
 
-#endif
+                kernel_paths[d] = kernel_dir + "/" + kernel.dll_filename;
+                if( node_rank == 0 && dir_ok ){
+                    FILE *fout = fopen( kernel_paths[d].c_str(), "wb" );
+                    if( !fout ){
+                        perror( kernel_paths[d].c_str() );
+                        dir_ok = false;
+                        continue;
+                    }
+                    if( fwrite( dll_contents[d].data(), 1, dll_contents[d].size(), fout ) != dll_contents[d].size() ){
+                        perror( kernel_paths[d].c_str() );
+                        dir_ok = false;
+                    }
+                    fclose(fout);
+                }
+                dll_contents[d].clear();
+                dll_contents[d].shrink_to_fit();
             }
-            // also note ways to set path
-#if defined _WIN32
-            more_commentary += "If using the command line, PATH can be set as follows:\n"
-            "path <path to compiler executable>;%PATH%\n"
-            "eden.exe ..."; // maybe argv[0], whatever
-#elif defined __linux__
-            more_commentary += "If using the command line, PATH can be set as follows:\n"
-                               "PATH=<path to compiler executable>:$PATH eden ...";
-#endif
 
-            more_commentary += "If using Python, PATH can be set as follows:\n"
-                               "os.environ[\"PATH\"] = <path to compiler executable> + os.pathsep + os.environ[\"PATH\"]\n"
-                               "runEden(...)";
-
-            fprintf(stderr, "%s\n", complaint_line.c_str());
-            if( !more_commentary.empty() ){
-                fprintf(stderr, "%s\n", more_commentary.c_str());
+            // every node on the machine needs to know if the files are in place
+            int node_dir_ok = dir_ok;
+            MPI_Bcast( &node_dir_ok, 1, MPI_INT, 0, node_comm );
+            if( share_ok && !node_dir_ok ){
+                fprintf(stderr, "Could not place kernels in %s\n", kernel_dir.c_str());
+                share_ok = false;
             }
 
-            return false;
-        }
-
-        // NOTE -lm must be put last, after other obj files (like source code) have stated their dependencies on libm
-        // further reading: https://eli.thegreenplace.net/2013/07/09/library-order-in-static-linking
-        std::string cmdline =     compiler_name + " " + basic_flags + dll_flags + code_quality_flags + " -o " + dll_filename + " " + code_filename + lm_flags;
-        printf("%s\n", cmdline.c_str());
-        std::string cmdline_asm = compiler_name + " " + basic_flags + dll_flags + code_quality_flags + asm_flags + " " + code_filename + lm_flags;
-        if(config.output_assembly){
-            if( system(cmdline_asm.c_str()) != 0 ){
-                fprintf(stderr, "Could not build %s assembly\n", dll_filename.c_str());
-                return false;
+            if( share_ok ){
+                // cell types with the same code get the same kernels
+                for( size_t i = 0; i < kernels_to_share.size(); i++ ){
+                    if( !LoadCellKernels( kernel_paths[ kernel_to_distinct[i] ], cell_sigs[ kernels_to_share[i].sig_seq ] ) ){
+                        share_ok = false;
+                        break;
+                    }
+                }
             }
-        }
-        if( system(cmdline.c_str()) != 0 ){
-            fprintf(stderr, "Could not build %s\n", dll_filename.c_str());
-            return false;
-        }
 
-        // load the code
-        std::string function_name = "doit";
-        IterationCallback callback = NULL;
+            // the loaded libraries stay mapped, so the files can go away once all nodes on the machine have them
+            MPI_Barrier( node_comm );
+            if( node_rank == 0 ){
+                for( const auto &path : kernel_paths ){
+                    if( !path.empty() ) unlink( path.c_str() );
+                }
+                rmdir( kernel_dir.c_str() );
+            }
+            MPI_Comm_free( &node_comm );
 
-#if defined (__linux__) || defined(__APPLE__)
-        void *dll_handle = dlopen(("./"+dll_filename).c_str(), RTLD_NOW);
-        if(!dll_handle){
-            fprintf(stderr, "Error loading %s: %s\n", dll_filename.c_str(), dlerror());
-            return false;
-        }
-        *(void**)(& callback ) = dlsym(dll_handle, function_name.c_str()); // C-style voodoo to make a "valid" cast
-        if(!callback){
-            fprintf(stderr, "Error loading %s symbol %s: %s\n", dll_filename.c_str(), function_name.c_str(), dlerror());
-            dlclose(dll_handle);
-            return false;
-        }
-#endif
-#ifdef _WIN32
-        // TODO normalize paths to place dll's somewhere else than cwd !
-        // TODO Unicode support, with MultiByteToWideChar
-        HMODULE dll_handle = LoadLibraryA((".\\"+dll_filename).c_str());
-        if(!dll_handle){
-            DWORD errCode = GetLastError();
-            fprintf(stderr, "Error loading %s: %s\n", dll_filename.c_str(), DescribeErrorCode_Windows(errCode).c_str());
-            return false;
-        }
-        *(void**)(& callback ) = (void*)GetProcAddress(dll_handle, function_name.c_str());
-        if(!callback){
-            DWORD errCode = GetLastError();
-            fprintf(stderr, "Error loading %s symbol %s: %s\n", dll_filename.c_str(), function_name.c_str(), DescribeErrorCode_Windows(errCode).c_str());
-            FreeLibrary(dll_handle);
-            return false;
-        }
-#endif
+            // bail out together, rather than leaving the other nodes hanging
+            int all_share_ok = share_ok;
+            MPI_Allreduce( MPI_IN_PLACE, &all_share_ok, 1, MPI_INT, MPI_LAND, MPI_COMM_WORLD );
+            if( !all_share_ok ) return false;
 
-        if(!callback){
-            // which is already guarded against in platform specific code.
-            // the only reason this should happen is if the platform is not supported
-            fprintf(stderr, "Error loading %s: %s\n", dll_filename.c_str(), "internal error");
-            return false;
+            printf("Built %zd distinct kernels for %zd cell types over %d nodes\n", distinct_kernels.size(), kernels_to_share.size(), world_size);
         }
-        sig.callback = callback;
-        // LATER keep a set of dynamic libraries loaded, to cleanup
-        // though it's pointless in this sort of application
-        gettimeofday(&compile_end, NULL);
-        printf("Compiled and loaded %s in %.2lf seconds\n", code_id.c_str(), TimevalDeltaSec(compile_start, compile_end));
-
 
-        cell_sigs.push_back(sig);
+        gettimeofday(&share_end, NULL);
+        printf("Compiled and loaded kernels in %.2lf seconds\n", TimevalDeltaSec(share_start, share_end));
+        startup_phases.Add( "model: shared kernels", TimevalDeltaSec(share_start, share_end), 1 );
     }
-    // LATER further specialize cell types with synapse and input components INSIDE the per-cell code block, for better legibility, but how?
+#endif
+    startup_phases.Add( "model: cell types", cell_types_timer.delta() );
 
 
     // now realize the model
@@ -5521,15 +6472,11 @@ bool GenerateModel(const Model &model, const SimulatorConfig &config, EngineConf
 
 
     // Since the model is presented in its entirety, nodes need to perform domain decomposition themselves
-    // Unfortunately, this means all nodes need to consider the existence of neuron Global ID's of all peers
+    // The node of any neuron GID is derived on demand from the partitioning (see NodeMapper), so no per-neuron maps over the whole network are kept;
+    // only the local neurons are materialized below
     // LATER make a file format that enables fully distributed loading, through pre-processed domain decomposition (using e.g. METIS, or Scotch)
 
-    // Mapping of neuron GIDs <-> ( nodes, work items, PointOnCellLocator's )
-
-    std::map< Int, int > neuron_gid_to_node;
-    std::vector< std::map<Int, Int> > neuron_gid_per_cell_per_population( (engine_config.use_mpi)*net.populations.contents.size() );
-
-    // for local neurons only
+    // Mapping of neuron GIDs <-> ( work items, PointOnCellLocator's ), for local neurons only
     std::map< Int, work_t > neuron_gid_to_workitem;
 
     // similar to PointOnCellLocator
@@ -5557,45 +6504,6 @@ bool GenerateModel(const Model &model, const SimulatorConfig &config, EngineConf
         return hm.at(cell_seq);
     };
 
-    auto GetGlobalGid_FromPopInst = [ &net, &neuron_gid_per_cell_per_population  ]( Int pop_seq, Int cell_seq ){
-
-        // sanity check
-        if(!( 0 <= pop_seq && pop_seq < (Int)net.populations.contents.size() )) return (ptrdiff_t) -1;
-
-        auto &hm = neuron_gid_per_cell_per_population[pop_seq];
-
-        if( !hm.count(cell_seq) ) return (ptrdiff_t) -1;
-
-        return hm.at(cell_seq);
-    };
-
-    auto GetRemoteNode_FromPopInst = [ &GetGlobalGid_FromPopInst, &neuron_gid_to_node ]( Int pop_seq, Int cell_seq ){
-        // sanity check
-
-        Int gid = GetGlobalGid_FromPopInst( pop_seq, cell_seq );
-        if( gid < 0 ) return (int) ~0xABadD00d;
-
-        if( !neuron_gid_to_node.count(gid) ){
-            printf("Internal error: missing node for neuron gid %ld\n", gid);
-            return (int) ~0xABadD00d;
-        }
-
-        return neuron_gid_to_node.at(gid);
-    };
-
-    // Maps neuron instance to either non-negative local work item, or negative ~(remote_node_id)
-    auto WorkUnitOrNode = [ &GetLocalWorkItem_FromPopInst, &GetRemoteNode_FromPopInst ]( int pop, int cell_inst ){
-        work_t ret = GetLocalWorkItem_FromPopInst( pop, cell_inst );
-        // Say("pop %d %d = %llx", pop, cell_inst, (long long)ret);
-
-        if( ret < 0 ){
-            ret = ~GetRemoteNode_FromPopInst( pop, cell_inst );
-        }
-        // Say("popp %d %d = %llx", pop, cell_inst, (long long)ret);
-
-        return ret;
-    };
-
 #endif
 
     // workunit_per_cell_per_population is for NON MPI work
@@ -5609,9 +6517,10 @@ bool GenerateModel(const Model &model, const SimulatorConfig &config, EngineConf
     // GetLocalWorkItem_FromPopInst
 
     printf("Creating populations...\n");
+    for( const auto &sig : cell_sigs ) tabs.work_item_kind_names.push_back(sig.name);
 
     auto InstantiateCellAsWorkitem = [ &config, &input_sources, &tabs ](
-            const CellType &cell_type, const CellInternalSignature &sig,
+            const CellType &cell_type, const CellInternalSignature &sig, Int cell_type_seq,
             Int cell_gid, // for intra-cell randomization
             Int simulation_rng_seed,
             size_t &work_unit
@@ -5731,6 +6640,20 @@ bool GenerateModel(const Model &model, const SimulatorConfig &config, EngineConf
                 AppendToVector(InvRCD, cabl_def.BwdEuler_InvRCDiagonal);
                 WorkD.resize(Order.size(), NAN); // don't care about the content, but must initialize it
             }
+            else if( cabl_def.type == SimulatorConfig::CABLE_BWD_EULER_HINES || cabl_def.type == SimulatorConfig::CABLE_CRANK_NICOLSON ){
+                // the factorization is shared by all instances in the code, only the scratchpad is per instance
+                if( cabl_def.Hines_Lanes > 0 ){
+                    // or per group of instances, see InstantiateLaneGroup
+                }
+                else{
+                    RawTables::Table_F32 &WorkV  = tab_sf32[off_sf32 + cabl_impl.Index_Hines_WorkVoltage];
+                    WorkV.resize(cabl_def.Hines_OrderList.size(), NAN); // don't care about the content, but must initialize it
+                }
+                if( !cabl_def.Hines_RangeTop.empty() ){
+                    RawTables::Table_F32 &Carry  = tab_sf32[off_sf32 + cabl_impl.Index_Hines_RangeCarry];
+                    Carry.resize(cabl_def.Hines_RangeTop.size(), NAN);
+                }
+            }
             else{
                 printf("Unknown cable solver %d for %s\n", cabl_def.type, sig.name.c_str());
                 return false;
@@ -5759,19 +6682,73 @@ bool GenerateModel(const Model &model, const SimulatorConfig &config, EngineConf
 
         // instantiate iteration callback
         tabs.callbacks.push_back(sig.callback);
+        tabs.work_item_kind.push_back(cell_type_seq);
+        tabs.work_item_wave.push_back( sig.split_parts.empty() ? 0 : CellInternalSignature::WAVE_CELL );
+        tabs.work_item_part.push_back(-1);
+        tabs.work_item_lanes_from.push_back(-1);
+
+        // and the parts of a split cell, as work items on the same tables
+        for( size_t part_seq = 0; part_seq < sig.split_parts.size(); part_seq++ ){
+            if( sig.split_parts[part_seq].per_lane_group ) continue; // see InstantiateLaneGroup
+            tabs.global_state_f32_index.push_back( tabs.global_state_f32_index[work_unit] );
+            tabs.global_const_f32_index.push_back( tabs.global_const_f32_index[work_unit] );
+            tabs.global_table_const_f32_index.push_back( tabs.global_table_const_f32_index[work_unit] );
+            tabs.global_table_const_i64_index.push_back( tabs.global_table_const_i64_index[work_unit] );
+            tabs.global_table_state_f32_index.push_back( tabs.global_table_state_f32_index[work_unit] );
+            tabs.global_table_state_i64_index.push_back( tabs.global_table_state_i64_index[work_unit] );
+            tabs.callbacks.push_back( sig.split_parts[part_seq].callback );
+            tabs.work_item_kind.push_back(cell_type_seq);
+            tabs.work_item_wave.push_back( sig.split_parts[part_seq].wave );
+            tabs.work_item_part.push_back( part_seq );
+            tabs.work_item_lanes_from.push_back(-1);
+        }
 
         return true;
     };
+    // the parts shared by a group of consecutive instances of a cell type (see CableSolverDefinition::Hines_Lanes),
+    // as work items right after the instances
+    auto InstantiateLaneGroup = [ &tabs ]( const CellInternalSignature &sig, Int cell_type_seq, const std::vector<size_t> &lane_work_units ){
+        if( lane_work_units.empty() ) return;
+        const auto &pig = sig.physical_cell;
+        for( size_t part_seq = 0; part_seq < sig.split_parts.size(); part_seq++ ){
+            if( !sig.split_parts[part_seq].per_lane_group ) continue;
+
+            // no scalar state or constants of its own
+            tabs.global_state_f32_index.push_back( tabs.global_initial_state.size() );
+            tabs.global_const_f32_index.push_back( tabs.global_constants.size() );
+            tabs.global_table_const_f32_index.push_back( tabs.global_tables_const_f32_arrays.size() );
+            tabs.global_table_const_i64_index.push_back( tabs.global_tables_const_i64_arrays.size() );
+            tabs.global_table_state_f32_index.push_back( tabs.global_tables_state_f32_arrays.size() );
+            tabs.global_table_state_i64_index.push_back( tabs.global_tables_state_i64_arrays.size() );
+
+            // where the voltages of each instance are in the flat state
+            tabs.global_tables_const_i64_arrays.emplace_back();
+            for( size_t lane_unit : lane_work_units ){
+                tabs.global_tables_const_i64_arrays.back().push_back( tabs.global_state_f32_index[lane_unit] + pig.Index_Voltages );
+            }
+            // and the lane-interleaved scratchpad, with unused lanes at 0
+            tabs.global_tables_state_f32_arrays.emplace_back( pig.cable_solver.Hines_OrderList.size() * pig.cable_solver.Hines_Lanes, 0 );
+
+            tabs.callbacks.push_back( sig.split_parts[part_seq].callback );
+            tabs.work_item_kind.push_back(cell_type_seq);
+            tabs.work_item_wave.push_back( sig.split_parts[part_seq].wave );
+            tabs.work_item_part.push_back( part_seq );
+            tabs.work_item_lanes_from.push_back( lane_work_units.front() );
+        }
+    };
 
 #ifdef USE_MPI
+    Timer partition_timer;
     // For domain decompoosition, get the footprint of the populations
     // like total amount of cells, etc.
 
-    int total_neurons = 0; // LATER replace with referrable parts of the model, or sth
+    // neuron GIDs are given in population order, so each population takes a contiguous range of them
+    std::vector<int> pop_gid_start( net.populations.contents.size() + 1, 0 );
     for( Int pop_seq = 0; pop_seq < (Int)net.populations.contents.size() ; pop_seq++ ){
         const Network::Population &pop = net.populations.contents[pop_seq];
-        total_neurons += (int) pop.instances.size();
+        pop_gid_start[pop_seq + 1] = pop_gid_start[pop_seq] + (int) pop.instances.size();
     }
+    int total_neurons = pop_gid_start.back(); // LATER replace with referrable parts of the model, or sth
 
     if (engine_config.use_mpi) {
         Say("Total neurons: %d", total_neurons);
@@ -5780,47 +6757,299 @@ bool GenerateModel(const Model &model, const SimulatorConfig &config, EngineConf
     }
 
 
-    // TODO this is where splitting happens
-    // TODO simplest domain decomposition: by neuron GID
-    // TODO domain decomposition shoould be done as a preliminary step,
-    //     so each node bothers only with its own part (and adjacent)
-    //     instead of trying to find out what is own, which work items and nodes are adjacent
+    // With the even partitioning, each node has kept only the connections and inputs that touch its own cells when reading the network,
+    // then the slices must be the same as they were then
+    if( !net.kept_slice.Whole() ){
+        if(!( engine_config.use_mpi && config.partition == SimulatorConfig::PARTITION_EVEN
+            && net.kept_slice.total_nodes == engine_config.my_mpi.world_size && net.kept_slice.node == engine_config.my_mpi.rank
+            && net.kept_slice_total_cells == total_neurons )){
+            printf("internal error: the network was read for a different partitioning\n");
+            return false;
+        }
+    }
+
+    // TODO domain decomposition for the cost and graph strategies, which need the whole network on every node,
+    //     could also be done as a preliminary step, so each node bothers only with its own part (and adjacent)
     struct NodeMapper{
-        // evened
-        // LATER more strategies
         int total_nodes;
         int total_items;
 
+        // Most strategies give each node a contiguous slice of GID's; this is where each slice starts (plus the end)
+        std::vector<int> slice_start;
+        // otherwise, the node for each GID is kept
+        std::vector<int> node_of_item;
+
         NodeMapper(int _no, int _ne){
             total_nodes = _no;
             total_items = _ne;
+            PartitionEvenly();
         }
 
-        int GetNodeFor(int item_gid ){
+        int GetNodeFor(int item_gid ) const {
 
             // sanity check
             if(!( 0 <= item_gid && item_gid < total_items )) return -1;
 
-            // distribute the items, as even as possible
-            int work_items_evenly  = total_items / total_nodes;
-            int work_items_residue = total_items % total_nodes;
-            // each node gets a contiguous slice of GID's, for now
-            // with lengths [ evenly + 1, evenly + 1 ... evenly, evenly ]
+            if( !node_of_item.empty() ) return node_of_item[item_gid];
+
+            // the last slice that starts at or before this item (empty slices are skipped this way)
+            return (int)( std::upper_bound( slice_start.begin(), slice_start.end(), item_gid ) - slice_start.begin() ) - 1;
+        }
+
+        // distribute the items, as even as possible
+        void PartitionEvenly(){
+            node_of_item.clear();
+            slice_start.resize( total_nodes + 1 );
+
+            // the same slices as a node keeps when reading the network
+            for( int node = 0; node <= total_nodes; node++ ){
+                slice_start[node] = (int) NetworkSlice::SliceStart( total_items, total_nodes, node );
+            }
+        }
+
+        // distribute the items in GID order, so that each slice has about the same cost
+        void PartitionByCost( const std::vector<float> &item_cost ){
+            node_of_item.clear();
+            slice_start.assign( total_nodes + 1, total_items );
+            slice_start[0] = 0;
+
+            double total_cost = 0;
+            for( float cost : item_cost ) total_cost += cost;
+            if(!( total_cost > 0 )){
+                PartitionEvenly();
+                return;
+            }
+
+            // each item goes where the middle of its cost interval falls, so slices remain contiguous
+            double cost_before = 0;
+            int prev_node = 0;
+            for( int item = 0; item < total_items; item++ ){
+                double mid = cost_before + item_cost[item] / 2;
+                int node = std::min( total_nodes - 1, (int)( mid * total_nodes / total_cost ) );
+                for( int n = prev_node + 1; n <= node; n++ ) slice_start[n] = item;
+                prev_node = node;
+                cost_before += item_cost[item];
+            }
+        }
 
-            int work_items_from_resi_nodes = (work_items_evenly + 1) * work_items_residue;
-            if( item_gid < work_items_from_resi_nodes ){
-                // in evenly + 1 part of nodes
-                return ( item_gid ) / ( work_items_evenly + 1 );
+        // Keep connected items on the same node, while balancing cost:
+        // first lay the items out in breadth-first order over the connectivity graph (so neighbours are mostly in the same slice),
+        // then greedily move items on the boundaries to the node they have the most connections with, as long as it stays balanced.
+        // The adjacency is in compressed row form. It is as big as the connections twice over, so only the first node partitions (see below).
+        // LATER use a proper multilevel partitioner (METIS, Scotch...) when available
+        void PartitionByGraph( const std::vector<float> &item_cost, const std::vector<long long> &adj_start, const std::vector<int> &adj_items ){
+
+            std::vector<int> order;
+            order.reserve( total_items );
+            std::vector<char> visited( total_items, 0 );
+            for( int seed = 0; seed < total_items; seed++ ){
+                if( visited[seed] ) continue;
+                visited[seed] = 1;
+                size_t head = order.size();
+                order.push_back( seed );
+                while( head < order.size() ){
+                    int item = order[head++];
+                    for( long long i = adj_start[item]; i < adj_start[item + 1]; i++ ){
+                        int other = adj_items[i];
+                        if( visited[other] ) continue;
+                        visited[other] = 1;
+                        order.push_back( other );
+                    }
+                }
+            }
+
+            // slice the ordering by cost
+            std::vector<float> order_cost( total_items );
+            for( int i = 0; i < total_items; i++ ) order_cost[i] = item_cost[ order[i] ];
+            PartitionByCost( order_cost );
+
+            std::vector<int> nodes( total_items );
+            for( int i = 0; i < total_items; i++ ) nodes[ order[i] ] = GetNodeFor(i);
+
+            std::vector<double> load( total_nodes, 0 );
+            double total_cost = 0;
+            for( int item = 0; item < total_items; item++ ){
+                load[ nodes[item] ] += item_cost[item];
+                total_cost += item_cost[item];
+            }
+            const double IMBALANCE_TOLERANCE = 1.03;
+            const double max_load = IMBALANCE_TOLERANCE * total_cost / total_nodes;
+
+            const int REFINEMENT_PASSES = 4;
+            std::map<int, int> links_to_node; // for the item being examined
+            for( int pass = 0; pass < REFINEMENT_PASSES; pass++ ){
+                long long moved = 0;
+                for( int item = 0; item < total_items; item++ ){
+                    int mine = nodes[item];
+
+                    links_to_node.clear();
+                    for( long long i = adj_start[item]; i < adj_start[item + 1]; i++ ){
+                        links_to_node[ nodes[ adj_items[i] ] ]++;
+                    }
+                    int best_node = mine;
+                    int best_links = links_to_node.count(mine) ? links_to_node.at(mine) : 0;
+                    for( const auto &keyval : links_to_node ){
+                        if( keyval.second > best_links && load[keyval.first] + item_cost[item] <= max_load ){
+                            best_node = keyval.first;
+                            best_links = keyval.second;
+                        }
+                    }
+                    if( best_node != mine ){
+                        load[mine] -= item_cost[item];
+                        load[best_node] += item_cost[item];
+                        nodes[item] = best_node;
+                        moved++;
+                    }
+                }
+                if( !moved ) break;
+            }
+
+            slice_start.clear();
+            node_of_item = nodes;
+        }
+    };
+
+    NodeMapper to_node(engine_config.use_mpi ? engine_config.my_mpi.world_size : 1, total_neurons );
+
+    if( engine_config.use_mpi ){
+        // Estimated cost of each cell, per step:
+        // the state variables stand for the internal dynamics (compartments, channel gates, ion pools...),
+        // then the synapses and inputs attached to it
+        const float SYNAPSE_COST = 2;
+        const float INPUT_COST = 2;
+
+        std::vector<float> cell_cost( total_neurons );
+        for( Int pop_seq = 0; pop_seq < (Int)net.populations.contents.size() ; pop_seq++ ){
+            const auto &wig = cell_sigs[ net.populations.contents[pop_seq].component_cell ].cell_wig;
+            for( int gid = pop_gid_start[pop_seq]; gid < pop_gid_start[pop_seq + 1]; gid++ ){
+                cell_cost[gid] = 1 + wig.state.size();
+            }
+        }
+        for( const auto &inp : net.inputs ){
+            cell_cost[ pop_gid_start[inp.population] + inp.cell_instance ] += INPUT_COST;
+        }
+        for( const auto &proj : net.projections.contents ){
+            for( const auto &conn : proj.connections ){
+                int pre_gid  = pop_gid_start[proj.presynapticPopulation ] + conn.preCell;
+                int post_gid = pop_gid_start[proj.postsynapticPopulation] + conn.postCell;
+                cell_cost[post_gid] += SYNAPSE_COST;
+                if( conn.type != Network::Projection::Connection::SPIKING ) cell_cost[pre_gid] += SYNAPSE_COST;
+            }
+        }
+
+        const char *strategy_name = "even";
+        if( config.partition == SimulatorConfig::PARTITION_COST ){
+            strategy_name = "cost";
+            to_node.PartitionByCost( cell_cost );
+        }
+        else if( config.partition == SimulatorConfig::PARTITION_GRAPH ){
+            strategy_name = "graph";
+
+            // the first node partitions and sends the result to the rest, and the adjacency goes away right after
+            if( engine_config.my_mpi.rank == 0 ){
+                // undirected adjacency, as compressed rows
+                std::vector<long long> adj_start( total_neurons + 1, 0 );
+                auto ForEachLink = [ &net, &pop_gid_start ]( auto &&callback ){
+                    for( const auto &proj : net.projections.contents ){
+                        for( const auto &conn : proj.connections ){
+                            int pre_gid  = pop_gid_start[proj.presynapticPopulation ] + conn.preCell;
+                            int post_gid = pop_gid_start[proj.postsynapticPopulation] + conn.postCell;
+                            if( pre_gid == post_gid ) continue;
+                            callback( pre_gid, post_gid );
+                            callback( post_gid, pre_gid );
+                        }
+                    }
+                };
+                ForEachLink( [ &adj_start ]( int from, int to ){ (void) to; adj_start[from + 1]++; } );
+                for( int gid = 0; gid < total_neurons; gid++ ) adj_start[gid + 1] += adj_start[gid];
+                std::vector<int> adj_items( adj_start[total_neurons] );
+                std::vector<long long> adj_fill( adj_start.begin(), adj_start.end() - 1 );
+                ForEachLink( [ &adj_items, &adj_fill ]( int from, int to ){ adj_items[ adj_fill[from]++ ] = to; } );
+
+                to_node.PartitionByGraph( cell_cost, adj_start, adj_items );
             }
             else{
-                // in part of nodes without the residue
-                int off_nonres = item_gid - work_items_from_resi_nodes;
-                return work_items_residue + ( off_nonres ) / ( work_items_evenly );
+                to_node.slice_start.clear();
+                to_node.node_of_item.resize( total_neurons );
+            }
+            MPI_Bcast( to_node.node_of_item.data(), total_neurons, MPI_INT, 0, MPI_COMM_WORLD );
+        }
+
+        // and report the predicted load for each node; each node counts its own cells and the connections onto them,
+        // since it may have kept only its own part of the network
+        {
+            const int my_rank = engine_config.my_mpi.rank;
+            long long my_cells = 0;
+            double my_cost = 0;
+            long long my_connections[2] = { 0, 0 }; // all, and those from other nodes
+            for( int gid = 0; gid < total_neurons; gid++ ){
+                if( to_node.GetNodeFor(gid) != my_rank ) continue;
+                my_cells++;
+                my_cost += cell_cost[gid];
+            }
+            for( const auto &proj : net.projections.contents ){
+                for( const auto &conn : proj.connections ){
+                    int pre_gid  = pop_gid_start[proj.presynapticPopulation ] + conn.preCell;
+                    int post_gid = pop_gid_start[proj.postsynapticPopulation] + conn.postCell;
+                    if( to_node.GetNodeFor(post_gid) != my_rank ) continue;
+                    my_connections[0]++;
+                    if( to_node.GetNodeFor(pre_gid) != my_rank ) my_connections[1]++;
+                }
+            }
+            std::vector<long long> node_cells( to_node.total_nodes, 0 );
+            std::vector<double> node_cost( to_node.total_nodes, 0 );
+            long long connections[2] = { 0, 0 };
+            MPI_Gather( &my_cells, 1, MPI_LONG_LONG, node_cells.data(), 1, MPI_LONG_LONG, 0, MPI_COMM_WORLD );
+            MPI_Gather( &my_cost, 1, MPI_DOUBLE, node_cost.data(), 1, MPI_DOUBLE, 0, MPI_COMM_WORLD );
+            MPI_Reduce( my_connections, connections, 2, MPI_LONG_LONG, MPI_SUM, 0, MPI_COMM_WORLD );
+
+            if( my_rank == 0 ){
+                double total_cost = 0;
+                for( double cost : node_cost ) total_cost += cost;
+                double max_cost = *std::max_element( node_cost.begin(), node_cost.end() );
+                double avg_cost = total_cost / to_node.total_nodes;
+                printf("Partitioned %d cells over %d nodes, strategy %s:\n", total_neurons, to_node.total_nodes, strategy_name);
+                for( int node = 0; node < to_node.total_nodes; node++ ){
+                    printf("\tnode %d:\t%lld cells,\testimated cost %g (%.1f%%)\n", node, node_cells[node], node_cost[node], total_cost > 0 ? 100 * node_cost[node] / total_cost : 0.0 );
+                }
+                printf("Load imbalance (max/avg cost): %.3f, cut connections: %lld of %lld\n", avg_cost > 0 ? max_cost / avg_cost : 1.0, connections[1], connections[0]);
             }
         }
+    }
+
+    auto GetGlobalGid_FromPopInst = [ &net, &pop_gid_start ]( Int pop_seq, Int cell_seq ){
+
+        // sanity check
+        if(!( 0 <= pop_seq && pop_seq < (Int)net.populations.contents.size() )) return (ptrdiff_t) -1;
+        if(!( 0 <= cell_seq && cell_seq < pop_gid_start[pop_seq + 1] - pop_gid_start[pop_seq] )) return (ptrdiff_t) -1;
+
+        return (ptrdiff_t) pop_gid_start[pop_seq] + cell_seq;
     };
 
-    NodeMapper to_node(engine_config.my_mpi.world_size, total_neurons );
+    auto GetRemoteNode_FromPopInst = [ &GetGlobalGid_FromPopInst, &to_node ]( Int pop_seq, Int cell_seq ){
+
+        Int gid = GetGlobalGid_FromPopInst( pop_seq, cell_seq );
+        if( gid < 0 ){
+            printf("Internal error: missing node for neuron %ld of population %ld\n", cell_seq, pop_seq);
+            return (int) ~0xABadD00d;
+        }
+
+        return to_node.GetNodeFor(gid);
+    };
+
+    // Maps neuron instance to either non-negative local work item, or negative ~(remote_node_id)
+    auto WorkUnitOrNode = [ &GetLocalWorkItem_FromPopInst, &GetRemoteNode_FromPopInst ]( int pop, int cell_inst ){
+        work_t ret = GetLocalWorkItem_FromPopInst( pop, cell_inst );
+        // Say("pop %d %d = %llx", pop, cell_inst, (long long)ret);
+
+        if( ret < 0 ){
+            ret = ~GetRemoteNode_FromPopInst( pop, cell_inst );
+        }
+        // Say("popp %d %d = %llx", pop, cell_inst, (long long)ret);
+
+        return ret;
+    };
+    if( engine_config.use_mpi ) startup_phases.Add( "model: partitioning", partition_timer.delta() );
 #endif
 
     timeval time_pops_start, time_pops_end;
@@ -5832,6 +7061,9 @@ bool GenerateModel(const Model &model, const SimulatorConfig &config, EngineConf
 
         const CellType &cell_type = model.cell_types.get(pop.component_cell);
         const auto &sig = cell_sigs[pop.component_cell];
+        // the instances of the population that are solved together, if any
+        const Int lanes = ( cell_type.type == CellType::PHYSICAL ) ? sig.physical_cell.cable_solver.Hines_Lanes : 0;
+        std::vector<size_t> lane_work_units;
 
         // TODO pre-allocate since the values will be cloned in a predictable pattern
         for( Int inst_seq = 0; inst_seq < (Int)pop.instances.size(); inst_seq++ ){
@@ -5842,9 +7074,6 @@ bool GenerateModel(const Model &model, const SimulatorConfig &config, EngineConf
             if (engine_config.use_mpi) {
                 int on_node = to_node.GetNodeFor( current_neuron_gid );
 
-                neuron_gid_per_cell_per_population[pop_seq][inst_seq] = current_neuron_gid;
-                neuron_gid_to_node[current_neuron_gid] = on_node;
-
                 if( on_node == engine_config.my_mpi.rank ) instantiate_this = true;
                 else instantiate_this = false;
             }
@@ -5856,7 +7085,7 @@ bool GenerateModel(const Model &model, const SimulatorConfig &config, EngineConf
                 // if(config.debug){
                 // printf("Instantiating cell %d...\n", current_neuron_gid);
                 // }
-                if( !InstantiateCellAsWorkitem( cell_type, sig, current_neuron_gid, simulation_random_seed, work_unit ) ) return false;
+                if( !InstantiateCellAsWorkitem( cell_type, sig, pop.component_cell, current_neuron_gid, simulation_random_seed, work_unit ) ) return false;
 
 #ifdef USE_MPI
             if (engine_config.use_mpi) {
@@ -5873,14 +7102,23 @@ bool GenerateModel(const Model &model, const SimulatorConfig &config, EngineConf
                 workunit_per_cell_per_population[pop_seq].push_back(work_unit);
 
 #endif
+                if( lanes > 0 ){
+                    lane_work_units.push_back(work_unit);
+                    if( (Int) lane_work_units.size() == lanes ){
+                        InstantiateLaneGroup( sig, pop.component_cell, lane_work_units );
+                        lane_work_units.clear();
+                    }
+                }
             }
 
             current_neuron_gid++;
         }
+        InstantiateLaneGroup( sig, pop.component_cell, lane_work_units );
 
     }
     gettimeofday(&time_pops_end, NULL);
     printf("Created populations in %.4lf sec.\n",TimevalDeltaSec(time_pops_start, time_pops_end));
+    startup_phases.Add( "model: populations", TimevalDeltaSec(time_pops_start, time_pops_end) );
 
     // Add some extra misc-purpose tables
     tabs.global_const_tabref = tabs.global_tables_const_f32_arrays.size();
@@ -6191,6 +7429,7 @@ bool GenerateModel(const Model &model, const SimulatorConfig &config, EngineConf
 
     gettimeofday(&time_inps_end, NULL);
     printf("Created inputs in %.4lf sec.\n",TimevalDeltaSec(time_inps_start, time_inps_end));
+    startup_phases.Add( "model: inputs", TimevalDeltaSec(time_inps_start, time_inps_end) );
 
     // also populate the synapses
     // place the append syncomp lambda somewhere here LATER
@@ -6438,10 +7677,10 @@ bool GenerateModel(const Model &model, const SimulatorConfig &config, EngineConf
             return true; // yay!
         };
 
-        for(size_t conn_seq = 0; conn_seq < proj.connections.contents.size(); conn_seq++){
-            const auto &conn = proj.connections.contents[conn_seq];
+        for(size_t conn_seq = 0; conn_seq < proj.connections.size(); conn_seq++){
+            const auto conn = proj.connections[conn_seq];
 
-            // printf("Connection %zd of %zd \n", conn_seq, proj.connections.contents.size() ); fflush(stdout);
+            // printf("Connection %zd of %zd \n", conn_seq, proj.connections.size() ); fflush(stdout);
 
             const PointOnCellLocator pre_loc  = { proj.presynapticPopulation , conn.preCell , conn.preSegment , conn.preFractionAlong  };
             const PointOnCellLocator post_loc = { proj.postsynapticPopulation, conn.postCell, conn.postSegment, conn.postFractionAlong };
@@ -6533,6 +7772,7 @@ bool GenerateModel(const Model &model, const SimulatorConfig &config, EngineConf
 
     gettimeofday(&time_syns_end, NULL);
     printf("Created synapses in %.4lf sec.\n",TimevalDeltaSec(time_syns_start, time_syns_end));
+    startup_phases.Add( "model: synapses", TimevalDeltaSec(time_syns_start, time_syns_end) );
 
     printf("Creating data outputs...\n");
 
@@ -6561,6 +7801,8 @@ bool GenerateModel(const Model &model, const SimulatorConfig &config, EngineConf
 
                     int remote_node = ~(work_unit_seg);
                     column.on_node = remote_node;
+                    // with sharded output, the other node writes the column itself
+                    if( engine_config.my_mpi.sharded_output ) return true;
                     if( !AppendRemoteDependency_DataWriter( {daw_seq, col_seq}, remote_node ) ) return false;
 
                     return true;
@@ -6819,6 +8061,10 @@ bool GenerateModel(const Model &model, const SimulatorConfig &config, EngineConf
             // form the data structures, send requests for whatever is remote
 
         }
+        else if( engine_config.my_mpi.sharded_output ){
+            i_log_the_data = true;
+            // write the local columns, in a separate file
+        }
         else{
             i_log_the_data = false;
             // wait for remote requests from logger node to emerge
@@ -6853,6 +8099,8 @@ bool GenerateModel(const Model &model, const SimulatorConfig &config, EngineConf
     }
     //FIXME add event writers
 
+    startup_phases.Lap("model: outputs");
+
 #ifdef USE_MPI
     // I send recvlists to nodes, for them to send to me
     std::map< int, std::vector<char> > recvlists_encoded;
@@ -6860,6 +8108,7 @@ bool GenerateModel(const Model &model, const SimulatorConfig &config, EngineConf
     // Nodes send recvlists to nodes, for me to send to them
     std::map< int, std::vector<char> > sendlists_encoded;
 
+    Timer recvlists_timer;
     if (engine_config.use_mpi) {
         printf("Determining recvlists...\n"); fflush(stdout);
         // Now, each node informs the others on what information streams it needs, in a symbolic(NeuroML-based) format
@@ -6941,366 +8190,77 @@ bool GenerateModel(const Model &model, const SimulatorConfig &config, EngineConf
         }
     }
     // very much like Alltoallv, but communications are made with only existing connections (not the whole cartesian product)
-    // this should really shine in large amounts of nodes (hundreds? or even tens?)
-    // MPI_Graph_Neighbor* is similar, but it does not allow for automatic discovery of comm-adjacent nodes
+    // Uses the non-blocking consensus scheme (Hoefler et al., "Scalable communication protocols for dynamic sparse data exchange", 2010):
+    // each node synchronous-sends its lists and picks up whatever arrives from anyone; once its own sends are all matched, it joins a non-blocking barrier,
+    // and when the barrier completes every list in the job has been received.
+    // Nothing scales with the total number of nodes, except the barrier itself which is logarithmic.
     auto ExchangeLists = [  ]( const MPI_Datatype &datatype, const auto &sent_vectors_hashmap, auto & received_vectors_hashmap ){
 
-        // skip, let them communicate
-
-        const int TAG_LIST_SIZE = 1;
         const int TAG_LIST_LIST = 0;
-        const int TAG_LIST_RECEIVED = 3;
 
-        const bool use_Ssend = false; // for the msg list, so confiramtion comes through MPI itself
+        Timer exchange_timer;
 
-        // the steps are as following:
-        // each node sends send lists to the nodes it receives from
-        // and sets a "any" message sink to receive such lists from any receiver node it has to send to
-        // the message sink is also used to receive confirmation of the send lists having been received !
-        //     this is important so that all send lists are sure to not be in the air, when listening stops
-        // the process is completed by running a poll on whether all nodes have received confirmation that their send lists were accepted
-
-        // an ordered sequence of the nodes I send recvlists to
-        std::vector<int> send_seq_to_node;
-        for( auto keyval : sent_vectors_hashmap ){
-            send_seq_to_node.push_back(keyval.first);
-        }
-        int nSends = (int)send_seq_to_node.size();
-
-        const int SEND_CODE_SUCCESS = 12345678;
-
-        std::vector< MPI_Request > own_req_list;
-        // Net receiver sends its recvlists to the nodes responsible to send the data
-
-        // sends the sizes first (or more general headers, could be useful for indirect discovery too ?)
-        int req_send_list_size_offset = own_req_list.size();
-        own_req_list.insert( own_req_list.end(), nSends, MPI_REQUEST_NULL );
-
-        // may send the lists too, or send them after connections are established (through list size headers)
-        int req_send_list_offset = own_req_list.size();
-        own_req_list.insert( own_req_list.end(), nSends, MPI_REQUEST_NULL );
-
-        // and may get a confirmation from sender (or use Ssend to do this instead)
-        int req_recv_list_confirm_offset = own_req_list.size();
-        own_req_list.insert( own_req_list.end(), nSends, MPI_REQUEST_NULL );
-
-        // These keep track of what the data receiver needs to send, and which sends are done
-        std::vector<int> list_send_sizes(nSends,-1);
-        std::vector<int> recvlist_replies(nSends,-1);
-        std::vector<bool> recvlist_replies_received( nSends, false );
-        // keep a handy count of recvlist_replies_received
-        int waiting_responses = 0;
-        int waiting_responses_buffer = INT_MAX; // plus temp.storage for async polling
-
-
-        // All nodes participate in the poll, to know when the connection discovery process is done
-        int req_poll_offset = own_req_list.size();
-        own_req_list.push_back( MPI_REQUEST_NULL );
-
-
-        // Potential net sender needs to accept inbound messages from any other node
-        int req_recv_list_size_offset = own_req_list.size();
-        own_req_list.push_back( MPI_REQUEST_NULL );
-        int recv_list_size_buffer = -1;
-
-        // and has to track a dynamic, unknown number of inbound connections for the unknown-sized lists
-        std::set<int> receiving_recvlist_from;
-
-        std::map< int, MPI_Request > emergent_req_send_confirm;
-        std::map< int, MPI_Request > emergent_req_recv_list; // for all messages, due to unknown size
-        std::map< int, int > emergent_recv_list_size; // for all messages, due to unknown size
-
-
-        // for Waitsome/Testsome
-        std::vector< MPI_Status > status_buf;
-        std::vector< int > status_buf_idx;
-
-        // First, emit all messages
-
-        // what if comm buffer is full? MPI runtime should then not put more messages, just keep them pending
-        for( int i_recv = 0; i_recv < nSends; i_recv++ ){
-
-            auto other_rank = send_seq_to_node[i_recv];
-            const auto &sent_list = sent_vectors_hashmap.at(other_rank);
+        // Ssend, so that completion means the list has been matched on the other side
+        std::vector< MPI_Request > send_reqs;
+        for( const auto &keyval : sent_vectors_hashmap ){
+            int other_rank = keyval.first;
+            const auto &sent_list = keyval.second;
 
             if( sent_list.empty() ) continue;
 
-            list_send_sizes[i_recv] = sent_list.size();
-
-            // Sends to the same outbound node are alwyas ordered
-            // send size msg first
-
-            MPI_Isend( &list_send_sizes[i_recv], 1, MPI_INT, other_rank, TAG_LIST_SIZE, MPI_COMM_WORLD, &own_req_list[ req_send_list_size_offset + i_recv]);
-
-            if(use_Ssend){
-                // don't need to recv a confirmation message
-                MPI_Issend( sent_list.data(), sent_list.size(), datatype, other_rank, TAG_LIST_LIST, MPI_COMM_WORLD, &own_req_list[ req_send_list_offset + i_recv]);
-            }
-            else{
-                // recv a notifiation that the recvlist has been received
-                MPI_Isend( sent_list.data(), sent_list.size(), datatype, other_rank, TAG_LIST_LIST, MPI_COMM_WORLD, &own_req_list[ req_send_list_offset + i_recv]);
-
-                MPI_Irecv( &recvlist_replies[i_recv], 1, MPI_INT, other_rank, TAG_LIST_RECEIVED, MPI_COMM_WORLD, &own_req_list[ req_recv_list_confirm_offset + i_recv]);
-            }
-
-            waiting_responses++;
+            send_reqs.push_back( MPI_REQUEST_NULL );
+            MPI_Issend( sent_list.data(), sent_list.size(), datatype, other_rank, TAG_LIST_LIST, MPI_COMM_WORLD, &send_reqs.back() );
         }
 
-        auto Setup_Irecv_ListSize = [ & ]( ){
-            MPI_Irecv( &recv_list_size_buffer, 1, MPI_INT, MPI_ANY_SOURCE, TAG_LIST_SIZE, MPI_COMM_WORLD, &own_req_list[ req_recv_list_size_offset ]);
-        };
-        Setup_Irecv_ListSize();
-
-        // and get a random recv list too, for lists I should send to
-        // MPI_Message probe_list_msg; // one for probe
-        // int probe_ready;
-
-        // Now, wait for incoming messages
-
-        typedef std::chrono::high_resolution_clock::time_point Time;
-        typedef std::chrono::duration<double> TimeDiff_Sec;
-        Time tStart = std::chrono::high_resolution_clock::now();
-
-        Time tLastPoll = tStart;
-        auto getSecs = [  ]( Time tEnd, Time tstart ){
-            return std::chrono::duration_cast< TimeDiff_Sec >(tEnd - tstart).count();
-        };
-
-        const double POLL_PERIOD_SEC = 0.1; // TODO make dynamic
-
+        MPI_Request barrier_req = MPI_REQUEST_NULL;
+        bool barrier_active = false;
         bool done = false;
-        bool waiting_poll = false;
-        int poll_result = -1;
-        int poll_serial_no = 0;
-
-        Say("Reqs %d %d %d %d %d %d", (int)own_req_list.size(), req_send_list_offset, req_send_list_size_offset, req_poll_offset, req_recv_list_confirm_offset, req_recv_list_size_offset);
-
-
         while( !done ){
 
-            // don't log this when spinning
-            // Say("Event loop start");
+            // pick up any list that arrived
+            int flag = 0;
+            MPI_Status status;
+            MPI_Iprobe( MPI_ANY_SOURCE, TAG_LIST_LIST, MPI_COMM_WORLD, &flag, &status );
+            if( flag ){
+                int other_rank = status.MPI_SOURCE;
+                int list_size = 0;
+                MPI_Get_count( &status, datatype, &list_size );
 
-            Time tNow = std::chrono::high_resolution_clock::now();
+                auto &received_list = received_vectors_hashmap[other_rank];
+                received_list.resize( list_size );
+                MPI_Recv( received_list.data(), list_size, datatype, other_rank, TAG_LIST_LIST, MPI_COMM_WORLD, MPI_STATUS_IGNORE );
 
-            // NB: should spin anyway, because this is a time driven event -- not impossible for all communications to complete
-            if( getSecs( tNow, tLastPoll ) > POLL_PERIOD_SEC && !waiting_poll ){
-                // start async poll
-                Say("Start poll %d", poll_serial_no);
-                waiting_responses_buffer = waiting_responses;
-                MPI_Iallreduce( &waiting_responses_buffer, &poll_result, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD, &own_req_list[req_poll_offset] );
-                poll_serial_no++;
-                waiting_poll = true;
-            }
-
-            // Receive messages, participate in the polls, everything
-            // Needs to spin because we also need to Recv an unknown-sized message -
-            // better to spin than to waste another roundtrip, maybe?
-
-            auto HandleRecvlistComplete = [ &recvlist_replies_received, &waiting_responses ]( int i_recv ){
-                if( !recvlist_replies_received[i_recv] ){
-                    recvlist_replies_received[i_recv] = true;
-                    waiting_responses--;
-                }
-                else{
-                    assert(false); // how can a second mesage be sent ?
-                }
-            };
-
-
-            // Poll for the static requests (recvlist-sender-side plus recvlist receiver for size/header)
-            status_buf.resize( own_req_list.size() );
-            status_buf_idx.resize( own_req_list.size() );
-            int outcount;
-            int ret = 0;
-
-            ret = MPI_Testsome( own_req_list.size(), own_req_list.data(), &outcount, status_buf_idx.data(), status_buf.data() );
-
-            bool success = ( ret == 0 );
-            bool req_errors = ( ret == MPI_ERR_IN_STATUS );
-            bool other_error = !( success || req_errors );
-
-            if( req_errors ){
-                Say("MPI POll Req Error, check it !");
-                MPI_Abort( MPI_COMM_WORLD, 5 );
-                abort();
-            }
-            if( other_error ){
-                Say("MPI Poll Misc Error, check it !");
-                MPI_Abort( MPI_COMM_WORLD, 5 );
-                abort();
+                Say("Received list from %d, length %d", other_rank, list_size);
             }
 
-            for( int idx = 0; idx < outcount; idx++ ){
-                int req_idx = status_buf_idx[idx];
-                const MPI_Status &status = status_buf[idx];
-
-
-                Say("Req %d finished", req_idx);
-
-                if( req_send_list_offset <= req_idx && req_idx < req_send_list_offset + nSends ){
-                    int i_recv = req_idx - req_send_list_offset;
-
-                    Say("Send recvlist %d ( to node %d ) finished", i_recv, send_seq_to_node.at(i_recv));
-
-                    // send was done
-
-                    // if it's Ssend, send completion is as good as an expicit ack message !
-                    if( use_Ssend ){
-                        HandleRecvlistComplete(i_recv);
-                    }
-                }
-                else if( req_send_list_size_offset <= req_idx && req_idx < req_send_list_size_offset + nSends ){
-                    int i_recv = req_idx - req_send_list_size_offset;
-
-                    Say("Send recvlist size %d ( to node %d ) finished", i_recv, send_seq_to_node.at(i_recv));
-
-                    // nothing meaningful to do
-                }
-                else if( req_idx == req_poll_offset ){
-                    Say("Received poll result of %d", poll_result);
-                    tLastPoll = tNow;
-                    waiting_poll = false;
-
-                    if( poll_result == 0 ){
-                        // finished, yay!!
-                        done = true;
-                        // maybe don't leave yet, just in case there is cleanup to be done in this loop
-                    }
-
-                    // otherwise, wait till next poll
-                }
-                else if( req_recv_list_confirm_offset <= req_idx && req_idx < req_recv_list_confirm_offset + nSends ){
-                    int i_recv = req_idx - req_recv_list_confirm_offset;
-
-                    int other_rank = status.MPI_SOURCE;
-                    auto should_be_other_rank = send_seq_to_node[i_recv];
-
-                    int recv_msg = recvlist_replies[i_recv] ;
-
-                    Say("Received confirmation from node %d, is %d", other_rank, recv_msg );
-
-                    assert( recv_msg == SEND_CODE_SUCCESS );
-                    assert( other_rank == should_be_other_rank );
-
-                    HandleRecvlistComplete(i_recv);
-                }
-                else if( req_idx == req_recv_list_size_offset ){
-
-                    int other_rank = status.MPI_SOURCE;
-                    int tag = status.MPI_TAG;
-
-                    int sendlist_size = recv_list_size_buffer;
-
-                    Say("Received recvlist size from %d, length %d, yag %d", other_rank, sendlist_size, tag );
-
-                    if( tag != TAG_LIST_SIZE ){
-                        assert(false);
-                    }
-
-                    if( receiving_recvlist_from.count(other_rank) ){
-                        Say("But already received from that node !!");
-                        continue;
-                        assert(false);
-                    }
-
-
-                    receiving_recvlist_from.insert( other_rank );
-                    emergent_recv_list_size[other_rank] = sendlist_size;
-
-                    // receive the lists too, in this phase
-                    // stay in the poll by not sending the confirmation yet
-
-                    auto Recv_Recvlist = [ &received_vectors_hashmap, &emergent_req_recv_list, &datatype ]( int other_rank, int sendlist_size ){
-                        // allocate a send list, directly
-                        // to get the received_list buffer
-                        auto &received_list = received_vectors_hashmap[other_rank];
-
-                        received_list.resize(sendlist_size);
-
-                        // also emergent entries
-                        auto &req = emergent_req_recv_list[other_rank];
-
-                        MPI_Irecv( received_list.data(), received_list.size(), datatype, other_rank, TAG_LIST_LIST, MPI_COMM_WORLD, &req );
-
-                        Say("Receiving recvlist from %d", other_rank);
-                    };
-                    Recv_Recvlist( other_rank, sendlist_size );
-
-
-                    // Also, since the recv completed, set up the recv for the next prospective connection
-                    Setup_Irecv_ListSize();
-                }
-                else{
-                    // why??
-                    assert(false);
+            if( !barrier_active ){
+                // all my lists are matched, then tell the others
+                int all_sent = 0;
+                MPI_Testall( send_reqs.size(), send_reqs.data(), &all_sent, MPI_STATUSES_IGNORE );
+                if( all_sent ){
+                    MPI_Ibarrier( MPI_COMM_WORLD, &barrier_req );
+                    barrier_active = true;
                 }
             }
-
-            // But also check from the recvlist-receiver-side (schedule)
-            for( auto &keyval : emergent_req_recv_list ){
-                const auto &other_rank = keyval.first;
-                auto &req_recv_list = keyval.second;
-
-                if( req_recv_list == MPI_REQUEST_NULL ) continue; // TODO eras finished ones, somehow
-
-                int flag = 0;
-                MPI_Status status;
-
-                MPI_Test( &req_recv_list, &flag, &status);
-                if( flag ){
-                    Say("Received recvlist from %d", other_rank);
-                    // reception complete
-
-                    // and send a confirmation
-                    auto Send_Recvlist_Confirmation = [ &SEND_CODE_SUCCESS, &use_Ssend, &emergent_req_send_confirm ]( int other_rank ){
-                        if( use_Ssend ){
-                            // sender is implicitly notified
-                        }
-                        else{
-                            MPI_Isend( &SEND_CODE_SUCCESS, 1, MPI_INT, other_rank, TAG_LIST_RECEIVED, MPI_COMM_WORLD, &emergent_req_send_confirm[ other_rank ]);
-                        };
-                    };
-                    Send_Recvlist_Confirmation( other_rank );
-
-                    // could do something inline with received lists, perhaps a functor LATER
-                }
-                else{
-                    // not ready, pass
-                }
+            else{
+                // everyone's lists are matched, so nothing is in flight anymore
+                int barrier_done = 0;
+                MPI_Test( &barrier_req, &barrier_done, MPI_STATUS_IGNORE );
+                if( barrier_done ) done = true;
             }
-
-
-            // perhaps yield some time CPU time/energy, in a cooperative application LATER
-
         }
 
-        // cancel the persistent random-origin recv, and cleanup all requests
-        MPI_Cancel( &own_req_list[req_recv_list_size_offset] );
-
-        // the rest is probably not necessary because no message should be flying, still cleanup
-        MPI_Waitall( own_req_list.size(), own_req_list.data(), MPI_STATUSES_IGNORE);
-        // and emergent sends, too
-        for( auto &keyval : emergent_req_send_confirm ){
-            auto &req = keyval.second;
-            MPI_Wait( &req, MPI_STATUS_IGNORE );
-        }
-        for( auto &keyval : emergent_req_recv_list ){
-            auto &req = keyval.second;
-            MPI_Wait( &req, MPI_STATUS_IGNORE );
-        }
-
-
-        Time tEnd = std::chrono::high_resolution_clock::now();
-        Say("Finished exchanging send lists in %f sec.", getSecs( tEnd, tStart ) );
-
-        // assert(false);
-
-        // and form the mirrors
+        Say("Finished exchanging send lists in %f sec.", exchange_timer.delta() );
     };
 
     if (engine_config.use_mpi) {
+        startup_phases.Add( "model: recvlists", recvlists_timer.delta() );
+
+        Timer exchange_timer;
         ExchangeLists( MPI_CHAR, recvlists_encoded, sendlists_encoded );
+        startup_phases.Add( "model: list exchange", exchange_timer.delta() );
+
+        Timer mirrors_timer;
 
         // dbg output encoded
         if( config.debug_netcode ){
@@ -7429,6 +8389,7 @@ bool GenerateModel(const Model &model, const SimulatorConfig &config, EngineConf
             auto &tab = tabs.                         global_tables_state_i64_arrays.back();
             // TODO pack the boolean vectors
             tab.resize( send_list.spike_sources.size(), 0);
+            send_list_impl.spike_mirror_size = send_list.spike_sources.size();
             // and add extra notification entries to the spike sources
             for( size_t i = 0; i < send_list.spike_sources.size() ; i++ ){
                 const auto &loc = send_list.spike_sources.at(i);
@@ -7442,6 +8403,16 @@ bool GenerateModel(const Model &model, const SimulatorConfig &config, EngineConf
         }
         // The final send buffer for these will be allocated at run time
 
+        // work items that use the received values and spikes have to wait for communication, every step
+        // find them from the tables they own; table ranges are consecutive and in order of work items
+        tabs.is_boundary_item.resize( tabs.callbacks.size(), 0 );
+        auto MarkBoundaryItem_FromTable = [ &tabs ]( const std::vector<long long> &global_table_index, long long table ){
+            auto it = std::upper_bound( global_table_index.begin(), global_table_index.end(), table );
+            work_t work_unit = ( it - global_table_index.begin() ) - 1;
+            assert( 0 <= work_unit && work_unit < (work_t)tabs.is_boundary_item.size() );
+            tabs.is_boundary_item[work_unit] = 1;
+        };
+
         // construct and remap for recv_lists
         for( const auto &keyval : recv_lists ){
             auto other_rank = keyval.first;
@@ -7467,6 +8438,7 @@ bool GenerateModel(const Model &model, const SimulatorConfig &config, EngineConf
                     TabEntryRef_Packed remapped_ref = GetEncodedTableEntryId( value_mirror_table, value_mirror_entry );
                     // printf("reff %llx -> %lld %d -> %llx, %zx %zx\n", ref_packed, ref.table, ref.entry, remapped_ref, tabs.global_tables_const_i64_arrays.size() , tabs.global_tables_const_i64_arrays[ref.table].size());
                     tabs.global_tables_const_i64_arrays[ref.table][ref.entry] = remapped_ref;
+                    MarkBoundaryItem_FromTable( tabs.global_table_const_i64_index, ref.table );
                 }
 
                 value_mirror_entry++;
@@ -7490,10 +8462,14 @@ bool GenerateModel(const Model &model, const SimulatorConfig &config, EngineConf
                 const auto &ref_list = keyval.second;
 
                 recv_list_impl.spike_destinations[spike_mirror_entry] = ref_list;
+                for( TabEntryRef_Packed ref_packed : ref_list ){
+                    MarkBoundaryItem_FromTable( tabs.global_table_state_i64_index, GetDecodedTableEntryId(ref_packed).table );
+                }
 
                 spike_mirror_entry++;
             }
         }
+        startup_phases.Add( "model: mirrors", mirrors_timer.delta() );
     }
 
     // MPI_Finalize();
@@ -7508,6 +8484,35 @@ bool GenerateModel(const Model &model, const SimulatorConfig &config, EngineConf
 
 
     tabs.create_consecutive_kernels_vector(config.skip_combining_consecutive_kernels);
+    tabs.create_work_item_sets();
+    startup_phases.Lap("model: work item sets");
+
+    // Breakdown of the setup time, from the top-level startup phases so far; for MPI, the spread over nodes shows how each phase scales
+    {
+        std::vector<const StartupPhases::Phase *> setup_phases;
+        std::vector<double> phase_times, phase_times_min, phase_times_max;
+        for( const auto &phase : startup_phases.phases ){
+            // sub-phases differ between nodes, the top-level ones are the same everywhere
+            if( phase.depth > 0 ) continue;
+            setup_phases.push_back( &phase );
+            phase_times.push_back( phase.seconds );
+        }
+        phase_times_min = phase_times_max = phase_times;
+        int nodes = 1;
+#ifdef USE_MPI
+        if( engine_config.use_mpi ){
+            nodes = engine_config.my_mpi.world_size;
+            MPI_Reduce( phase_times.data(), phase_times_min.data(), (int)phase_times.size(), MPI_DOUBLE, MPI_MIN, 0, MPI_COMM_WORLD );
+            MPI_Reduce( phase_times.data(), phase_times_max.data(), (int)phase_times.size(), MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD );
+        }
+#endif
+        if( !engine_config.use_mpi || engine_config.my_mpi.rank == 0 ){
+            printf("Setup time breakdown over %d nodes (min / max sec.):\n", nodes);
+            for( size_t i = 0; i < setup_phases.size(); i++ ){
+                printf("\t%-32s %10.4lf %10.4lf\n", setup_phases[i]->name.c_str(), phase_times_min[i], phase_times_max[i]);
+            }
+        }
+    }
 
     // yay!
     printf("instantiation complete!\n");
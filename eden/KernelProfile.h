@@ -0,0 +1,241 @@
+#ifndef KERNELPROFILE_H
+#define KERNELPROFILE_H
+
+// Opt-in profiling of the work items run on each step: time per consecutive kernel and per cell type,
+// with an estimate of the memory traffic each instance causes.
+// Only a pair of timestamps is taken per run of consecutive work items of the same kernel,
+// so it is cheap enough to leave on for production runs.
+// Hardware counters can also be read around each run, at the cost of two system calls per run.
+
+#include <chrono>
+#include "Common.h"
+#include "RawTables.h"
+#include "StateBuffers.h"
+#include "EngineConfig.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h> // for __rdtsc
+#endif
+
+struct KernelProfile{
+
+	// a run of consecutive work items with the same kernel and cell type
+	struct Group{
+		long long start_item;
+		long long n_items;
+		long long kind;
+		uint64_t ticks;
+		long long runs;
+		HardwareCounters::Values counters;
+	};
+	struct Kind{
+		std::string name;
+		long long instances;
+		int64_t bytes_per_step; // estimated, for all instances
+	};
+
+	std::vector<Group> groups;
+	std::vector<Kind> kinds;
+	std::vector<long long> group_of_item; // for each work unit
+	long long steps;
+	const HardwareCounters *counters; // to read around each run too, if not null
+
+	// to convert ticks to seconds at the end, whatever the tick source is
+	uint64_t ticks_start;
+	std::chrono::steady_clock::time_point time_start;
+
+	static inline uint64_t Ticks(){
+	#if defined(__x86_64__) || defined(__i386__)
+		return __rdtsc();
+	#else
+		return std::chrono::steady_clock::now().time_since_epoch().count();
+	#endif
+	}
+
+	KernelProfile(const RawTables &tabs, const StateBuffers &state, const EngineConfig &engine_config){
+		steps = 0;
+		counters = nullptr;
+
+		kinds.resize( tabs.work_item_kind_names.size() );
+		for( size_t i = 0; i < kinds.size(); i++ ) kinds[i] = { tabs.work_item_kind_names[i], 0, 0 };
+
+		const long long work_items = (long long) tabs.callbacks.size();
+		group_of_item.resize( work_items );
+		for( long long item = 0; item < work_items; item++ ){
+			const long long kind = ( item < (long long) tabs.work_item_kind.size() ) ? tabs.work_item_kind[item] : -1;
+			if( !groups.empty() && groups.back().kind == kind && tabs.callbacks[item] == tabs.callbacks[item-1] ){
+				groups.back().n_items++;
+			}
+			else groups.push_back( { item, 1, kind, 0, 0, HardwareCounters::Values() } );
+			group_of_item[item] = (long long) groups.size() - 1;
+			if( kind >= 0 && !tabs.is_part_item(item) ) kinds[kind].instances++;
+		}
+
+		// Estimate the bytes each work item reads and writes per step, from the extent of its part of the tables.
+		// The flat state and constant vectors, and the MPI mirror buffers, are appended after the tables of all work items.
+		size_t tables_const_f32_end = ( tabs.global_const_tabref >= 0 ) ? tabs.global_const_tabref : tabs.global_tables_const_f32_arrays.size();
+		size_t tables_state_f32_end = ( tabs.global_state_tabref >= 0 ) ? tabs.global_state_tabref : tabs.global_tables_state_f32_arrays.size();
+		size_t tables_const_i64_end = tabs.global_tables_const_i64_arrays.size();
+		size_t tables_state_i64_end = tabs.global_tables_state_i64_arrays.size();
+		for( const auto &keyval : engine_config.sendlist_impls ){
+			tables_state_i64_end = std::min( tables_state_i64_end, keyval.second.spike_mirror_buffer );
+		}
+
+		auto ItemRange = [ work_items ]( const std::vector<long long> &index, long long item, size_t end ){
+			size_t from = index[item];
+			size_t upto = ( item + 1 < work_items ) ? (size_t) index[item+1] : end;
+			return std::make_pair( from, std::max( from, upto ) );
+		};
+		auto TableBytes = [ &ItemRange ]( const std::vector<long long> &index, long long item, size_t end, const long long *sizes, size_t value_size ){
+			int64_t bytes = 0;
+			auto range = ItemRange( index, item, end );
+			for( size_t tab = range.first; tab < range.second; tab++ ) bytes += sizes[tab] * value_size;
+			return bytes;
+		};
+		for( long long item = 0; item < work_items; item++ ){
+			const long long kind = groups[group_of_item[item]].kind;
+			if( kind < 0 ) continue;
+
+			int64_t bytes = 0;
+			auto state_range = ItemRange( tabs.global_state_f32_index, item, state.state_one.size() );
+			auto const_range = ItemRange( tabs.global_const_f32_index, item, tabs.global_constants.size() );
+			// state is read from one buffer and written to the other
+			bytes += 2 * ( state_range.second - state_range.first ) * sizeof(float);
+			bytes += ( const_range.second - const_range.first ) * sizeof(float);
+			bytes += TableBytes( tabs.global_table_const_f32_index, item, tables_const_f32_end, state.global_tables_const_f32_sizes.data(), sizeof(float) );
+			bytes += TableBytes( tabs.global_table_const_i64_index, item, tables_const_i64_end, state.global_tables_const_i64_sizes.data(), sizeof(long long) );
+			bytes += 2 * TableBytes( tabs.global_table_state_f32_index, item, tables_state_f32_end, state.global_tables_state_f32_sizes.data(), sizeof(float) );
+			bytes += 2 * TableBytes( tabs.global_table_state_i64_index, item, tables_state_i64_end, state.global_tables_state_i64_sizes.data(), sizeof(long long) );
+			kinds[kind].bytes_per_step += bytes;
+		}
+
+		time_start = std::chrono::steady_clock::now();
+		ticks_start = Ticks();
+	}
+
+	// Run the given work items, timing each run of consecutive items of the same group.
+	// If parallel, the items are spread over the OpenMP threads as for a wave of split cells, and may run in any order;
+	// then each thread times its own runs, and the times of a group add up over the threads.
+	template< typename GetItem, typename RunItem >
+	void ExecuteTimed( size_t n_items, GetItem get_item, RunItem run_item, bool parallel = false ){
+		#pragma omp parallel if( parallel )
+		{
+			long long group = -1; // of the run in progress on this thread
+			uint64_t start = 0;
+			HardwareCounters::Values counts_before;
+			auto EndRun = [ & ](){
+				if( group < 0 ) return;
+				const uint64_t ticks = Ticks() - start;
+				HardwareCounters::Values counts_after;
+				const bool counted = counters && counters->ReadThread(counts_after);
+				#pragma omp critical(kernel_profile)
+				{
+					groups[group].ticks += ticks;
+					groups[group].runs++;
+					if( counted ) groups[group].counters += counts_after - counts_before;
+				}
+			};
+			#pragma omp for schedule(dynamic) nowait
+			for( size_t idx = 0; idx < n_items; idx++ ){
+				const long long item = get_item(idx);
+				if( group_of_item[item] != group ){
+					EndRun();
+					group = group_of_item[item];
+					if( counters ) counters->ReadThread(counts_before);
+					start = Ticks();
+				}
+				run_item(item);
+			}
+			EndRun();
+		}
+	}
+
+	void Report( FILE *fout, double run_time_sec, int mpi_rank, int mpi_ranks ) const {
+		const double elapsed_sec = std::chrono::duration<double>( std::chrono::steady_clock::now() - time_start ).count();
+		const uint64_t elapsed_ticks = Ticks() - ticks_start;
+		const double sec_per_tick = ( elapsed_ticks > 0 ) ? elapsed_sec / elapsed_ticks : 0;
+
+		std::vector<double> kind_seconds( kinds.size(), 0 );
+		std::vector<HardwareCounters::Values> kind_counters( kinds.size() );
+		double total_seconds = 0;
+		for( const auto &group : groups ){
+			double seconds = group.ticks * sec_per_tick;
+			total_seconds += seconds;
+			if( group.kind >= 0 ){
+				kind_seconds[group.kind] += seconds;
+				kind_counters[group.kind] += group.counters;
+			}
+		}
+		auto Percent = [ total_seconds ]( double seconds ){
+			return ( total_seconds > 0 ) ? 100 * seconds / total_seconds : 0.0;
+		};
+
+		std::string prefix = ( mpi_ranks > 1 ) ? "rank " + std::to_string(mpi_rank) + ": " : "";
+		fprintf(fout, "%sKernel profile: %lld steps, %.3lf sec in work items, of %.3lf sec run time\n",
+			prefix.c_str(), steps, total_seconds, run_time_sec);
+		// hardware counters are shown per instance per step, as well
+		auto PrintCountersHeader = [ this, fout ](){
+			if( !counters ) return;
+			fprintf(fout, " %8s", "IPC");
+			for( int i = 0; i < HardwareCounters::COUNTER_COUNT; i++ ){
+				if( i == HardwareCounters::INSTRUCTIONS ) continue;
+				fprintf(fout, " %22s", ( std::string(HardwareCounters::Name(i)) + "/instance" ).c_str());
+			}
+		};
+		auto PrintCounters = [ this, fout ]( const HardwareCounters::Values &values, double instance_steps ){
+			if( !counters ) return;
+			const int64_t cycles = values.counts[HardwareCounters::CYCLES];
+			const int64_t instructions = values.counts[HardwareCounters::INSTRUCTIONS];
+			if( cycles > 0 && instructions >= 0 ) fprintf(fout, " %8.3lf", (double) instructions / cycles);
+			else fprintf(fout, " %8s", "-");
+			for( int i = 0; i < HardwareCounters::COUNTER_COUNT; i++ ){
+				if( i == HardwareCounters::INSTRUCTIONS ) continue;
+				if( values.counts[i] >= 0 && instance_steps > 0 ) fprintf(fout, " %22.1lf", values.counts[i] / instance_steps);
+				else fprintf(fout, " %22s", "-");
+			}
+		};
+
+		fprintf(fout, "%s%-16s %10s %10s %7s %14s %14s %14s %10s", prefix.c_str(),
+			"cell type", "instances", "sec", "%", "usec/step", "nsec/instance", "bytes/instance", "GB/sec");
+		PrintCountersHeader();
+		fprintf(fout, "\n");
+		for( size_t i = 0; i < kinds.size(); i++ ){
+			const Kind &kind = kinds[i];
+			if( kind.instances == 0 ) continue;
+			double seconds = kind_seconds[i];
+			double per_step = steps ? seconds / steps : 0;
+			double bandwidth = ( seconds > 0 ) ? (double) kind.bytes_per_step * steps / seconds : 0;
+			fprintf(fout, "%s%-16s %10lld %10.4lf %7.2lf %14.3lf %14.1lf %14lld %10.3lf", prefix.c_str(),
+				kind.name.c_str(), kind.instances, seconds, Percent(seconds),
+				per_step * 1e6, per_step / kind.instances * 1e9,
+				(long long)( kind.bytes_per_step / kind.instances ), bandwidth * 1e-9 );
+			PrintCounters( kind_counters[i], (double) kind.instances * steps );
+			fprintf(fout, "\n");
+		}
+
+		// and the most expensive consecutive kernels, which show where the time of each cell type goes
+		const size_t MAX_GROUPS_SHOWN = 10;
+		std::vector<size_t> order( groups.size() );
+		for( size_t i = 0; i < order.size(); i++ ) order[i] = i;
+		std::sort( order.begin(), order.end(), [ this ]( size_t a, size_t b ){ return groups[a].ticks > groups[b].ticks; } );
+		if( order.size() > MAX_GROUPS_SHOWN ) order.resize( MAX_GROUPS_SHOWN );
+
+		fprintf(fout, "%s%-16s %21s %10s %7s %14s", prefix.c_str(),
+			"cell type", "work items", "sec", "%", "usec/run");
+		PrintCountersHeader();
+		fprintf(fout, "\n");
+		for( size_t i : order ){
+			const Group &group = groups[i];
+			double seconds = group.ticks * sec_per_tick;
+			std::string items = std::to_string(group.start_item) + "-" + std::to_string(group.start_item + group.n_items - 1);
+			fprintf(fout, "%s%-16s %21s %10.4lf %7.2lf %14.3lf", prefix.c_str(),
+				( group.kind >= 0 ) ? kinds[group.kind].name.c_str() : "?", items.c_str(),
+				seconds, Percent(seconds), group.runs ? seconds / group.runs * 1e6 : 0 );
+			PrintCounters( group.counters, (double) group.n_items * group.runs );
+			fprintf(fout, "\n");
+		}
+		fflush(fout);
+	}
+};
+
+#endif
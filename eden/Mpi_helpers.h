@@ -54,6 +54,60 @@ static void setup_mpi(int & argc, char ** & argv, EngineConfig* Engine) {
 struct MpiBuffers {
 private:
     bool actually_using_mpi = false;
+
+    static std::string NetMessage_ToString( size_t buf_value_len, const float *buf, size_t buf_size ){
+        std::string str;
+        for( size_t i = 0; i < buf_value_len; i++ ){
+            str += presentable_string( buf[i] ) + " ";
+        }
+        str += "| ";
+        for( size_t i = buf_value_len; i < buf_size; i++ ){
+            str += presentable_string( EncodeF32ToI32( buf[i] ) ) + " ";
+        }
+        return str;
+    }
+
+    // copy the values and deliver the spikes from another node
+    static void ReceiveList( const EngineConfig::RecvList_Impl &recvlist_impl, const float *values, const float *spikes, size_t spike_count, AbstractBackend * backend ){
+        Table_F32 * global_tables_stateNow_f32      = backend->host_tables_stateNow_f32();
+        Table_I64 * global_tables_stateNow_i64      = backend->host_tables_stateNow_i64();
+
+        // copy the continuous-time values
+        float *value_buf = global_tables_stateNow_f32[ recvlist_impl.value_mirror_buffer ];
+        // NB make sure these buffers are synchronized with CPU memory LATER
+        for( ptrdiff_t i = 0; i < recvlist_impl.value_mirror_size; i++ ){
+            value_buf[i] = values[i];
+
+            // global_state_now[ off + i] = buf[ value_buf_idx + i ];
+        }
+
+        // and deliver the spikes to trigger buffers
+        for( size_t i = 0; i < spike_count; i++ ){
+            int spike_pos = EncodeF32ToI32( spikes[i] );
+            for( auto tabent_packed : recvlist_impl.spike_destinations[spike_pos] ){
+                auto tabent = GetDecodedTableEntryId( tabent_packed );
+                // TODO packed bool buffers
+                global_tables_stateNow_i64[tabent.table][tabent.entry] = 1;
+            }
+        }
+
+        // all done with message
+    }
+
+    // For the neighbourhood collective, one buffer holds the messages for all adjacent nodes, at fixed places.
+    // Each message is laid out as [ values ... | spike count | spikes ... ], with room for every spike source to fire
+    bool use_neighbor_exchange = false;
+    MPI_Comm neighbor_comm = MPI_COMM_NULL;
+    std::vector<float> neighbor_send_buf;
+    std::vector<float> neighbor_recv_buf;
+    std::vector<int> neighbor_send_counts, neighbor_send_displs;
+    std::vector<int> neighbor_recv_counts, neighbor_recv_displs;
+    MPI_Request neighbor_request = MPI_REQUEST_NULL;
+
+    // the node-wide copies of constant tables, when shared
+    MPI_Comm shared_tables_comm = MPI_COMM_NULL;
+    MPI_Win shared_tables_win = MPI_WIN_NULL;
+
 public:
     typedef std::vector<float> SendRecvBuf;
     std::vector<int> send_off_to_node;
@@ -86,28 +140,197 @@ public:
             recv_bufs.emplace_back();
             // allocate as they come, why not
         }
+
+        if( engine_config.my_mpi.exchange == EngineConfig::MpiContext::EXCHANGE_NEIGHBOR ){
+            #if MPI_VERSION >= 3
+            use_neighbor_exchange = true;
+            #else
+            printf("Neighbourhood exchange needs MPI-3, this is MPI-%d; using probed messages instead\n", MPI_VERSION);
+            #endif
+        }
+        if( use_neighbor_exchange ){
+
+            // the most that can be sent each way is known from the lists, so everything is allocated once
+            int send_total = 0;
+            for( int other_rank : send_off_to_node ){
+                const auto &sendlist_impl = engine_config.sendlist_impls.at(other_rank);
+                int count = (int)( sendlist_impl.vpeer_positions_in_globstate.size() + sendlist_impl.daw_columns.size() + 1 + sendlist_impl.spike_mirror_size );
+                neighbor_send_counts.push_back( count );
+                neighbor_send_displs.push_back( send_total );
+                send_total += count;
+            }
+            int recv_total = 0;
+            for( int other_rank : recv_off_to_node ){
+                const auto &recvlist_impl = engine_config.recvlist_impls.at(other_rank);
+                int count = (int)( recvlist_impl.value_mirror_size + 1 + recvlist_impl.spike_destinations.size() );
+                neighbor_recv_counts.push_back( count );
+                neighbor_recv_displs.push_back( recv_total );
+                recv_total += count;
+            }
+            neighbor_send_buf.resize( send_total );
+            neighbor_recv_buf.resize( recv_total );
+
+            // the adjacency of the communication graph, in the same order as the buffers
+            #if MPI_VERSION >= 3
+            MPI_Dist_graph_create_adjacent( MPI_COMM_WORLD,
+                (int)recv_off_to_node.size(), recv_off_to_node.data(), MPI_UNWEIGHTED,
+                (int)send_off_to_node.size(), send_off_to_node.data(), MPI_UNWEIGHTED,
+                MPI_INFO_NULL, 0, &neighbor_comm );
+            #endif
+            printf("Neighbourhood exchange with %zd nodes to send to and %zd to receive from, %d and %d values at most\n", send_off_to_node.size(), recv_off_to_node.size(), send_total, recv_total);
+        }
+    }
+
+    // Replace constant tables that are identical across the ranks of a machine (or within a rank) with a single copy in shared memory.
+    // Must be called by all ranks, after the backend has been set up.
+    void share_const_tables(EngineConfig & engine_config, AbstractBackend * backend) {
+        if (!engine_config.use_mpi || !engine_config.my_mpi.share_const_tables) return;
+
+        // small tables are not worth the bother
+        const size_t MIN_SHARED_BYTES = 256;
+        const size_t SHARED_ALIGNMENT = 64;
+
+        StateBuffers &state = *backend->state;
+        RawTables &tabs = backend->tabs;
+
+        // candidate tables, by content
+        struct Candidate{
+            bool is_i64;
+            size_t table;
+            const char *data;
+            unsigned long long bytes;
+            unsigned long long hash;
+        };
+        std::vector<Candidate> candidates;
+        auto HashBytes = []( const char *data, size_t bytes ){
+            unsigned long long hash = 14695981039346656037ULL;
+            for( size_t i = 0; i < bytes; i++ ){
+                hash ^= (unsigned char) data[i];
+                hash *= 1099511628211ULL;
+            }
+            return hash;
+        };
+        for( size_t i = 0; i < state.global_tables_const_f32_arrays.size(); i++ ){
+            size_t bytes = state.global_tables_const_f32_sizes[i] * sizeof(float);
+            if( bytes < MIN_SHARED_BYTES ) continue;
+            const char *data = (const char *) state.global_tables_const_f32_arrays[i];
+            candidates.push_back( { false, i, data, bytes, HashBytes( data, bytes ) } );
+        }
+        for( size_t i = 0; i < state.global_tables_const_i64_arrays.size(); i++ ){
+            size_t bytes = state.global_tables_const_i64_sizes[i] * sizeof(long long);
+            if( bytes < MIN_SHARED_BYTES ) continue;
+            const char *data = (const char *) state.global_tables_const_i64_arrays[i];
+            candidates.push_back( { true, i, data, bytes, HashBytes( data, bytes ) } );
+        }
+
+        MPI_Comm_split_type( MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, engine_config.my_mpi.rank, MPI_INFO_NULL, &shared_tables_comm );
+        int node_rank, node_size;
+        MPI_Comm_rank( shared_tables_comm, &node_rank );
+        MPI_Comm_size( shared_tables_comm, &node_size );
+
+        // the first rank of the machine finds out which contents repeat, and where they go in the shared window
+        std::vector<unsigned long long> my_keys;
+        for( const auto &cand : candidates ){
+            my_keys.push_back( cand.hash );
+            my_keys.push_back( cand.bytes );
+        }
+        int my_key_count = (int) my_keys.size();
+        std::vector<int> key_counts( node_size ), key_displs( node_size, 0 );
+        MPI_Gather( &my_key_count, 1, MPI_INT, key_counts.data(), 1, MPI_INT, 0, shared_tables_comm );
+        for( int r = 1; r < node_size; r++ ) key_displs[r] = key_displs[r-1] + key_counts[r-1];
+        std::vector<unsigned long long> all_keys( node_rank == 0 ? key_displs.back() + key_counts.back() : 0 );
+        MPI_Gatherv( my_keys.data(), my_key_count, MPI_UNSIGNED_LONG_LONG, all_keys.data(), key_counts.data(), key_displs.data(), MPI_UNSIGNED_LONG_LONG, 0, shared_tables_comm );
+
+        // for each candidate: offset in the window (or -1, if unique) and whether it's the one to fill in the copy
+        std::vector<long long> all_places( all_keys.size() );
+        long long window_bytes = 0, tables_shared = 0, bytes_saved = 0;
+        if( node_rank == 0 ){
+            struct Content{
+                long long count = 0;
+                long long offset = -1; // in the window, once placed
+            };
+            std::map< std::pair<unsigned long long, unsigned long long>, Content > contents;
+            for( size_t i = 0; i < all_keys.size(); i += 2 ) contents[{ all_keys[i], all_keys[i+1] }].count++;
+            for( size_t i = 0; i < all_keys.size(); i += 2 ){
+                auto &content = contents.at({ all_keys[i], all_keys[i+1] });
+                if( content.count < 2 ){
+                    all_places[i] = -1;
+                    all_places[i+1] = 0;
+                    continue;
+                }
+                bool first = ( content.offset < 0 );
+                if( first ){
+                    content.offset = window_bytes;
+                    window_bytes += ( all_keys[i+1] + SHARED_ALIGNMENT - 1 ) / SHARED_ALIGNMENT * SHARED_ALIGNMENT;
+                }
+                else bytes_saved += all_keys[i+1];
+                all_places[i] = content.offset;
+                all_places[i+1] = first;
+                tables_shared++;
+            }
+        }
+        std::vector<long long> my_places( my_keys.size() );
+        MPI_Scatterv( all_places.data(), key_counts.data(), key_displs.data(), MPI_LONG_LONG, my_places.data(), my_key_count, MPI_LONG_LONG, 0, shared_tables_comm );
+
+        // allocate the window, all of it on the first rank of the machine
+        char *shared_base = nullptr;
+        MPI_Win_allocate_shared( node_rank == 0 ? window_bytes : 0, 1, MPI_INFO_NULL, shared_tables_comm, &shared_base, &shared_tables_win );
+        MPI_Aint shared_size;
+        int disp_unit;
+        MPI_Win_shared_query( shared_tables_win, 0, &shared_size, &disp_unit, &shared_base );
+
+        MPI_Win_fence( 0, shared_tables_win );
+        for( size_t c = 0; c < candidates.size(); c++ ){
+            if( my_places[2*c] >= 0 && my_places[2*c+1] ){
+                memcpy( shared_base + my_places[2*c], candidates[c].data, candidates[c].bytes );
+            }
+        }
+        MPI_Win_fence( 0, shared_tables_win );
+
+        // now point to the shared copies, and free the own ones
+        long long tables_replaced = 0;
+        for( size_t c = 0; c < candidates.size(); c++ ){
+            if( my_places[2*c] < 0 ) continue;
+            const auto &cand = candidates[c];
+            char *shared_copy = shared_base + my_places[2*c];
+            // the hash is only a hint, so make sure
+            if( memcmp( shared_copy, cand.data, cand.bytes ) != 0 ) continue;
+
+            if( cand.is_i64 ){
+                state.global_tables_const_i64_arrays[cand.table] = (Table_I64) shared_copy;
+                auto &own = tabs.global_tables_const_i64_arrays[cand.table];
+                own.clear(); own.shrink_to_fit();
+            }
+            else{
+                state.global_tables_const_f32_arrays[cand.table] = (Table_F32) shared_copy;
+                if( (long long)cand.table == tabs.global_const_tabref ){
+                    tabs.global_constants.clear(); tabs.global_constants.shrink_to_fit();
+                }
+                else{
+                    auto &own = tabs.global_tables_const_f32_arrays[cand.table];
+                    own.clear(); own.shrink_to_fit();
+                }
+            }
+            tables_replaced++;
+        }
+        // the backend has cached some of the pointers on init
+        backend->rebind_const_tables();
+
+        // and report once per machine, with the tables each rank now uses in shared memory
+        long long node_tables_replaced = 0;
+        MPI_Reduce( &tables_replaced, &node_tables_replaced, 1, MPI_LONG_LONG, MPI_SUM, 0, shared_tables_comm );
+        if( node_rank == 0 ){
+            printf("Shared constant tables: %lld tables across %d ranks on this machine, in %.3f MiB of shared memory, in place of %lld tables of the ranks, saving %.3f MiB\n", tables_shared, node_size, window_bytes / 1048576.0, node_tables_replaced, bytes_saved / 1048576.0 );
+        }
     }
 
     void init_communicate(EngineConfig & engine_config, AbstractBackend * backend, SimulatorConfig & config) {
         if (!engine_config.use_mpi) return;
 
         float     * global_state_now                = backend->host_state_now();
-        Table_F32 * global_tables_stateNow_f32      = backend->host_tables_stateNow_f32();
         Table_I64 * global_tables_stateNow_i64      = backend->host_tables_stateNow_i64();
         long long * global_tables_state_i64_sizes   = backend->host_tables_state_i64_sizes();
 
-        auto NetMessage_ToString = []( size_t buf_value_len, const auto &buf ){
-            std::string str;
-            for( size_t i = 0; i < buf_value_len; i++ ){
-                str += presentable_string( buf[i] ) + " ";
-            }
-            str += "| ";
-            for( size_t i = buf_value_len; i < buf.size(); i++ ){
-                str += presentable_string( EncodeF32ToI32( buf[i] ) ) + " ";
-            }
-            return str;
-        };
-
         // Send info needed by other nodes
         // TODO try parallelizing buffer fill, see if it improves latency
         for( size_t idx = 0; idx < send_off_to_node.size(); idx++ ){
@@ -159,92 +382,116 @@ public:
                 }
             }
             if( config.debug_netcode ){
-                Say("Send %d : %s", other_rank, NetMessage_ToString( buf_value_len, buf).c_str());
+                Say("Send %d : %s", other_rank, NetMessage_ToString( buf_value_len, buf.data(), buf.size() ).c_str());
             }
-            MPI_Isend( buf.data(), buf.size(), MPI_FLOAT, other_rank, MYMPI_TAG_BUF_SEND, MPI_COMM_WORLD, &req );
+
+            if( use_neighbor_exchange ){
+                // place in the common buffer, with the spike count in between
+                float *out = neighbor_send_buf.data() + neighbor_send_displs[idx];
+                std::copy( buf.begin(), buf.begin() + buf_value_len, out );
+                out[buf_value_len] = EncodeI32ToF32( (int32_t)( buf.size() - buf_value_len ) );
+                std::copy( buf.begin() + buf_value_len, buf.end(), out + buf_value_len + 1 );
+            }
+            else{
+                MPI_Isend( buf.data(), buf.size(), MPI_FLOAT, other_rank, MYMPI_TAG_BUF_SEND, MPI_COMM_WORLD, &req );
+            }
+        }
+
+        if( use_neighbor_exchange ){
+            // a single call for the whole exchange, no probing needed since the layout is fixed
+            #if MPI_VERSION >= 3
+            MPI_Ineighbor_alltoallv(
+                neighbor_send_buf.data(), neighbor_send_counts.data(), neighbor_send_displs.data(), MPI_FLOAT,
+                neighbor_recv_buf.data(), neighbor_recv_counts.data(), neighbor_recv_displs.data(), MPI_FLOAT,
+                neighbor_comm, &neighbor_request );
+            #endif
+            return;
         }
 
+        // get the recvs going for whatever has already arrived, the rest is picked up in complete_communicate
+        poll_receives(engine_config, backend, config);
+    }
+
+    // Probe, post and deliver pending recvs, without blocking. Returns whether all have been delivered for this step.
+    bool poll_receives(EngineConfig & engine_config, AbstractBackend * backend, SimulatorConfig & config) {
 
         // Recv info needed by this node
         auto PostRecv = [&config]( int other_rank, std::vector<float> &buf, MPI_Request &recv_req ){
             MPI_Irecv( buf.data(), buf.size(), MPI_FLOAT, other_rank, MYMPI_TAG_BUF_SEND, MPI_COMM_WORLD, &recv_req );
         };
-        auto ReceiveList = [ &engine_config, &global_tables_stateNow_f32, &global_tables_stateNow_i64 ]( const EngineConfig::RecvList_Impl &recvlist_impl, std::vector<float> &buf ){
-
-            // copy the continuous-time values
-            size_t value_buf_idx = 0;
-            float *value_buf = global_tables_stateNow_f32[ recvlist_impl.value_mirror_buffer ];
-            // NB make sure these buffers are synchronized with CPU memory LATER
-            for( ptrdiff_t i = 0; i < recvlist_impl.value_mirror_size; i++ ){
-                value_buf[i] = buf[ value_buf_idx + i ];
-
-                // global_state_now[ off + i] = buf[ value_buf_idx + i ];
+        bool all_received = true; // at least for the empty set examined before the loop
+        // TODO also try parallelizing this, perhaps?
+        for( size_t idx = 0; idx < recv_off_to_node.size(); idx++ ){
+            auto other_rank = recv_off_to_node.at(idx);
+            const auto &recvlist_impl = engine_config.recvlist_impls.at(other_rank);
+
+            if( received_sends[idx] ) continue;
+
+            // otherwise it's pending
+            all_received = false;
+
+            auto &buf = recv_bufs[idx];
+            auto &req = recv_requests[idx];
+
+            if( received_probes[idx] ){
+                // check if recv is done
+                int flag = 0;
+                MPI_Status status;
+                MPI_Test( &req, &flag, &status);
+                if( flag ){
+                    // received, yay !
+                    // Say("Recv %d.%zd", other_rank,  recvlist_impl.value_mirror_size);
+                    if( config.debug_netcode ){
+                        Say("Recv %d : %s", other_rank, NetMessage_ToString( recvlist_impl.value_mirror_size, buf.data(), buf.size() ).c_str());
+                    }
+                    ReceiveList( recvlist_impl, buf.data(), buf.data() + recvlist_impl.value_mirror_size, buf.size() - recvlist_impl.value_mirror_size, backend );
+                    received_sends[idx] = true;
+                }
             }
-
-            // and deliver the spikes to trigger buffers
-            for( int i = recvlist_impl.value_mirror_size; i < (int)buf.size(); i++ ){
-                int spike_pos = EncodeF32ToI32( buf[i] );
-                for( auto tabent_packed : recvlist_impl.spike_destinations[spike_pos] ){
-                    auto tabent = GetDecodedTableEntryId( tabent_packed );
-                    // TODO packed bool buffers
-                    global_tables_stateNow_i64[tabent.table][tabent.entry] = 1;
+            else{
+                // check if probe is ready
+                int flag = 0;
+                MPI_Status status;
+                MPI_Iprobe( other_rank, MYMPI_TAG_BUF_SEND, MPI_COMM_WORLD, &flag, &status);
+                if( flag ){
+                    int buf_size;
+                    MPI_Get_count( &status, MPI_FLOAT, &buf_size );
+                    buf.resize( buf_size );
+                    PostRecv( other_rank, buf, req );
+                    received_probes[idx] = true;
                 }
             }
 
-            // all done with message
-        };
-        // TODO min_delay option when no gap junctions exist
-        // Also wait for recvs to finish
-        // Spin it all, to probe for multimple incoming messages
-        bool all_received = true;
-        do{
-            all_received = true; // at least for the empty set examined before the loop
-            // TODO also try parallelizing this, perhaps?
+        }
+        return all_received;
+    }
+
+    // Wait for the remaining recvs, so that work items on the boundary can use the values and spikes of other nodes
+    void complete_communicate(EngineConfig & engine_config, AbstractBackend * backend, SimulatorConfig & config) {
+        if (!engine_config.use_mpi) return;
+
+        if( use_neighbor_exchange ){
+            MPI_Wait( &neighbor_request, MPI_STATUS_IGNORE );
             for( size_t idx = 0; idx < recv_off_to_node.size(); idx++ ){
                 auto other_rank = recv_off_to_node.at(idx);
                 const auto &recvlist_impl = engine_config.recvlist_impls.at(other_rank);
 
-                if( received_sends[idx] ) continue;
-
-                // otherwise it's pending
-                all_received = false;
-
-                auto &buf = recv_bufs[idx];
-                auto &req = recv_requests[idx];
-
-                if( received_probes[idx] ){
-                    // check if recv is done
-                    int flag = 0;
-                    MPI_Status status;
-                    MPI_Test( &req, &flag, &status);
-                    if( flag ){
-                        // received, yay !
-                        // Say("Recv %d.%zd", other_rank,  recvlist_impl.value_mirror_size);
-                        if( config.debug_netcode ){
-                            Say("Recv %d : %s", other_rank, NetMessage_ToString( recvlist_impl.value_mirror_size, buf).c_str());
-                        }
-                        ReceiveList( recvlist_impl, buf );
-                        received_sends[idx] = true;
-                    }
+                const float *in = neighbor_recv_buf.data() + neighbor_recv_displs[idx];
+                size_t spike_count = EncodeF32ToI32( in[recvlist_impl.value_mirror_size] );
+                if( config.debug_netcode ){
+                    Say("Recv %d : %s", other_rank, NetMessage_ToString( recvlist_impl.value_mirror_size + 1, in, recvlist_impl.value_mirror_size + 1 + spike_count ).c_str());
                 }
-                else{
-                    // check if probe is ready
-                    int flag = 0;
-                    MPI_Status status;
-                    MPI_Iprobe( other_rank, MYMPI_TAG_BUF_SEND, MPI_COMM_WORLD, &flag, &status);
-                    if( flag ){
-                        int buf_size;
-                        MPI_Get_count( &status, MPI_FLOAT, &buf_size );
-                        buf.resize( buf_size );
-                        PostRecv( other_rank, buf, req );
-                        received_probes[idx] = true;
-                    }
-                }
-
+                ReceiveList( recvlist_impl, in, in + recvlist_impl.value_mirror_size + 1, spike_count, backend );
             }
+            return;
+        }
+
+        // TODO min_delay option when no gap junctions exist
+        // Spin it all, to probe for multimple incoming messages
+        while( !poll_receives(engine_config, backend, config) ){
             // MPI_Finalize();
             // 	exit(1);
-        } while( !all_received );
+        }
         // and clear the progress flags
         received_probes.assign( received_probes.size(), false );
         received_sends .assign( received_sends .size(), false );
@@ -252,6 +499,8 @@ public:
 
     void finish_communicate(EngineConfig & engine_config) {
         if (!engine_config.use_mpi) return;
+        // the neighbourhood exchange is already complete, sends included
+        if( use_neighbor_exchange ) return;
         // wait for sends, to finish the iteration
         MPI_Waitall( send_requests.size(), send_requests.data(), MPI_STATUSES_IGNORE );
     }
@@ -259,6 +508,9 @@ public:
     ~MpiBuffers () {
         // this is necessary, so stdio files are actually flushed
         if (actually_using_mpi) {
+            if( neighbor_comm != MPI_COMM_NULL ) MPI_Comm_free( &neighbor_comm );
+            if( shared_tables_win != MPI_WIN_NULL ) MPI_Win_free( &shared_tables_win );
+            if( shared_tables_comm != MPI_COMM_NULL ) MPI_Comm_free( &shared_tables_comm );
             MPI_Finalize();
         }
     }
@@ -266,7 +518,9 @@ public:
 #else
 struct MpiBuffers {
     explicit MpiBuffers(EngineConfig & engine_config) {}
+    void share_const_tables(EngineConfig & engine_config, AbstractBackend * backend) {}
     void init_communicate(EngineConfig & engine_config, AbstractBackend * backend, SimulatorConfig & config) {}
+    void complete_communicate(EngineConfig & engine_config, AbstractBackend * backend, SimulatorConfig & config) {}
     void finish_communicate(EngineConfig & engine_config) {}
 };
 #endif
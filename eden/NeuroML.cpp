@@ -10,6 +10,10 @@
 #include <sys/stat.h>
 #include <errno.h>
 #include <ctype.h>
+#if !defined _WIN32
+#include <sys/mman.h>
+#include <fcntl.h>
+#endif
 
 //------------------> Auxiliaries
 
@@ -58,6 +62,36 @@ struct NmlFileContext{
 	
 	pugi::xml_document doc;
 	// TODO add a offset <-> source line cache, to not scan the file over and over
+	
+	// The contents of bulky network elements (populations, projections, input lists) are not loaded into the DOM,
+	// they are cut out of the text and streamed from the file in pieces when the network is parsed, to bound memory usage.
+	struct StreamedBody{
+		ptrdiff_t dom_offset; // of the element whose contents were cut out, as in xml_node::offset_debug()
+		ptrdiff_t dom_cut; // where the contents would start in the DOM text
+		ptrdiff_t file_begin, file_end; // where the contents are in the file
+		ptrdiff_t removed; // total size of contents cut out of the DOM text up to and including this element
+	};
+	std::vector<StreamedBody> streamed_bodies; // in file order
+	
+	// where the DOM text starts in the file, for pieces of a file
+	ptrdiff_t offset_base = 0;
+	// the text the DOM was loaded from in place, if not managed by pugixml
+	std::string dom_text;
+	
+	const StreamedBody *GetStreamedBody( ptrdiff_t dom_offset ) const {
+		auto it = std::lower_bound( streamed_bodies.begin(), streamed_bodies.end(), dom_offset,
+			[]( const StreamedBody &body, ptrdiff_t offset ){ return body.dom_offset < offset; } );
+		if( it == streamed_bodies.end() || it->dom_offset != dom_offset ) return NULL;
+		return &*it;
+	}
+	// translate an offset in the DOM text to an offset in the file
+	ptrdiff_t FileOffset( ptrdiff_t dom_offset ) const {
+		if( dom_offset < 0 ) return dom_offset;
+		auto it = std::upper_bound( streamed_bodies.begin(), streamed_bodies.end(), dom_offset,
+			[]( ptrdiff_t offset, const StreamedBody &body ){ return offset < body.dom_cut; } );
+		ptrdiff_t removed = ( it == streamed_bodies.begin() ) ? 0 : (it - 1)->removed;
+		return offset_base + dom_offset + removed;
+	}
 };
 struct NmlImportContext{
 	std::list<NmlFileContext> documents_opened;
@@ -72,7 +106,8 @@ struct NmlImportContext{
 //The object handling smart logging, with references to the specific point in the specific file being referred to in the log entry
 struct ImportLogger{
 	
-	const NmlImportContext &import_context;
+	// not const, because pieces of streamed elements are registered while being parsed
+	NmlImportContext &import_context;
 	FILE *error_log;
 	
 	// control this one from general logging, why not?
@@ -80,25 +115,32 @@ struct ImportLogger{
 	
 	// keep a line position cache for multiple warnings, instead of bailing out LATER
 	
-	ImportLogger(const NmlImportContext &_import, FILE *_error_log = stderr, bool _debug = false)
+	ImportLogger(NmlImportContext &_import, FILE *_error_log = stderr, bool _debug = false)
 	: import_context(_import), error_log(_error_log), debug_printing(_debug) {  }
 	
 	// NOTE since only the DOM element pointer can determine the opened file, the DOM trees should be kept in ptr-preserving containers (like std::list)
 	
-	// get filename from XML element, NULL if missing/unknown
-	const char *GetFilenameFromElement( const pugi::xml_node &node ) const {
-		const char *filename = NULL;
+	// get file context from XML element, NULL if missing/unknown
+	const NmlFileContext *GetFileFromElement( const pugi::xml_node &node ) const {
 		const void *context_key = node.root().internal_object();
 		//printf("Retrieve key %p\n",context_key);
-		if(import_context.files_by_root_element.count(context_key)){
-			filename = import_context.files_by_root_element.at(context_key)->filename.c_str();
-		}
-		return filename;		
+		auto it = import_context.files_by_root_element.find(context_key);
+		if( it == import_context.files_by_root_element.end() ) return NULL;
+		return it->second;
+	}
+	// get filename from XML element, NULL if missing/unknown
+	const char *GetFilenameFromElement( const pugi::xml_node &node ) const {
+		const NmlFileContext *file = GetFileFromElement(node);
+		if( !file ) return NULL;
+		return file->filename.c_str();
 	}
 	
 	// LATER maybe add RAII context stack (e.g. in file, in segment, ...)
 	void _doit(const pugi::xml_node &node, const char *format, va_list args) const {
-		ReportErrorInFile_Base(error_log, GetFilenameFromElement(node), node.offset_debug(), format, args);
+		const NmlFileContext *file = GetFileFromElement(node);
+		ptrdiff_t offset = node.offset_debug();
+		if( file ) offset = file->FileOffset(offset);
+		ReportErrorInFile_Base(error_log, file ? file->filename.c_str() : NULL, offset, format, args);
 	}
 	void error(const pugi::xml_node &node, const char *format, ...) const {
 		va_list args;
@@ -119,6 +161,313 @@ struct ImportLogger{
 	}
 };
 
+// Just enough of an XML scanner to find where elements begin and end, without building a DOM.
+// Well-formedness is checked later on by pugixml, when each part is actually loaded.
+struct XmlSkimToken{
+	enum Kind{ TEXT, START, END, OTHER }; // OTHER being comments, CDATA, processing instructions and DTD stuff
+	Kind kind;
+	size_t length;
+	size_t name_begin, name_length; // for START and END, relative to the start of the token
+	bool self_closing;
+};
+// Returns 1 if a token was found, 0 if more text is needed to complete it, -1 if the markup is broken
+static int SkimXmlToken( const char *p, const char *end, bool at_eof, XmlSkimToken &tok ){
+	tok.kind = XmlSkimToken::OTHER;
+	tok.name_begin = tok.name_length = 0;
+	tok.self_closing = false;
+	
+	const int NEED_MORE = ( at_eof ? -1 : 0 );
+	
+	if( *p != '<' ){
+		// text may be split anywhere, it is kept as is anyway
+		const char *next = (const char *) memchr( p, '<', end - p );
+		tok.kind = XmlSkimToken::TEXT;
+		tok.length = ( next ? next : end ) - p;
+		return 1;
+	}
+	if( end - p < 2 ) return NEED_MORE;
+	
+	if( p[1] != '!' && p[1] != '?' ){
+		// an element tag, by far the most common case
+		bool is_end = ( p[1] == '/' );
+		tok.kind = is_end ? XmlSkimToken::END : XmlSkimToken::START;
+		tok.name_begin = is_end ? 2 : 1;
+		const char *q = p + tok.name_begin;
+		while( q < end && *q > ' ' && *q != '/' && *q != '>' ) q++;
+		tok.name_length = q - ( p + tok.name_begin );
+		
+		for( ; q < end; q++ ){
+			if( *q == '>' ) break;
+			if( *q == '"' || *q == '\'' ){
+				// skip attribute value
+				const char *closing_quote = (const char *) memchr( q + 1, *q, end - ( q + 1 ) );
+				if( !closing_quote ) return NEED_MORE;
+				q = closing_quote;
+			}
+		}
+		if( q == end ) return NEED_MORE;
+		if( tok.name_length == 0 ) return -1;
+		
+		tok.length = ( q + 1 ) - p;
+		tok.self_closing = ( !is_end && q[-1] == '/' );
+		return 1;
+	}
+	
+	auto StartsWith = [ p, end ]( const char *prefix ){
+		size_t len = strlen(prefix);
+		return (size_t)( end - p ) >= len && memcmp( p, prefix, len ) == 0;
+	};
+	auto SkipPast = [ p, end, &tok ]( size_t from, const char *terminator ){
+		const char *found = std::search( p + from, end, terminator, terminator + strlen(terminator) );
+		if( found == end ) return false;
+		tok.length = ( found + strlen(terminator) ) - p;
+		return true;
+	};
+	// the longest prefix to tell apart is <![CDATA[
+	if( end - p < 9 && !at_eof ) return 0;
+	
+	if( StartsWith("<!--") ){
+		return SkipPast( 4, "-->" ) ? 1 : NEED_MORE;
+	}
+	else if( StartsWith("<![CDATA[") ){
+		return SkipPast( 9, "]]>" ) ? 1 : NEED_MORE;
+	}
+	else if( StartsWith("<?") ){
+		return SkipPast( 2, "?>" ) ? 1 : NEED_MORE;
+	}
+	else{
+		// DOCTYPE and friends, which may contain an internal subset in brackets
+		int brackets = 0; char quote = 0;
+		for( const char *q = p + 2; q < end; q++ ){
+			if( quote ){ if( *q == quote ) quote = 0; }
+			else if( *q == '"' || *q == '\'' ) quote = *q;
+			else if( *q == '[' ) brackets++;
+			else if( *q == ']' ) brackets--;
+			else if( *q == '>' && brackets <= 0 ){
+				tok.length = ( q + 1 ) - p;
+				return 1;
+			}
+		}
+		return NEED_MORE;
+	}
+}
+
+static bool SeekFile( FILE *fp, ptrdiff_t offset ){
+	#if defined _WIN32
+	return _fseeki64( fp, offset, SEEK_SET ) == 0;
+	#else
+	return fseeko( fp, offset, SEEK_SET ) == 0;
+	#endif
+}
+
+const size_t XML_STREAM_BLOCK_SIZE = 1 << 20; // how much of the file is read at a time
+const size_t XML_STREAM_PIECE_SIZE = 4 << 20; // how much of a streamed element is loaded in the DOM at a time
+
+// Load a NeuroML file in the DOM, except for the contents of the bulky network elements, see NmlFileContext::StreamedBody
+static pugi::xml_parse_result LoadNmlFileSkeleton( NmlFileContext &cx ){
+	
+	auto LoadWholeFile = [ &cx ](){
+		cx.streamed_bodies.clear();
+		cx.dom_text.clear();
+		return cx.doc.load_file( cx.filename.c_str() );
+	};
+	
+	// the elements whose contents are streamed, when they are directly under a network
+	static const std::set<std::string> streamed_element_names = {
+		"population",
+		"projection",
+		"electricalProjection",
+		"continuousProjection",
+		"inputList",
+	};
+	// the names of the elements currently open, one after the other
+	std::string open_names;
+	std::vector<size_t> open_name_lengths;
+	auto TopNameIs = [ &open_names, &open_name_lengths ]( const char *name, size_t name_length ){
+		return !open_name_lengths.empty() && open_name_lengths.back() == name_length
+			&& memcmp( open_names.data() + open_names.size() - name_length, name, name_length ) == 0;
+	};
+	
+	FILE *fp = fopen( cx.filename.c_str(), "rb" );
+	if( !fp ) return LoadWholeFile(); // and let pugixml complain
+	
+	std::string &skeleton = cx.dom_text; // the text that goes into the DOM
+	std::string pending; // the text read but not scanned yet
+	ptrdiff_t pending_file_offset = 0;
+	
+	bool streaming = false;
+	size_t streamed_element_depth = 0;
+	NmlFileContext::StreamedBody body;
+	ptrdiff_t removed = 0;
+	
+	bool ok = true;
+	bool at_eof = false;
+	while( ok && !at_eof ){
+		size_t old_size = pending.size();
+		pending.resize( old_size + XML_STREAM_BLOCK_SIZE );
+		size_t got = fread( &pending[old_size], 1, XML_STREAM_BLOCK_SIZE, fp );
+		pending.resize( old_size + got );
+		if( ferror(fp) ){ ok = false; break; }
+		at_eof = ( got < XML_STREAM_BLOCK_SIZE );
+		
+		if( pending_file_offset == 0 && pending.size() >= 2 ){
+			// the scanner only understands encodings that are supersets of ASCII, leave the rest to pugixml
+			if( pending[0] == '\0' || pending[1] == '\0' || (unsigned char)pending[0] == 0xFE || (unsigned char)pending[0] == 0xFF ){
+				ok = false; break;
+			}
+		}
+		
+		size_t pos = 0;
+		size_t kept = 0; // the text before this point is already in the skeleton, or cut out
+		while( pos < pending.size() ){
+			XmlSkimToken tok;
+			int ret = SkimXmlToken( pending.data() + pos, pending.data() + pending.size(), at_eof, tok );
+			if( ret == 0 ) break;
+			if( ret < 0 ){ ok = false; break; }
+			
+			const char *token = pending.data() + pos;
+			ptrdiff_t token_file_offset = pending_file_offset + pos;
+			const char *name = token + tok.name_begin;
+			
+			if( tok.kind == XmlSkimToken::START && !tok.self_closing ){
+				if(
+					!streaming
+					&& ( TopNameIs( "network", 7 ) || TopNameIs( "networkWithTemperature", 22 ) )
+					&& streamed_element_names.count( std::string( name, tok.name_length ) )
+				){
+					streaming = true;
+					streamed_element_depth = open_name_lengths.size();
+					skeleton.append( pending, kept, pos + tok.length - kept );
+					body.dom_offset = skeleton.size() - tok.length + tok.name_begin;
+					body.file_begin = token_file_offset + tok.length;
+				}
+				open_names.append( name, tok.name_length );
+				open_name_lengths.push_back( tok.name_length );
+			}
+			else if( tok.kind == XmlSkimToken::END ){
+				// tags must match, otherwise the body of a streamed element could not be found reliably
+				if( !TopNameIs( name, tok.name_length ) ){
+					ok = false; break;
+				}
+				open_names.resize( open_names.size() - tok.name_length );
+				open_name_lengths.pop_back();
+				
+				if( streaming && open_name_lengths.size() == streamed_element_depth ){
+					// reached the end of the streamed element
+					body.dom_cut = skeleton.size();
+					body.file_end = token_file_offset;
+					removed += body.file_end - body.file_begin;
+					body.removed = removed;
+					cx.streamed_bodies.push_back(body);
+					streaming = false;
+					kept = pos;
+				}
+			}
+			
+			pos += tok.length;
+			if( streaming ) kept = pos;
+		}
+		if( !streaming ) skeleton.append( pending, kept, pos - kept );
+		
+		pending.erase( 0, pos );
+		pending_file_offset += pos;
+	}
+	fclose(fp);
+	
+	// if anything looks off, the DOM parser will have to explain what the problem is
+	if( !ok || streaming || !pending.empty() ) return LoadWholeFile();
+	
+	return cx.doc.load_buffer_inplace( &skeleton[0], skeleton.size() );
+}
+
+// Iterate over the child nodes of an element, even if its contents were left out of the DOM to be streamed.
+// Streamed child nodes are only valid while the callback runs. Returns false if the callback did, or on I/O errors
+template< typename Callback >
+static bool ForEachChildNode( const ImportLogger &log, const pugi::xml_node &eParent, Callback callback ){
+	const NmlFileContext *file = log.GetFileFromElement(eParent);
+	const NmlFileContext::StreamedBody *body = NULL;
+	if( file ) body = file->GetStreamedBody( eParent.offset_debug() );
+	if( !body ){
+		for( const auto &eChild : eParent.children() ){
+			if( !callback(eChild) ) return false;
+		}
+		return true;
+	}
+	
+	FILE *fp = fopen( file->filename.c_str(), "rb" );
+	if( !fp || !SeekFile( fp, body->file_begin ) ){
+		log.error(eParent, "could not read contents of <%s>: %s", eParent.name(), strerror(errno));
+		if( fp ) fclose(fp);
+		return false;
+	}
+	
+	// each piece of the contents is loaded in its own DOM, registered for error reporting while in use
+	NmlFileContext piece;
+	piece.filename = file->filename;
+	const void *piece_key = piece.doc.root().internal_object();
+	log.import_context.files_by_root_element.insert( std::make_pair( piece_key, &piece ) );
+	
+	auto StreamPieces = [ & ](){
+		std::string pending;
+		ptrdiff_t pending_file_offset = body->file_begin;
+		ptrdiff_t left_to_read = body->file_end - body->file_begin;
+		size_t scanned = 0; // how much of the pending text has been scanned
+		size_t boundary = 0; // last point between top-level child nodes, up to which the text can be loaded
+		int depth = 0;
+		
+		while( true ){
+			size_t to_read = std::min( (ptrdiff_t) XML_STREAM_BLOCK_SIZE, left_to_read );
+			size_t old_size = pending.size();
+			pending.resize( old_size + to_read );
+			if( fread( &pending[old_size], 1, to_read, fp ) != to_read ){
+				log.error(eParent, "could not read contents of <%s>: %s", eParent.name(), ferror(fp) ? strerror(errno) : "file changed while reading");
+				return false;
+			}
+			left_to_read -= to_read;
+			bool at_end = ( left_to_read <= 0 );
+			
+			while( scanned < pending.size() ){
+				XmlSkimToken tok;
+				int ret = SkimXmlToken( pending.data() + scanned, pending.data() + pending.size(), at_end, tok );
+				if( ret == 0 ) break;
+				if( ret < 0 ){
+					ReportErrorInFile( log.error_log, file->filename.c_str(), pending_file_offset + scanned, "malformed markup in contents of <%s>", eParent.name() );
+					return false;
+				}
+				if( tok.kind == XmlSkimToken::START && !tok.self_closing ) depth++;
+				if( tok.kind == XmlSkimToken::END ) depth--;
+				scanned += tok.length;
+				if( depth <= 0 ) boundary = scanned;
+			}
+			
+			if( at_end ) boundary = pending.size(); // and let the DOM parser complain about anything left open
+			if( boundary > 0 && ( boundary >= XML_STREAM_PIECE_SIZE || at_end ) ){
+				piece.offset_base = pending_file_offset;
+				pugi::xml_parse_result result = piece.doc.load_buffer( pending.data(), boundary, pugi::parse_default | pugi::parse_fragment );
+				if( !result ){
+					ReportErrorInFile( log.error_log, piece.filename.c_str(), piece.FileOffset(result.offset), "Could not parse contents of <%s>: %s", eParent.name(), result.description() );
+					return false;
+				}
+				for( const auto &eChild : piece.doc.children() ){
+					if( !callback(eChild) ) return false;
+				}
+				piece.doc.reset();
+				
+				pending.erase( 0, boundary );
+				pending_file_offset += boundary;
+				scanned -= boundary;
+				boundary = 0;
+			}
+			if( at_end ) return true;
+		}
+	};
+	bool ok = StreamPieces();
+	
+	log.import_context.files_by_root_element.erase(piece_key);
+	fclose(fp);
+	return ok;
+}
+
 //------------------> XML Utilities end
 
 //------------------> Dimensions
@@ -1169,6 +1518,16 @@ bool ParseAcrossSegOrSegGroup(const ImportLogger &log, const pugi::xml_node &eAp
 	}
 }
 
+template<typename UnitType>
+const ScaleEntry *FindScale(const char *unit_name){
+	for( const auto &scale : Scales<UnitType>::scales ){
+		if(strcmp(unit_name, scale.name) == 0) return &scale;
+	}
+	return NULL;
+}
+// also for the tools that read NeuroML quantities, such as the connection table converter
+template const ScaleEntry *FindScale<Time>(const char *unit_name);
+
 //NeuroML physical quantities consist of a numeric, along with an unit name (such as meter, kilometer, etc.) qualifying the quantity the numeric represents. So NeuroML reader code has to check the unit name, to properly read the quantity.
 template<typename UnitType>
 bool ParseQuantity(const ImportLogger &log, const pugi::xml_node &eLocation, const char *attr_name,  Real &num){
@@ -1190,17 +1549,15 @@ bool ParseQuantity(const ImportLogger &log, const pugi::xml_node &eLocation, con
 	
 	//then get the scaling factor that applies, compared to SI units, for that unit name
 	auto native = Scales<UnitType>::native;
-	for( auto scale : Scales<UnitType>::scales ){
-		if(strcmp(unit_name, scale.name) == 0){
-			
-			num = scale.ConvertTo( pure_number, native );
-			//printf("valll %f\n",num);
-			return true;
-		}
+	const ScaleEntry *scale = FindScale<UnitType>(unit_name);
+	if(!scale){
+		//unit name not found in list!
+		log.error(eLocation, "unknown %s attribute type %s for %s", attr_name, unit_name, UnitType::NAME );
+		return false;
 	}
-	//unit name not found in list!
-	log.error(eLocation, "unknown %s attribute type %s for %s", attr_name, unit_name, UnitType::NAME );
-	return false;
+	num = scale->ConvertTo( pure_number, native );
+	//printf("valll %f\n",num);
+	return true;
 	
 }
 // specialize for unitless, lacking unit markup
@@ -2976,6 +3333,312 @@ bool ParseConnectionPrePost(const ImportLogger &log, const pugi::xml_node &eConn
 	return true;
 }
 
+// A file mapped in memory, read-only. Where mapping is not available, the file is just read in memory
+struct MappedFile{
+	const char *data;
+	size_t size;
+	
+	#if defined _WIN32
+	std::string contents;
+	#else
+	void *mapping;
+	#endif
+	
+	MappedFile(){
+		data = NULL; size = 0;
+		#if !defined _WIN32
+		mapping = NULL;
+		#endif
+	}
+	// sets errno on failure
+	bool open( const char *path ){
+		#if defined _WIN32
+		FILE *fp = fopen( path, "rb" );
+		if( !fp ) return false;
+		char buf[1 << 16];
+		size_t got;
+		while( ( got = fread( buf, 1, sizeof(buf), fp ) ) > 0 ) contents.append( buf, got );
+		bool ok = !ferror(fp);
+		fclose(fp);
+		if( !ok ) return false;
+		data = contents.data(); size = contents.size();
+		return true;
+		#else
+		int fd = ::open( path, O_RDONLY );
+		if( fd < 0 ) return false;
+		struct stat st;
+		if( fstat( fd, &st ) < 0 ){ ::close(fd); return false; }
+		size = st.st_size;
+		if( size > 0 ){
+			mapping = mmap( NULL, size, PROT_READ, MAP_PRIVATE, fd, 0 );
+			if( mapping == MAP_FAILED ){ mapping = NULL; ::close(fd); return false; }
+			madvise( mapping, size, MADV_SEQUENTIAL );
+		}
+		::close(fd);
+		data = (const char *) mapping;
+		return true;
+		#endif
+	}
+	~MappedFile(){
+		#if !defined _WIN32
+		if( mapping ) munmap( mapping, size );
+		#endif
+	}
+};
+
+// Find the 2D array of little-endian doubles, in C order, that is stored in a NumPy .npy file
+// https://numpy.org/doc/stable/reference/generated/numpy.lib.format.html
+static bool ReadNpyTable( const char *data, size_t size, size_t &rows, size_t &columns, const char *&table, const char *&problem ){
+	const char magic[] = "\x93NUMPY";
+	if( size < 10 || memcmp( data, magic, 6 ) != 0 ){
+		problem = "not a .npy file";
+		return false;
+	}
+	int major_version = (unsigned char) data[6];
+	size_t header_begin, header_length;
+	if( major_version == 1 ){
+		header_begin = 10;
+		header_length = (unsigned char) data[8] | ( (unsigned char) data[9] << 8 );
+	}
+	else if( ( major_version == 2 || major_version == 3 ) && size >= 12 ){
+		header_begin = 12;
+		header_length = (unsigned char) data[8] | ( (unsigned char) data[9] << 8 ) | ( (unsigned char) data[10] << 16 ) | ( (size_t)(unsigned char) data[11] << 24 );
+	}
+	else{
+		problem = "unsupported .npy format version";
+		return false;
+	}
+	if( header_begin + header_length > size ){
+		problem = "truncated .npy header";
+		return false;
+	}
+	// the header is the text of a Python dict, with the keys 'descr', 'fortran_order', 'shape'
+	std::string header( data + header_begin, header_length );
+	auto ValueOf = [ &header ]( const char *key ) -> const char * {
+		size_t pos = header.find( key );
+		if( pos == std::string::npos ) return NULL;
+		pos = header.find( ':', pos + strlen(key) );
+		if( pos == std::string::npos ) return NULL;
+		pos++;
+		while( pos < header.size() && isspace( header[pos] ) ) pos++;
+		return header.c_str() + pos;
+	};
+	
+	const char *descr = ValueOf("'descr'"), *fortran_order = ValueOf("'fortran_order'"), *shape = ValueOf("'shape'");
+	if( !( descr && fortran_order && shape ) ){
+		problem = "malformed .npy header";
+		return false;
+	}
+	if( strncmp( descr, "'<f8'", 5 ) != 0 ){
+		problem = "table should contain little-endian doubles (dtype '<f8')";
+		return false;
+	}
+	if( strncmp( fortran_order, "False", 5 ) != 0 ){
+		problem = "table should be in C order";
+		return false;
+	}
+	std::vector<size_t> dims;
+	if( *shape != '(' ){
+		problem = "malformed .npy shape";
+		return false;
+	}
+	const char *p = shape + 1;
+	while( true ){
+		while( isspace(*p) ) p++;
+		if( *p == ')' ) break;
+		char *pEnd;
+		errno = 0;
+		unsigned long long dim = strtoull( p, &pEnd, 10 );
+		if( errno || pEnd == p ){
+			problem = "malformed .npy shape";
+			return false;
+		}
+		dims.push_back( dim );
+		p = pEnd;
+		while( isspace(*p) ) p++;
+		if( *p == ',' ) p++;
+	}
+	if( dims.size() != 2 ){
+		problem = "table should be a 2D array";
+		return false;
+	}
+	rows = dims[0]; columns = dims[1];
+	
+	table = data + header_begin + header_length;
+	if( columns > 0 && rows > ( size - ( header_begin + header_length ) ) / sizeof(double) / columns ){
+		problem = "truncated .npy data";
+		return false;
+	}
+	return true;
+}
+
+// resolve a path that appears in a file, relative to the directory of that file unless it is absolute
+static std::string ResolvePathFromFile( const char *referring_filename, const char *path ){
+	bool is_absolute = ( path[0] == '/' );
+	#if defined _WIN32
+	is_absolute = is_absolute || path[0] == '\\' || ( path[0] && path[1] == ':' );
+	#endif
+	if( is_absolute || !referring_filename ) return path;
+	
+	std::string resolved = referring_filename;
+	size_t last_slash_pos = resolved.find_last_of(
+	#if defined _WIN32
+		"/\\"
+	#else
+		"/"
+	#endif
+	);
+	if( last_slash_pos == std::string::npos ) resolved.clear();
+	else resolved.resize( last_slash_pos + 1 );
+	return resolved + path;
+}
+
+// The cells a node keeps while reading a network, for the populations defined so far (see NetworkSlice)
+struct KeptCells{
+	bool whole = true;
+	long long first = 0, end = 0; // the GID's of the slice
+	std::vector<long long> pop_gid_start;
+	
+	KeptCells(){}
+	KeptCells( const NetworkSlice &slice, Network &net ){
+		whole = slice.Whole();
+		if( whole ) return;
+		pop_gid_start.assign( net.populations.contents.size() + 1, 0 );
+		for( size_t pop_seq = 0; pop_seq < net.populations.contents.size(); pop_seq++ ){
+			pop_gid_start[pop_seq + 1] = pop_gid_start[pop_seq] + net.populations.contents[pop_seq].instances.size();
+		}
+		long long total_cells = pop_gid_start.back();
+		first = NetworkSlice::SliceStart( total_cells, slice.total_nodes, slice.node );
+		end   = NetworkSlice::SliceStart( total_cells, slice.total_nodes, slice.node + 1 );
+		// the slices would shift if more populations came later, so this is checked when the model is laid out
+		net.kept_slice = slice;
+		if( net.kept_slice_total_cells < 0 ) net.kept_slice_total_cells = total_cells;
+	}
+	bool Keeps( Int pop_seq, Int cell_seq ) const {
+		if( whole ) return true;
+		long long gid = pop_gid_start[pop_seq] + cell_seq;
+		return first <= gid && gid < end;
+	}
+	bool Keeps( const Network::Projection &proj, const Network::Projection::Connection &conn ) const {
+		return Keeps( proj.presynapticPopulation, conn.preCell ) || Keeps( proj.postsynapticPopulation, conn.postCell );
+	}
+};
+
+// Load the connections of a projection from a binary table, in the .npy format of NumPy.
+// Each row is a connection, with the columns below. Cell and segment id's are as in NeuroML, fractions along may be NaN for the default 0.5,
+// weight and delay (in milliseconds) may be NaN when not used, as for connection types without weight or delay.
+// The synapse types are the same for all rows, and are specified on the table element as for single connections.
+bool ParseConnectionTable(const ImportLogger &log, const pugi::xml_node &eTable,
+	const Network::Population &pre, const Network::Population &post, const Morphology *pre_morph, const Morphology *post_morph,
+	const Network::Projection::Connection &prototype, const KeptCells &kept_cells, Network::Projection &proj
+){
+	enum Column{
+		ID, PRE_CELL, PRE_SEGMENT, PRE_FRACTION, POST_CELL, POST_SEGMENT, POST_FRACTION, WEIGHT, DELAY,
+		COLUMNS
+	};
+	
+	const char *href = eTable.attribute("href").value();
+	if( !*href ){
+		log.error(eTable, "connection table requires a href attribute");
+		return false;
+	}
+	std::string path = ResolvePathFromFile( log.GetFilenameFromElement(eTable), href );
+	
+	MappedFile file;
+	if( !file.open( path.c_str() ) ){
+		log.error(eTable, "error opening connection table %s : %s", path.c_str(), strerror(errno) );
+		return false;
+	}
+	size_t rows = 0, columns = 0;
+	const char *table = NULL;
+	const char *problem = NULL;
+	if( !ReadNpyTable( file.data, file.size, rows, columns, table, problem ) ){
+		log.error(eTable, "connection table %s: %s", path.c_str(), problem );
+		return false;
+	}
+	if( columns != COLUMNS ){
+		log.error(eTable, "connection table %s has %zd columns instead of %d: id, preCellId, preSegmentId, preFractionAlong, postCellId, postSegmentId, postFractionAlong, weight, delay", path.c_str(), columns, (int)COLUMNS );
+		return false;
+	}
+	
+	auto ToId = []( double value, Int &id ){
+		if(!( 0 <= value && value <= 9.0e15 && value == floor(value) )) return false;
+		id = (Int) value;
+		return true;
+	};
+	const ScaleEntry milliseconds = {"ms", -3, 1.0};
+	
+	if( kept_cells.whole ) proj.connections.reserve( proj.connections.size() + rows );
+	for( size_t row = 0; row < rows; row++ ){
+		double values[COLUMNS];
+		memcpy( values, table + row * sizeof(values), sizeof(values) ); // the table may not be aligned
+		
+		Network::Projection::Connection conn = prototype;
+		
+		Int id;
+		if( !ToId( values[ID], id ) ){
+			log.error(eTable, "connection table %s, row %zd: connection id must be a non-negative integer", path.c_str(), row );
+			return false;
+		}
+		if(proj.connections.hasId(id)){
+			log.error(eTable, "connection table %s, row %zd: connection %ld already defined", path.c_str(), row, id );
+			return false;
+		}
+		
+		auto GetCellAndSegment = [ & ]( const Network::Population &pop, const Morphology *morph, int cell_column, int segment_column, const char *sPosition, Int &cell_seq, Int &seg_seq ){
+			Int cellId, segId;
+			if( !ToId( values[cell_column], cellId ) ){
+				log.error(eTable, "connection table %s, row %zd: %s cell id must be a non-negative integer", path.c_str(), row, sPosition );
+				return false;
+			}
+			cell_seq = pop.instances.getSequential(cellId); //convert to sequential form
+			if( cell_seq < 0 ){
+				log.error(eTable, "connection table %s, row %zd: cell instance id %ld not present in %s population", path.c_str(), row, cellId, sPosition );
+				return false;
+			}
+			if( !ToId( values[segment_column], segId ) ){
+				log.error(eTable, "connection table %s, row %zd: %s segment id must be a non-negative integer", path.c_str(), row, sPosition );
+				return false;
+			}
+			if( morph ) seg_seq = morph->segments.getSequential(segId); //convert to sequential form
+			else seg_seq = ( segId == 0 ) ? 0 : -1; // artificial cell only has "fictitious" segment 0
+			if( seg_seq < 0 ){
+				log.error(eTable, "connection table %s, row %zd: segment id %ld not present in %s cell %ld", path.c_str(), row, segId, sPosition, cellId );
+				return false;
+			}
+			return true;
+		};
+		if( !GetCellAndSegment( pre , pre_morph , PRE_CELL , PRE_SEGMENT , "presynaptic" , conn.preCell , conn.preSegment  ) ) return false;
+		if( !GetCellAndSegment( post, post_morph, POST_CELL, POST_SEGMENT, "postsynaptic", conn.postCell, conn.postSegment ) ) return false;
+		
+		auto GetFractionAlong = [ & ]( int column, const char *sName, Real &fraction ){
+			if( std::isnan( values[column] ) ){
+				fraction = 0.5;
+				return true;
+			}
+			fraction = values[column];
+			if(!( 0 <= fraction && fraction <= 1.0 )){
+				log.error(eTable, "connection table %s, row %zd: %s not between 0 and 1", path.c_str(), row, sName );
+				return false;
+			}
+			return true;
+		};
+		if( !GetFractionAlong( PRE_FRACTION , "preFractionAlong" , conn.preFractionAlong  ) ) return false;
+		if( !GetFractionAlong( POST_FRACTION, "postFractionAlong", conn.postFractionAlong ) ) return false;
+		
+		// NaN if unused, just like the XML elements
+		conn.weight = values[WEIGHT];
+		if( !std::isnan( values[DELAY] ) ){
+			conn.delay = milliseconds.ConvertTo( values[DELAY], Scales<Time>::native );
+		}
+		
+		if( kept_cells.Keeps( proj, conn ) ) proj.connections.add(conn, id);
+		else proj.elide(conn, id);
+	}
+	
+	return true;
+}
+
 bool ParseLoggerBase(const ImportLogger &log, const pugi::xml_node &eLogger, Simulation::LoggerBase &logger){
 	
 	auto sFilename = eLogger.attribute("fileName").value();
@@ -3022,6 +3685,9 @@ struct ImportState{
 	
 	Int &target_simulation;
 	
+	// under MPI, the slice of the network this node keeps
+	NetworkSlice keep_slice;
+	
 	// helpers for interface matching
 	
 	// TODO cache type compatibility checks with a hash table
@@ -4401,6 +5067,36 @@ struct ImportState{
 			}
 		}
 		
+		// the slice of cells to keep is only known once all populations are, so a network with populations after the projections or inputs is kept whole
+		NetworkSlice net_slice = keep_slice;
+		if( !net_slice.Whole() ){
+			bool past_populations = false;
+			for (auto eNetEl: eNet.children()){
+				if( strcmp(eNetEl.name(), "population") == 0 && past_populations ){
+					log.warning(eNetEl, "population defined after projections or inputs, so each MPI node reads the whole network");
+					net_slice = NetworkSlice();
+					break;
+				}
+				if(
+					   strcmp(eNetEl.name(), "projection") == 0
+					|| strcmp(eNetEl.name(), "electricalProjection") == 0
+					|| strcmp(eNetEl.name(), "continuousProjection") == 0
+					|| strcmp(eNetEl.name(), "explicitInput") == 0
+					|| strcmp(eNetEl.name(), "inputList") == 0
+				) past_populations = true;
+			}
+		}
+		// then the cells to keep are found once, when the first projection or input comes
+		KeptCells network_kept_cells;
+		bool network_kept_cells_known = false;
+		auto GetKeptCells = [ &network_kept_cells, &network_kept_cells_known, &net_slice, &net ]() -> const KeptCells & {
+			if( !network_kept_cells_known ){
+				network_kept_cells = KeptCells( net_slice, net );
+				network_kept_cells_known = true;
+			}
+			return network_kept_cells;
+		};
+		
 		for (auto eNetEl: eNet.children()){
 			//printf("%s\n", eNetEl.name());
 			// perhaps annotation stuff?
@@ -4473,55 +5169,54 @@ struct ImportState{
 				
 				// Size and instances may both be defined, redundantly
 				// Let specific instances take priority, but also validate with 'size' attribute if available
-				if(eUniPop.child("instance")){
-					for (auto ePopEl: eUniPop.children()){
-						if(strcmp(ePopEl.name(), "instance") == 0){
-							const auto &eInstance = ePopEl;
-							Network::Population::Instance instance;
-							Int instance_id;
-							if( !StrToL(eInstance.attribute("id").value(), instance_id) ){
-								log.error(eInstance, "instance requires a numeric id");
-								return false;
-							}
-							if(instance_id < 0){
-								log.error(eInstance, "instance id is negative");
-								return false;
-							}
-							
-							const auto &eLocation = eInstance.child("location");
-							if(!eLocation){
-								log.error(eInstance, "instance requires a <location> tag");
-								return false;
-							}
-							
-							//read 3d point of instnatiation in dimensionless(implied microns), same as Morphology coordinates
-							if(!(
-								   StrToF(eLocation.attribute("x").value(), instance.x)
-								&& StrToF(eLocation.attribute("y").value(), instance.y)
-								&& StrToF(eLocation.attribute("z").value(), instance.z)
-							)){
-								log.error(eLocation,
-									"instance %ld has an invalid distal point (%s, %s, %s) position", instance_id,
-									eLocation.attribute("x").value(),
-									eLocation.attribute("y").value(),
-									eLocation.attribute("z").value()
-								);
-								return false;
-							}
-							
-							pop.instances.add(instance, instance_id);
-							
+				if( !ForEachChildNode(log, eUniPop, [&]( const pugi::xml_node &ePopEl ){
+					if(strcmp(ePopEl.name(), "instance") == 0){
+						const auto &eInstance = ePopEl;
+						Network::Population::Instance instance;
+						Int instance_id;
+						if( !StrToL(eInstance.attribute("id").value(), instance_id) ){
+							log.error(eInstance, "instance requires a numeric id");
+							return false;
 						}
-						else if(strcmp(ePopEl.name(), "layout") == 0){
-							// actually implemented in the JSON-based NeuroMLLite spec
-							log.error(ePopEl, "layout not supported yet");
+						if(instance_id < 0){
+							log.error(eInstance, "instance id is negative");
+							return false;
 						}
-						else{
-							// unknown, skip
-							// also ignore Standalone child elements
+						
+						const auto &eLocation = eInstance.child("location");
+						if(!eLocation){
+							log.error(eInstance, "instance requires a <location> tag");
+							return false;
+						}
+						
+						//read 3d point of instnatiation in dimensionless(implied microns), same as Morphology coordinates
+						if(!(
+							   StrToF(eLocation.attribute("x").value(), instance.x)
+							&& StrToF(eLocation.attribute("y").value(), instance.y)
+							&& StrToF(eLocation.attribute("z").value(), instance.z)
+						)){
+							log.error(eLocation,
+								"instance %ld has an invalid distal point (%s, %s, %s) position", instance_id,
+								eLocation.attribute("x").value(),
+								eLocation.attribute("y").value(),
+								eLocation.attribute("z").value()
+							);
+							return false;
 						}
+						
+						pop.instances.add(instance, instance_id);
+						
 					}
-				}
+					else if(strcmp(ePopEl.name(), "layout") == 0){
+						// actually implemented in the JSON-based NeuroMLLite spec
+						log.error(ePopEl, "layout not supported yet");
+					}
+					else{
+						// unknown, skip
+						// also ignore Standalone child elements
+					}
+					return true;
+				}) ) return false;
 				// if instances were already defined, validate size; else synthesize a collection of cells
 				if(eUniPop.attribute("size")){
 					Int size;
@@ -4603,6 +5298,9 @@ struct ImportState{
 				const char *cell_type_name_pre = cell_types.getName( presynaptic_population.component_cell );
 				const char *cell_type_name_post = cell_types.getName( postsynaptic_population.component_cell );
 				
+				// connections that touch none of the cells this node keeps are left out
+				const KeptCells &kept_cells = GetKeptCells();
+				
 				const Morphology *pre_morph  = NULL;
 				if( cell_type_pre .type == CellType::PHYSICAL ) pre_morph  = &( morphologies.get( cell_type_pre .physical.morphology ) );
 				const Morphology *post_morph = NULL;
@@ -4625,7 +5323,110 @@ struct ImportState{
 					{"continuousConnectionInstanceW", {Network::Projection::Connection::CONTINUOUS	,true , false} },
 				};
 				
-				for(auto eProjEl: eProj.children()){
+				// get synapse type from XML element and check corresponding rules, for a connection or a table of them
+				auto ResolveConnectionSynapses = [&]( const pugi::xml_node &eConn, Network::Projection::Connection &conn ){
+					
+					// Projection rules:
+					//  Spiking projections require only post-synaptic component to exist, and for it to receive spikes
+					//    - so they require pre-cell to emit spikes
+					//  Electrical projections require both pre and post cells to be coupled to twin components of the same synapse type, which requires Vpeer
+					//    - so they require both pre and post cells to expose voltage, in the same dimension as syn.component receives
+					// 	Continuous projections require only the general rules to be observed
+					//    - have fun, be creative
+					
+					// For example, a STDP synaptic component could be implemented with just a spiking projection, with one post-synaptic component:
+					//   then, post-synaptic component should present Voltage and have explicit spike threshold parameter, or should receive spike from its own component as well (allowing event driven simulation)
+					
+					// NB assume a physical cell has SI dimensionality all over its extent, and presents voltage and receives current
+					// 	also assume spike threshold exists (otherwise no triggering is possible), TODO check Vt existence and complain
+					// (if it was a cyborg cell it would have been modelled as something coupled with artificial cells in between, probably)
+					
+					if(conn.type == Network::Projection::Connection::SPIKING || conn.type == Network::Projection::Connection::ELECTRICAL){
+						Int synapse_type = default_synapse_type;
+						if(synapse_type < 0){
+							
+							// find synapse type here
+							auto synName = eConn.attribute("synapse").value();
+							synapse_type = synaptic_components.get_id(synName);
+							if(synapse_type < 0){
+								log.error(eConn, "connection synapse type %s not found", synName);
+								return false;
+							}
+							
+							// don't forget to send spikes to sole post-synaptic mechanism when voltage exceeds spikeThresh
+							
+						}
+						conn.synapse = synapse_type;
+						const auto &syncomp = synaptic_components.get(synapse_type);
+						if( conn.type == Network::Projection::Connection::ELECTRICAL ){
+							if( !syncomp.HasVpeer(component_types) ){
+								log.error(eConn, "connection should use an electrical synapse (using Vpeer)");
+								return false;
+							}
+							// check the interfaces
+							
+							// symmetric synapse
+							if( !CheckSynapticComponentWithCellTypes( log, eConn,
+								syncomp, synaptic_components.getName(synapse_type), 
+								cell_type_post, cell_type_name_post,
+								cell_type_pre, cell_type_name_pre
+							) ) return false;
+							if( !CheckSynapticComponentWithCellTypes( log, eConn,
+								syncomp, synaptic_components.getName(synapse_type), 
+								cell_type_pre, cell_type_name_pre,
+								cell_type_post, cell_type_name_post
+							) ) return false;
+						}
+						if( conn.type == Network::Projection::Connection::SPIKING ){
+							if( !syncomp.HasSpikeIn(component_types) ){
+								log.error(eConn, "connection should use a spiking synapse");
+								return false;
+							}
+							
+							// check the interfaces
+							if( !CheckSynapticComponentWithCellTypes( log, eConn,
+								syncomp, synaptic_components.getName(synapse_type), 
+								cell_type_post, cell_type_name_post,
+								cell_type_pre, cell_type_name_pre
+							) ) return false;
+						}
+						
+					}
+					else if(conn.type == Network::Projection::Connection::CONTINUOUS){
+						
+						auto preName = eConn.attribute("preComponent").value();
+						auto &synapse_type_pre = conn.continuous.preComponent = synaptic_components.get_id(preName);
+						if(conn.continuous.preComponent < 0){
+							log.error(eConn, "presynaptic component type %s not found", preName);
+							return false;
+						}
+						auto postName = eConn.attribute("postComponent").value();
+						auto &synapse_type_post = conn.continuous.postComponent = synaptic_components.get_id(postName);
+						if(conn.continuous.postComponent < 0){
+							log.error(eConn, "postsynaptic component type %s not found", postName);
+							return false;
+						}
+						// check the interfaces
+						const auto &syncomp_pre  = synaptic_components.get(synapse_type_pre );
+						const auto &syncomp_post = synaptic_components.get(synapse_type_post);
+						
+						// two-part synapse
+						if( !CheckSynapticComponentWithCellTypes( log, eConn,
+							syncomp_post, postName, 
+							cell_type_post, cell_type_name_post,
+							cell_type_pre, cell_type_name_pre
+						) ) return false;
+						if( !CheckSynapticComponentWithCellTypes( log, eConn,
+							syncomp_pre, preName, 
+							cell_type_pre, cell_type_name_pre,
+							cell_type_post, cell_type_name_post
+						) ) return false;
+						
+					}
+					return true;
+				};
+				
+				if( !ForEachChildNode(log, eProj, [&]( const pugi::xml_node &eProjEl ){
 					// first check if it's one of the connection types
 					auto conntype_it = connection_types.find(eProjEl.name());
 					if(conntype_it != connection_types.end()){
@@ -4652,105 +5453,8 @@ struct ImportState{
 							return false;
 						}
 						
-						// get synapse type from XML element and check corresponding rules
-						
-						// Projection rules:
-						//  Spiking projections require only post-synaptic component to exist, and for it to receive spikes
-						//    - so they require pre-cell to emit spikes
-						//  Electrical projections require both pre and post cells to be coupled to twin components of the same synapse type, which requires Vpeer
-						//    - so they require both pre and post cells to expose voltage, in the same dimension as syn.component receives
-						// 	Continuous projections require only the general rules to be observed
-						//    - have fun, be creative
-						
-						// For example, a STDP synaptic component could be implemented with just a spiking projection, with one post-synaptic component:
-						//   then, post-synaptic component should present Voltage and have explicit spike threshold parameter, or should receive spike from its own component as well (allowing event driven simulation)
+						if( !ResolveConnectionSynapses(eConn, conn) ) return false;
 						
-						// NB assume a physical cell has SI dimensionality all over its extent, and presents voltage and receives current
-						// 	also assume spike threshold exists (otherwise no triggering is possible), TODO check Vt existence and complain
-						// (if it was a cyborg cell it would have been modelled as something coupled with artificial cells in between, probably)
-						
-						if(conn.type == Network::Projection::Connection::SPIKING || conn.type == Network::Projection::Connection::ELECTRICAL){
-							Int synapse_type = default_synapse_type;
-							if(synapse_type < 0){
-								
-								// find synapse type here
-								auto synName = eConn.attribute("synapse").value();
-								synapse_type = synaptic_components.get_id(synName);
-								if(synapse_type < 0){
-									log.error(eConn, "connection synapse type %s not found", synName);
-									return false;
-								}
-								
-								// don't forget to send spikes to sole post-synaptic mechanism when voltage exceeds spikeThresh
-								
-							}
-							conn.synapse = synapse_type;
-							const auto &syncomp = synaptic_components.get(synapse_type);
-							if( conn.type == Network::Projection::Connection::ELECTRICAL ){
-								if( !syncomp.HasVpeer(component_types) ){
-									log.error(eConn, "connection should use an electrical synapse (using Vpeer)");
-									return false;
-								}
-								// check the interfaces
-								
-								// symmetric synapse
-								if( !CheckSynapticComponentWithCellTypes( log, eConn,
-									syncomp, synaptic_components.getName(synapse_type), 
-									cell_type_post, cell_type_name_post,
-									cell_type_pre, cell_type_name_pre
-								) ) return false;
-								if( !CheckSynapticComponentWithCellTypes( log, eConn,
-									syncomp, synaptic_components.getName(synapse_type), 
-									cell_type_pre, cell_type_name_pre,
-									cell_type_post, cell_type_name_post
-								) ) return false;
-							}
-							if( conn.type == Network::Projection::Connection::SPIKING ){
-								if( !syncomp.HasSpikeIn(component_types) ){
-									log.error(eConn, "connection should use a spiking synapse");
-									return false;
-								}
-								
-								// check the interfaces
-								if( !CheckSynapticComponentWithCellTypes( log, eConn,
-									syncomp, synaptic_components.getName(synapse_type), 
-									cell_type_post, cell_type_name_post,
-									cell_type_pre, cell_type_name_pre
-								) ) return false;
-							}
-							
-						}
-						else if(conn.type == Network::Projection::Connection::CONTINUOUS){
-							
-							auto preName = eConn.attribute("preComponent").value();
-							auto &synapse_type_pre = conn.continuous.preComponent = synaptic_components.get_id(preName);
-							if(conn.continuous.preComponent < 0){
-								log.error(eConn, "presynaptic component type %s not found", preName);
-								return false;
-							}
-							auto postName = eConn.attribute("postComponent").value();
-							auto &synapse_type_post = conn.continuous.postComponent = synaptic_components.get_id(postName);
-							if(conn.continuous.postComponent < 0){
-								log.error(eConn, "postsynaptic component type %s not found", postName);
-								return false;
-							}
-							// check the interfaces
-							const auto &syncomp_pre  = synaptic_components.get(synapse_type_pre );
-							const auto &syncomp_post = synaptic_components.get(synapse_type_post);
-							
-							// two-part synapse
-							if( !CheckSynapticComponentWithCellTypes( log, eConn,
-								syncomp_post, postName, 
-								cell_type_post, cell_type_name_post,
-								cell_type_pre, cell_type_name_pre
-							) ) return false;
-							if( !CheckSynapticComponentWithCellTypes( log, eConn,
-								syncomp_pre, preName, 
-								cell_type_pre, cell_type_name_pre,
-								cell_type_post, cell_type_name_post
-							) ) return false;
-							
-						}
 						// NB assume continuous projections present no delay, but be ready to handle it anytime LATER
 						if( !ParseConnectionPrePost(log, eConn, presynaptic_population, postsynaptic_population, pre_morph, post_morph, uses_old_format, conn)) return false;
 						
@@ -4765,12 +5469,25 @@ struct ImportState{
 						// could whine if these properties are defined, though unused, LATER
 						// TODO also whine if a component with no spike port specifies delay
 						
-						proj.connections.add(conn, id);
+						if( kept_cells.Keeps( proj, conn ) ) proj.connections.add(conn, id);
+						else proj.elide(conn, id);
+					}
+					else if(strcmp(eProjEl.name(), "EdenConnectionTable") == 0){
+						// EDEN extension: the connections are stored in a binary table, instead of one XML element each
+						const auto &eTable = eProjEl;
+						Network::Projection::Connection prototype;
+						if( is_spiking ) prototype.type = Network::Projection::Connection::SPIKING;
+						else if( strcmp(eNetEl.name(), "electricalProjection") == 0 ) prototype.type = Network::Projection::Connection::ELECTRICAL;
+						else prototype.type = Network::Projection::Connection::CONTINUOUS;
+						
+						if( !ResolveConnectionSynapses(eTable, prototype) ) return false;
+						if( !ParseConnectionTable(log, eTable, presynaptic_population, postsynaptic_population, pre_morph, post_morph, prototype, kept_cells, proj) ) return false;
 					}
 					else{
 						//unknown, ignore
 					}
-				}
+					return true;
+				}) ) return false;
 				
 				// add projection to Network, yay!
 				net.projections.add(proj, name);
@@ -4801,7 +5518,10 @@ struct ImportState{
 				
 				if( !CheckInputComponentWithCellType( log, eInp, input_source, inpName, cell_type_seq ) ) return false; 
 				
-				net.inputs.push_back(input_instance); // yay!
+				// inputs on cells this node does not keep are left out
+				const KeptCells &kept_cells = GetKeptCells();
+				if( kept_cells.Keeps( input_instance.population, input_instance.cell_instance ) ) net.inputs.push_back(input_instance); // yay!
+				else net.elided_input_kinds.insert( { input_instance.component_type, input_instance.population, input_instance.segment } );
 			}
 			else if(strcmp(eNetEl.name(), "inputList") == 0){
 				const auto &eInp = eNetEl;
@@ -4831,7 +5551,10 @@ struct ImportState{
 				
 				// TODO verify weights are handled properly
 				
-				for(const auto &eInpEl : eInp.children()){
+				// inputs on cells this node does not keep are left out
+				const KeptCells &kept_cells = GetKeptCells();
+				
+				if( !ForEachChildNode(log, eInp, [&]( const pugi::xml_node &eInpEl ){
 					if( strcmp(eInpEl.name(), "input") == 0 || strcmp(eInpEl.name(), "inputW") == 0 ){
 						
 						if( !parseCompartmentTarget(log, eInpEl, morphologies, cell_types, net.populations,
@@ -4841,12 +5564,14 @@ struct ImportState{
 							if( !ParseQuantity<Dimensionless>(log, eInpEl, "weight", input_instance.weight) ) return false;
 						}
 						
-						net.inputs.push_back(input_instance); // yay!
+						if( kept_cells.Keeps( input_instance.population, input_instance.cell_instance ) ) net.inputs.push_back(input_instance); // yay!
+						else net.elided_input_kinds.insert( { input_instance.component_type, input_instance.population, input_instance.segment } );
 					}
 					else{
 						// unknown, ignore
 					}
-				}
+					return true;
+				}) ) return false;
 				
 			}
 			else{
@@ -7030,11 +7755,38 @@ struct ImportState{
 	}
 };
 
+//load a file through Document Class
+//	NB: File data must remain resident until while the DOM exists,
+//	since all Strings returned by DOM getters are actually located in the file data buffer.
+static pugi::xml_parse_result LoadNmlFile( NmlFileContext &cx, bool stream_network ){
+	if( strcmp( cx.filename.c_str(), LEMS_CoreComponents_filename ) == 0 ){
+		// the magic included file
+		
+		// TODO make the name directory-independent with LD script https://stackoverflow.com/a/44288493
+		// extern char _binary_eden_neuroml_LEMS_CoreComponents_inc_xml_end, _binary_eden_neuroml_LEMS_CoreComponents_inc_xml_start;
+		// const char * LEMS_CoreComponents_buf = &_binary_eden_neuroml_LEMS_CoreComponents_inc_xml_start;
+		// size_t LEMS_CoreComponents_size = &_binary_eden_neuroml_LEMS_CoreComponents_inc_xml_end - &_binary_eden_neuroml_LEMS_CoreComponents_inc_xml_start;
+		
+		extern unsigned char eden_neuroml_LEMS_CoreComponents_inc_xml[]; const unsigned char *LEMS_CoreComponents_buf = eden_neuroml_LEMS_CoreComponents_inc_xml;
+		extern unsigned int eden_neuroml_LEMS_CoreComponents_inc_xml_len; size_t LEMS_CoreComponents_size = eden_neuroml_LEMS_CoreComponents_inc_xml_len;
+		// printf("buf %p size %zd\nload it\n", LEMS_CoreComponents_buf, LEMS_CoreComponents_size);
+		// fwrite( LEMS_CoreComponents_buf, LEMS_CoreComponents_size, 1, stdout );
+		return cx.doc.load_buffer(LEMS_CoreComponents_buf, LEMS_CoreComponents_size); //auto management of file data
+	}
+	else if( !stream_network ){
+		return cx.doc.load_file( cx.filename.c_str() ); //auto management of file data
+	}
+	else{
+		return LoadNmlFileSkeleton(cx); //auto management of file data, except for bulky network elements which are streamed later on
+	}
+}
+
 //Top-level NeuroML import routine
-bool ReadNeuroML(const char *top_level_filename, Model &model, bool entire_simulation, FILE *info_log, FILE *error_log){
+bool ReadNeuroML(const char *top_level_filename, Model &model, bool entire_simulation, FILE *info_log, FILE *error_log, const NetworkSlice &keep_slice, bool stream_network){
 
 	bool ok = false;
 	fprintf(info_log, "Starting import from NeuroML file %s\n", top_level_filename);
+	startup_phases.Restart();
 	
 	/* On required parse ordering:
 	Cell is defined by two properties: Morphology and Biophysical. Both are required and unique in the Cell.
@@ -7163,6 +7915,7 @@ bool ReadNeuroML(const char *top_level_filename, Model &model, bool entire_simul
 	
 	//The set of useful information retrieved
 	ImportState import_state(model);
+	import_state.keep_slice = keep_slice;
 	
 	// The set of files currently opened
 	NmlImportContext import_context;
@@ -7176,49 +7929,49 @@ bool ReadNeuroML(const char *top_level_filename, Model &model, bool entire_simul
 	struct FileToRead{
 		std::string path;
 		int include_level;
+		// files waiting to be read are loaded ahead of time, in parallel
+		NmlFileContext *loaded;
+		pugi::xml_parse_result result;
 	};
 	std::vector<FileToRead> files_to_read = {
-		{top_level_filename,0},
-		{LEMS_CoreComponents_filename,0},// see other options LATER
+		{top_level_filename,0, NULL, pugi::xml_parse_result()},
+		{LEMS_CoreComponents_filename,0, NULL, pugi::xml_parse_result()},// see other options LATER
 	};
 	std::set<std::string> files_considered; // to avoid opening same path twice
 	while(!files_to_read.empty()){
 		
+		if( !files_to_read.rbegin()->loaded ){
+			// Load all files known to be needed so far, at once.
+			// Their contents are independent until scanned, which still happens one file at a time in the usual order,
+			// so everything is added to the model in the same order as it would be otherwise.
+			std::vector<FileToRead *> files_to_load;
+			for( auto &file_to_load : files_to_read ){
+				if( file_to_load.loaded ) continue;
+				//make an entry
+				import_context.documents_opened.emplace_back();
+				file_to_load.loaded = &*import_context.documents_opened.rbegin();
+				file_to_load.loaded->filename = file_to_load.path;
+				files_to_load.push_back( &file_to_load );
+			}
+			
+			#pragma omp parallel for schedule(dynamic, 1)
+			for( int i = 0; i < (int)files_to_load.size(); i++ ){
+				files_to_load[i]->result = LoadNmlFile( *files_to_load[i]->loaded, stream_network );
+			}
+		}
+		
 		FileToRead file_to_read = *files_to_read.rbegin();
 		files_to_read.pop_back();
 		const char *filename = file_to_read.path.c_str(); //obviously
 		
 		// TODO hide internal files ?
 		fprintf(info_log, "Loading file %s\n", filename);
-		//make an entry
-		import_context.documents_opened.push_back( NmlFileContext() );
-		NmlFileContext &cx = *import_context.documents_opened.rbegin();
-		cx.filename = file_to_read.path;
-		
-		//load the file through Document Class
-		//	NB: File data must remain resident until while the DOM exists,
-		//	since all Strings returned by DOM getters are actually located in the file data buffer.
+		NmlFileContext &cx = *file_to_read.loaded;
+		
 		pugi::xml_document &doc = cx.doc;
-		pugi::xml_parse_result result;
-		if( strcmp( filename, LEMS_CoreComponents_filename ) == 0 ){
-			// the magic included file
-			
-			// TODO make the name directory-independent with LD script https://stackoverflow.com/a/44288493
-			// extern char _binary_eden_neuroml_LEMS_CoreComponents_inc_xml_end, _binary_eden_neuroml_LEMS_CoreComponents_inc_xml_start;
-			// const char * LEMS_CoreComponents_buf = &_binary_eden_neuroml_LEMS_CoreComponents_inc_xml_start;
-			// size_t LEMS_CoreComponents_size = &_binary_eden_neuroml_LEMS_CoreComponents_inc_xml_end - &_binary_eden_neuroml_LEMS_CoreComponents_inc_xml_start;
-			
-			extern unsigned char eden_neuroml_LEMS_CoreComponents_inc_xml[]; const unsigned char *LEMS_CoreComponents_buf = eden_neuroml_LEMS_CoreComponents_inc_xml;
-			extern unsigned int eden_neuroml_LEMS_CoreComponents_inc_xml_len; size_t LEMS_CoreComponents_size = eden_neuroml_LEMS_CoreComponents_inc_xml_len;
-			// printf("buf %p size %zd\nload it\n", LEMS_CoreComponents_buf, LEMS_CoreComponents_size);
-			// fwrite( LEMS_CoreComponents_buf, LEMS_CoreComponents_size, 1, stdout );
-			result =  doc.load_buffer(LEMS_CoreComponents_buf, LEMS_CoreComponents_size); //auto management of file data
-		}
-		else{
-			result =  doc.load_file(filename); //auto management of file data
-		}
+		pugi::xml_parse_result result = file_to_read.result;
 		if(!result){
-			ReportErrorInFile(error_log, filename, result.offset, "Could not parse root NeuroML file: %s\n", result.description() );
+			ReportErrorInFile(error_log, filename, cx.FileOffset(result.offset), "Could not parse root NeuroML file: %s\n", result.description() );
 			
 			goto CLEANUP;
 		}
@@ -7467,7 +8220,7 @@ bool ReadNeuroML(const char *top_level_filename, Model &model, bool entire_simul
 					}
 					else{
 						// and add new file to read
-						FileToRead new_file_to_read = {resolved_path, file_to_read.include_level + 1};
+						FileToRead new_file_to_read = {resolved_path, file_to_read.include_level + 1, NULL, pugi::xml_parse_result()};
 						files_to_read.emplace_back(new_file_to_read);
 						files_considered.insert(resolved_path);
 					}
@@ -7479,6 +8232,7 @@ bool ReadNeuroML(const char *top_level_filename, Model &model, bool entire_simul
 		}
 	}
 	
+	startup_phases.Lap("neuroml: read files");
 	// now decipher the XML elements, class by class
 	// to achieve (mostly) topological order, yay!!
 	
@@ -7495,6 +8249,7 @@ bool ReadNeuroML(const char *top_level_filename, Model &model, bool entire_simul
 	}
 	
 	printf("Parsed all component types\n");
+	startup_phases.Lap("neuroml: component types");
 	printf("Parsing standalone LEMS components...\n");
 	// now take one more look at unknown tags, because they might be LEMS components masquerading as standalone tags :D
 	{
@@ -7527,11 +8282,13 @@ bool ReadNeuroML(const char *top_level_filename, Model &model, bool entire_simul
 	
 	}
 	
+	startup_phases.Lap("neuroml: LEMS components");
 	// morphologies
 	printf("Parsing standalone morphologies...\n");
 	for(const pugi::xml_node &eElm : top_level_nodes_by_name.getOrNew("morphology") ){
 		if( !import_state.ParseStandaloneMorphology(log, eElm) ) goto CLEANUP; }
 	
+	startup_phases.Lap("neuroml: morphologies");
 	// substance concentration models
 	printf("Parsing concentration models...\n");
 	for(const pugi::xml_node &eElm : top_level_nodes_by_name.getOrNew("concentrationModel") ){
@@ -7541,6 +8298,7 @@ bool ReadNeuroML(const char *top_level_filename, Model &model, bool entire_simul
 	for(const pugi::xml_node &eElm : top_level_nodes_by_name.getOrNew("fixedFactorConcentrationModel") ){
 		if( !import_state.ParseConcentrationModel(log, eElm) ) goto CLEANUP; }
 	
+	startup_phases.Lap("neuroml: concentration models");
 	// ion channel types
 	printf("Parsing ion channels...\n");
 	for(const pugi::xml_node &eElm : top_level_nodes_by_name.getOrNew("ionChannel") ){
@@ -7550,6 +8308,7 @@ bool ReadNeuroML(const char *top_level_filename, Model &model, bool entire_simul
 	for(const pugi::xml_node &eElm : top_level_nodes_by_name.getOrNew("ionChannelKS") ){
 		if( !import_state.ParseIonChannel(log, eElm) ) goto CLEANUP; }
 	
+	startup_phases.Lap("neuroml: ion channels");
 	// leave parsing for specific cell type instantiation, for biophysics
 	//printf("Parsing standalone biophysics...\n");
 	for(const pugi::xml_node &eElm : top_level_nodes_by_name.getOrNew("biophysicalProperties") ){
@@ -7557,6 +8316,7 @@ bool ReadNeuroML(const char *top_level_filename, Model &model, bool entire_simul
 	for(const pugi::xml_node &eElm : top_level_nodes_by_name.getOrNew("biophysicalProperties2CaPools") ){
 		if( !import_state.ParseStandaloneBiophysics(log, eElm) ) goto CLEANUP; }
 	
+	startup_phases.Lap("neuroml: biophysics");
 	// entire cell types
 	printf("Parsing cell types...\n");
 	for(const pugi::xml_node &eElm : top_level_nodes_by_name.getOrNew("cell") ){
@@ -7564,6 +8324,7 @@ bool ReadNeuroML(const char *top_level_filename, Model &model, bool entire_simul
 	for(const pugi::xml_node &eElm : top_level_nodes_by_name.getOrNew("cell2CaPools") ){
 		if( !import_state.ParsePhysicalCell(log, eElm, true) ) goto CLEANUP; }
 	
+	startup_phases.Lap("neuroml: cells");
 	{
 	// all sorts of core NeuroML artificial cells
 	for(auto artificial_cell_type_name: known_artificial_cell_types){
@@ -7572,6 +8333,7 @@ bool ReadNeuroML(const char *top_level_filename, Model &model, bool entire_simul
 	}
 	}
 	
+	startup_phases.Lap("neuroml: artificial cells");
 	{
 	// all sorts of core NeuroML synapses
 	for(auto synapse_name: known_synapse_types){
@@ -7580,6 +8342,7 @@ bool ReadNeuroML(const char *top_level_filename, Model &model, bool entire_simul
 	}
 	}
 	
+	startup_phases.Lap("neuroml: synapses");
 	{
 	// all sorts of core NeuroML input sources	
 	for(auto input_name: known_input_types){
@@ -7588,12 +8351,14 @@ bool ReadNeuroML(const char *top_level_filename, Model &model, bool entire_simul
 	}
 	}
 	
+	startup_phases.Lap("neuroml: input sources");
 	// networks
 	for(const pugi::xml_node &eElm : top_level_nodes_by_name.getOrNew("network") ){
 		if( !import_state.ParseNetwork(log, eElm) ) goto CLEANUP; }
 	for(const pugi::xml_node &eElm : top_level_nodes_by_name.getOrNew("networkWithTemperature") ){
 		if( !import_state.ParseNetwork(log, eElm) ) goto CLEANUP; }
 	
+	startup_phases.Lap("neuroml: networks");
 	// parse simulations
 	for(const pugi::xml_node &eElm : top_level_nodes_by_name.getOrNew("Simulation") ){
 		if( !import_state.ParseSimulation(log, eElm) ) goto CLEANUP; }
@@ -7608,6 +8373,7 @@ bool ReadNeuroML(const char *top_level_filename, Model &model, bool entire_simul
 	for(const pugi::xml_node &eElm : top_level_nodes_by_name.getOrNew("Target") ){
 		if( !import_state.ParseTarget(log, eElm) ) goto CLEANUP; }
 	
+	startup_phases.Lap("neuroml: simulation");
 	printf("done parsing!\n");
 	if(!unknown_types.empty()){
 		printf("Unknown element types:\n");
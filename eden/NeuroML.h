@@ -9,6 +9,9 @@
 #include <unordered_map>
 #include <set>
 #include <list>
+#include <array>
+#include <stdexcept>
+#include <initializer_list>
 
 
 // set up a namespace LATER
@@ -275,16 +278,128 @@ struct IdListRle{
 	}
 };
 
-//make a string-indexed, low-overhead hash table, the lazy-arcane way
-struct streq{ bool operator() (const char *a, const char *b) const { return strcmp(a,b) == 0;} };
-struct strhash{ size_t operator()(const char *a) const {
-	//should be a string_view, pray the allocator handles this efficiently
-	//should change into handmade or boost implementation, if performance warrants it
-	return std::hash<std::string>()(std::string(a));
-} };
+// Open-addressing index over the items of a vector: each slot holds the position of an item, or -1 if empty.
+// Items are never removed, so plain linear probing is enough.
+struct FlatIndexTable{
+	std::vector<int64_t> slots;
+	size_t used = 0;
+	
+	// returns the position of the item matching, or -1
+	template< typename Matches >
+	int64_t Find(size_t hash, Matches matches) const {
+		if( slots.empty() ) return -1;
+		size_t mask = slots.size() - 1;
+		for( size_t i = hash & mask; ; i = (i + 1) & mask ){
+			int64_t pos = slots[i];
+			if( pos < 0 ) return -1;
+			if( matches(pos) ) return pos;
+		}
+	}
+	// the item must not be present already
+	template< typename HashAt >
+	void Insert(size_t hash, int64_t new_pos, HashAt hash_at){
+		// keep at most half full, for short probe sequences
+		if( ( used + 1 ) * 2 > slots.size() ){
+			std::vector<int64_t> old_slots( std::max( slots.size() * 2, (size_t) 16 ), -1 );
+			old_slots.swap(slots);
+			for( int64_t pos : old_slots ){
+				if( pos >= 0 ) Place( hash_at(pos), pos );
+			}
+		}
+		Place( hash, new_pos );
+		used++;
+	}
+	
+private:
+	void Place(size_t hash, int64_t pos){
+		size_t mask = slots.size() - 1;
+		size_t i = hash & mask;
+		while( slots[i] >= 0 ) i = (i + 1) & mask;
+		slots[i] = pos;
+	}
+};
+
+inline size_t HashName(const char *name){
+	// FNV-1a, no need to make a std::string of the name first
+	uint64_t hash = 0xcbf29ce484222325ull;
+	for( const unsigned char *p = (const unsigned char *) name; *p; p++ ){
+		hash ^= *p;
+		hash *= 0x100000001b3ull;
+	}
+	return hash ^ ( hash >> 32 );
+}
+inline size_t HashId(int64_t id){
+	// the upper bits of the product are mixed better, fold them in for the mask
+	uint64_t hash = (uint64_t) id * 0x9e3779b97f4a7c15ull;
+	return hash ^ ( hash >> 29 );
+}
 
+// A string-indexed hash table, with the name strings NOT copied: they must outlive the table.
+// Entries are kept in insertion order, along with the hash of each name, so that growing the table doesn't hash the names again.
 template <typename Content>
-using NameMap = std::unordered_map<const char *, Content, strhash, streq>;
+struct NameMap{
+	typedef const char * key_type;
+	typedef Content mapped_type;
+	typedef std::pair<const char *, Content> value_type;
+	typedef typename std::vector<value_type>::iterator iterator;
+	typedef typename std::vector<value_type>::const_iterator const_iterator;
+	
+	std::vector<value_type> entries;
+	std::vector<size_t> hashes;
+	FlatIndexTable index;
+	
+	NameMap(){}
+	NameMap( std::initializer_list<value_type> init ){
+		for( const auto &keyval : init ) insert(keyval);
+	}
+	
+	size_t size() const { return entries.size(); }
+	bool empty() const { return entries.empty(); }
+	iterator begin(){ return entries.begin(); }
+	iterator end(){ return entries.end(); }
+	const_iterator begin() const { return entries.begin(); }
+	const_iterator end() const { return entries.end(); }
+	
+	int64_t position(const char *name) const {
+		size_t hash = HashName(name);
+		return index.Find( hash, [ & ]( int64_t pos ){ return hashes[pos] == hash && strcmp( entries[pos].first, name ) == 0; } );
+	}
+	iterator find(const char *name){
+		int64_t pos = position(name);
+		return ( pos < 0 ) ? end() : begin() + pos;
+	}
+	const_iterator find(const char *name) const {
+		int64_t pos = position(name);
+		return ( pos < 0 ) ? end() : begin() + pos;
+	}
+	size_t count(const char *name) const {
+		return ( position(name) < 0 ) ? 0 : 1;
+	}
+	Content &at(const char *name){
+		int64_t pos = position(name);
+		if( pos < 0 ) throw std::out_of_range(name);
+		return entries[pos].second;
+	}
+	const Content &at(const char *name) const {
+		int64_t pos = position(name);
+		if( pos < 0 ) throw std::out_of_range(name);
+		return entries[pos].second;
+	}
+	
+	std::pair<iterator, bool> insert(const value_type &keyval){
+		size_t hash = HashName(keyval.first);
+		int64_t pos = index.Find( hash, [ & ]( int64_t pos ){ return hashes[pos] == hash && strcmp( entries[pos].first, keyval.first ) == 0; } );
+		if( pos >= 0 ) return std::make_pair( begin() + pos, false );
+		
+		entries.push_back(keyval);
+		hashes.push_back(hash);
+		index.Insert( hash, entries.size() - 1, [ this ]( int64_t pos ){ return hashes[pos]; } );
+		return std::make_pair( end() - 1, true );
+	}
+	Content &operator[](const char *name){
+		return insert( value_type( name, Content() ) ).first->second;
+	}
+};
 typedef NameMap<Int> NameIndexer; //TODO replace with CollectionWithNames
 
 template< typename Content, typename Int = long>
@@ -352,32 +467,55 @@ struct CollectionWithNames{
 
 // internally represented as a dense vector
 // externally represented as a random set of integer ID's
+// ID's are usually first_id, first_id + 1, ... in order; while they are, no mapping is kept at all.
 template< typename Int = long>
 struct BijectionToSequence{
 public:
-	std::vector<Int> random_ids; //ID's must be unique !
-	std::unordered_map<Int, Int> sequential_by_id;
+	Int count = 0;
+	bool ids_dense = true;
+	Int first_id = 0;
+	std::vector<Int> random_ids; //ID's must be unique ! only kept when not dense
+	FlatIndexTable sequential_by_id;
 	
 	Int getSequential(Int nml_id) const {
-		auto it = sequential_by_id.find(nml_id);
-		if(it == sequential_by_id.end()) return -1;
-		return it->second;
+		if( ids_dense ){
+			if(!( first_id <= nml_id && nml_id - first_id < count )) return -1;
+			return nml_id - first_id;
+		}
+		return sequential_by_id.Find( HashId(nml_id), [ & ]( int64_t seq ){ return random_ids[seq] == nml_id; } );
 	}
 	Int getId(Int seq_id) const {
-		if(!( 0 <= seq_id && seq_id < (Int)random_ids.size() )) return -1;
+		if(!( 0 <= seq_id && seq_id < count )) return -1;
+		else if( ids_dense ) return first_id + seq_id;
 		else return random_ids[seq_id];
 	}
 	
 	bool hasId(Int id) const {
-		return (sequential_by_id.count(id) > 0);
+		return getSequential(id) >= 0;
 	}
 	
 protected:
 	bool add(Int new_id){
-		random_ids.push_back(new_id);
-		sequential_by_id.insert(std::make_pair(new_id, random_ids.size() - 1));
+		if( ids_dense ){
+			if( count == 0 ) first_id = new_id;
+			if( new_id == first_id + count ){
+				count++;
+				return true;
+			}
+			// fall back to a full mapping from now on
+			ids_dense = false;
+			for( Int seq = 0; seq < count; seq++ ) AddToMapping( first_id + seq );
+		}
+		AddToMapping(new_id);
+		count++;
 		return true;
 	}
+	
+private:
+	void AddToMapping(Int new_id){
+		random_ids.push_back(new_id);
+		sequential_by_id.Insert( HashId(new_id), random_ids.size() - 1, [ this ]( int64_t seq ){ return HashId(random_ids[seq]); } );
+	}
 };
 
 template< typename Content, typename Int = long>
@@ -406,7 +544,132 @@ struct CollectionWithIds : public BijectionToSequence<Int> {
 	size_t size() const {
 		return contents.size();
 	}
-	
+
+};
+
+// A column of integers, stored in the narrowest type that fits all values added so far.
+// If all values are the same, they are not stored at all.
+struct NarrowIntColumn{
+	int width; // in bytes, 0 for a constant column
+	size_t count;
+	Int constant;
+	size_t reserved;
+	std::vector<int8_t > values_8;
+	std::vector<int16_t> values_16;
+	std::vector<int32_t> values_32;
+	std::vector<int64_t> values_64;
+
+	NarrowIntColumn(){ width = 0; count = 0; constant = 0; reserved = 0; }
+
+	size_t size() const { return count; }
+
+	Int operator[](size_t i) const {
+		switch(width){
+			case 0: return constant;
+			case 1: return values_8 [i];
+			case 2: return values_16[i];
+			case 4: return values_32[i];
+			default: return values_64[i];
+		}
+	}
+
+	void reserve(size_t new_reserved){
+		reserved = new_reserved;
+		switch(width){
+			case 0: break;
+			case 1: values_8 .reserve(reserved); break;
+			case 2: values_16.reserve(reserved); break;
+			case 4: values_32.reserve(reserved); break;
+			default: values_64.reserve(reserved); break;
+		}
+	}
+
+	void push_back(Int value){
+		if( count == 0 ) constant = value;
+		if( width == 0 && value == constant ){
+			count++;
+			return;
+		}
+
+		if( width == 0 ) Widen( std::max( NeededWidth(value), NeededWidth(constant) ) );
+		else if( NeededWidth(value) > width ) Widen( NeededWidth(value) );
+
+		switch(width){
+			case 1: values_8 .push_back(value); break;
+			case 2: values_16.push_back(value); break;
+			case 4: values_32.push_back(value); break;
+			default: values_64.push_back(value); break;
+		}
+		count++;
+	}
+
+private:
+	static int NeededWidth(Int value){
+		if( INT8_MIN <= value && value <= INT8_MAX ) return 1;
+		if( INT16_MIN <= value && value <= INT16_MAX ) return 2;
+		if( INT32_MIN <= value && value <= INT32_MAX ) return 4;
+		return 8;
+	}
+	// re-store the existing values in a wider type
+	void Widen(int new_width){
+		std::vector<int64_t> old_values( count );
+		for( size_t i = 0; i < count; i++ ) old_values[i] = (*this)[i];
+		values_8 .clear(); values_8 .shrink_to_fit();
+		values_16.clear(); values_16.shrink_to_fit();
+		values_32.clear(); values_32.shrink_to_fit();
+		values_64.clear(); values_64.shrink_to_fit();
+
+		width = new_width;
+		auto Fill = [ & ]( auto &values ){
+			values.reserve( std::max( reserved, count ) );
+			values.assign( old_values.begin(), old_values.end() );
+		};
+		switch(width){
+			case 1: Fill(values_8 ); break;
+			case 2: Fill(values_16); break;
+			case 4: Fill(values_32); break;
+			default: Fill(values_64); break;
+		}
+	}
+};
+
+// A column of real values, that are not stored at all if they are all the same.
+struct NarrowRealColumn{
+	bool is_constant;
+	size_t count;
+	Real constant;
+	size_t reserved;
+	std::vector<Real> values;
+
+	NarrowRealColumn(){ is_constant = true; count = 0; constant = 0; reserved = 0; }
+
+	size_t size() const { return count; }
+
+	Real operator[](size_t i) const {
+		if( is_constant ) return constant;
+		return values[i];
+	}
+
+	void reserve(size_t new_reserved){
+		reserved = new_reserved;
+		if( !is_constant ) values.reserve(reserved);
+	}
+
+	void push_back(Real value){
+		if( count == 0 ) constant = value;
+		// compare the bits, so that NaN's are the same too
+		if( is_constant && memcmp( &value, &constant, sizeof(Real) ) == 0 ){
+			count++;
+			return;
+		}
+		if( is_constant ){
+			values.reserve( std::max( reserved, count + 1 ) );
+			values.assign( count, constant );
+			is_constant = false;
+		}
+		values.push_back(value);
+		count++;
+	}
 };
 
 //Physical quantities in use
@@ -504,6 +767,8 @@ template<typename UnitType> struct Scales{
 	static const ScaleEntry native; //the simulator's internal unit name
 	static const ScaleList scales; //supported unit names
 };
+// the scaling factor for a unit name of a physical quantity, or NULL if the name is not supported
+template<typename UnitType> const ScaleEntry *FindScale(const char *unit_name);
 
 
 
@@ -1928,6 +2193,21 @@ struct CellType{
 	CellType(){ type = NONE; }
 };
 
+// Which cells of a network a node keeps when reading it, so that each MPI node only keeps its own part of the network.
+// Cells are numbered in population order, and dealt to the nodes in contiguous slices as even as possible (as with mpi_partition even).
+struct NetworkSlice{
+	int node = 0;
+	int total_nodes = 1; // 1 keeps the whole network
+	
+	bool Whole() const { return total_nodes <= 1; }
+	
+	// where the slice of each node starts, with lengths [ evenly + 1, evenly + 1 ... evenly, evenly ]
+	static long long SliceStart( long long total_cells, int total_nodes, int node ){
+		long long evenly = total_cells / total_nodes, residue = total_cells % total_nodes;
+		return node * evenly + std::min<long long>( node, residue );
+	}
+};
+
 // A NeuroML network, that's the object of simulation
 struct Network{
 	
@@ -1971,11 +2251,122 @@ struct Network{
 			};
 			Connection(){ weight = delay = NAN; }
 		};
-		
+
+		// Connections are stored column by column, since networks may have hundreds of millions of them.
+		// Connection ID's are usually 0, 1, 2, ... in order, and then they are not stored at all.
+		struct ConnectionList : public BijectionToSequence<Int> {
+			NarrowIntColumn type;
+			NarrowIntColumn preCell;
+			NarrowIntColumn preSegment;
+			NarrowRealColumn preFractionAlong;
+			NarrowIntColumn postCell;
+			NarrowIntColumn postSegment;
+			NarrowRealColumn postFractionAlong;
+			NarrowRealColumn weight;
+			NarrowRealColumn delay;
+			NarrowIntColumn synapse; // or preComponent, for continuous connections
+			NarrowIntColumn postComponent; // for continuous connections
+
+			size_t size() const { return type.size(); }
+
+			Connection operator[](size_t seq) const {
+				Connection conn;
+				conn.type = (Connection::Type) type[seq];
+				conn.preCell = preCell[seq];
+				conn.preSegment = preSegment[seq];
+				conn.preFractionAlong = preFractionAlong[seq];
+				conn.postCell = postCell[seq];
+				conn.postSegment = postSegment[seq];
+				conn.postFractionAlong = postFractionAlong[seq];
+				conn.weight = weight[seq];
+				conn.delay = delay[seq];
+				if( conn.type == Connection::CONTINUOUS ){
+					conn.continuous.preComponent = synapse[seq];
+					conn.continuous.postComponent = postComponent[seq];
+				}
+				else conn.synapse = synapse[seq];
+				return conn;
+			}
+
+			void reserve(size_t new_count){
+				for( auto *column : { &type, &preCell, &preSegment, &postCell, &postSegment, &synapse, &postComponent } ) column->reserve(new_count);
+				for( auto *column : { &preFractionAlong, &postFractionAlong, &weight, &delay } ) column->reserve(new_count);
+			}
+
+			// connections left out when a slice of the network is kept still take up their id, so duplicates are still found
+			// and the ids stay dense as usual; then the ids are only good for that, not for finding the kept connections
+			void skip(Int id){
+				BijectionToSequence<Int>::add(id);
+			}
+			
+			bool add(const Connection &conn, Int id){
+				BijectionToSequence<Int>::add(id);
+				
+				type.push_back( conn.type );
+				preCell.push_back( conn.preCell );
+				preSegment.push_back( conn.preSegment );
+				preFractionAlong.push_back( conn.preFractionAlong );
+				postCell.push_back( conn.postCell );
+				postSegment.push_back( conn.postSegment );
+				postFractionAlong.push_back( conn.postFractionAlong );
+				weight.push_back( conn.weight );
+				delay.push_back( conn.delay );
+				if( conn.type == Connection::CONTINUOUS ){
+					synapse.push_back( conn.continuous.preComponent );
+					postComponent.push_back( conn.continuous.postComponent );
+				}
+				else{
+					synapse.push_back( conn.synapse );
+					postComponent.push_back( -1 );
+				}
+				return true;
+			}
+
+			// range-for support, connections are assembled on the fly
+			struct const_iterator{
+				const ConnectionList *list;
+				size_t seq;
+				Connection operator*() const { return (*list)[seq]; }
+				const_iterator &operator++(){ seq++; return *this; }
+				bool operator!=(const const_iterator &rhs) const { return seq != rhs.seq; }
+			};
+			const_iterator begin() const { return { this, 0 }; }
+			const_iterator end() const { return { this, size() }; }
+		};
+
 		Int presynapticPopulation;
 		Int postsynapticPopulation;
+
+		ConnectionList connections;
+		
+		// When only a slice of the network is kept, the connections that touch none of its cells are left out;
+		// their distinct kinds are still kept (type, segments and synaptic components), since they shape the code of each cell type
+		std::set< std::array<Int, 5> > elided_kinds;
 		
-		CollectionWithIds<Connection> connections;
+		void elide(const Connection &conn, Int id){
+			connections.skip(id);
+			if( conn.type == Connection::CONTINUOUS ) elided_kinds.insert( { conn.type, conn.preSegment, conn.postSegment, conn.continuous.preComponent, conn.continuous.postComponent } );
+			else elided_kinds.insert( { conn.type, conn.preSegment, conn.postSegment, conn.synapse, -1 } );
+		}
+		// the elided kinds as connections, with the cells left out
+		std::vector<Connection> elided_connections() const {
+			std::vector<Connection> ret;
+			for( const auto &kind : elided_kinds ){
+				Connection conn;
+				conn.type = (Connection::Type) kind[0];
+				conn.preCell = conn.postCell = -1;
+				conn.preSegment = kind[1];
+				conn.postSegment = kind[2];
+				conn.preFractionAlong = conn.postFractionAlong = 0.5;
+				if( conn.type == Connection::CONTINUOUS ){
+					conn.continuous.preComponent = kind[3];
+					conn.continuous.postComponent = kind[4];
+				}
+				else conn.synapse = kind[3];
+				ret.push_back(conn);
+			}
+			return ret;
+		}
 	};
 	
 	struct Input{
@@ -1997,6 +2388,12 @@ struct Network{
 	CollectionWithNames<Population> populations;
 	CollectionWithNames<Projection> projections;
 	std::vector<Input> inputs;
+	
+	// The slice of cells kept, if not the whole network; then the inputs on other cells are left out,
+	// and only their distinct kinds (input, population, segment) are kept, like the elided connections of projections
+	NetworkSlice kept_slice;
+	long long kept_slice_total_cells = -1; // the cells that the network had when it was sliced
+	std::set< std::array<Int, 3> > elided_input_kinds;
 };
 
 // A NEuroML simulation, targeting a specific network
@@ -2276,6 +2673,7 @@ struct Model{
 
 //------------------> Parsed representations of NeuroML entities end
 
-bool ReadNeuroML(const char *filename, Model &model, bool entire_simulation, FILE *info_log = stdout, FILE *error_log = stderr);
+// Under MPI, a node can keep only its own slice of the network (see NetworkSlice); the rest of the model is read whole
+bool ReadNeuroML(const char *filename, Model &model, bool entire_simulation, FILE *info_log = stdout, FILE *error_log = stderr, const NetworkSlice &keep_slice = NetworkSlice(), bool stream_network = true);
 
 #endif
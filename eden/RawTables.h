@@ -2,6 +2,10 @@
 #define RAWTABLES_H
 
 #include <vector>
+#include <algorithm>
+#include <string>
+#include <cstdio>
+#include <cstring>
 #include "MMMallocator.h"
 
 extern "C" {
@@ -58,6 +62,25 @@ struct RawTables{
     std::vector<IterationCallback> callbacks; // for each work unit
     std::vector<ConsecutiveIterationCallbacks> consecutive_kernels;
 
+    // Work items that read values or spikes received from other nodes are on the "boundary";
+    // the rest are "interior" and can be crunched while communication is still in flight.
+    std::vector<char> is_boundary_item; // for each work unit, may be left empty when all are interior
+    std::vector<long long> interior_items;
+    std::vector<long long> boundary_items;
+
+    // The cell type each work unit instantiates, for profiling
+    std::vector<long long> work_item_kind; // for each work unit
+    std::vector<std::string> work_item_kind_names; // for each cell type
+
+    // Very large cells are split into parts, each a work item of its own right after the cell's item, with the same tables.
+    // The parts of a cell depend on each other, so they are run in waves: the items of a wave can run in any order,
+    // but only after the items of all earlier waves are done. Items that are not split are all in wave 0.
+    std::vector<int> work_item_wave; // for each work unit, may be left empty when no cell is split
+    std::vector<long long> work_item_part; // for each work unit: -1 for the cell itself (kernel "doit"), or the part (kernel "doit_part_<n>")
+    // A part may also be shared by several cells of the same type, that are solved together. It has tables of its own,
+    // and is a work item right after the last of the cells and their parts, which are consecutive work items.
+    std::vector<long long> work_item_lanes_from; // for each work unit: for a shared part, the work item of the first cell; -1 otherwise. May be left empty
+
     // some special-purpose tables
 
     // These are to access the singular, flat state & const vectors. They are not filled in otherwise.
@@ -95,6 +118,109 @@ struct RawTables{
         consecutive_kernels.push_back(cic);
         printf("create_consecutive_kernels_vector : reduced %lld callbacks to %lld consecutive kernels\n", (long long)callbacks.size(), (long long)consecutive_kernels.size());
     }
+
+    int wave_of(long long item) const {
+        return work_item_wave.empty() ? 0 : work_item_wave[item];
+    }
+    bool is_part_item(long long item) const {
+        return !work_item_part.empty() && work_item_part[item] >= 0;
+    }
+
+    void create_work_item_sets() {
+        is_boundary_item.resize(callbacks.size(), 0);
+        // the parts of a split cell go with the cell, since they share its tables
+        for (size_t idx = 0; idx < callbacks.size(); ) {
+            size_t end = idx + 1;
+            char boundary = is_boundary_item[idx];
+            for (; end < callbacks.size() && is_part_item(end); end++) boundary |= is_boundary_item[end];
+            for (; idx < end; idx++) is_boundary_item[idx] = boundary;
+        }
+        // and so do the cells that share a part, and the part
+        for (size_t idx = 0; idx < work_item_lanes_from.size(); idx++) {
+            const long long from = work_item_lanes_from[idx];
+            if (from < 0) continue;
+            char boundary = 0;
+            for (size_t item = from; item <= idx; item++) boundary |= is_boundary_item[item];
+            for (size_t item = from; item <= idx; item++) is_boundary_item[item] = boundary;
+        }
+        interior_items.clear();
+        boundary_items.clear();
+        for (size_t idx = 0; idx < callbacks.size(); idx++) {
+            if (is_boundary_item[idx]) boundary_items.push_back(idx);
+            else interior_items.push_back(idx);
+        }
+        // and each set is run wave by wave
+        auto ByWave = [this](long long a, long long b) { return wave_of(a) < wave_of(b); };
+        std::stable_sort(interior_items.begin(), interior_items.end(), ByWave);
+        std::stable_sort(boundary_items.begin(), boundary_items.end(), ByWave);
+        printf("create_work_item_sets : %lld interior and %lld boundary work items\n", (long long)interior_items.size(), (long long)boundary_items.size());
+    }
+
+    // Save the tables, to run kernels on them outside of EDEN (see testing/kernel_benchmark.cpp).
+    // Callbacks are not saved since they are only valid in this process, and the work item sets are left to be made again.
+    // The format is just the sizes and contents of the vectors in native byte order, not meant to be portable.
+    constexpr static const char *FILE_MAGIC = "EDEN_RAW_TABLES 3\n";
+    bool write_to_file(FILE *fout, float dt) const {
+        auto WriteVector = [ fout ]( const auto &vec ){
+            long long size = vec.size();
+            if( fwrite( &size, sizeof(size), 1, fout ) != 1 ) return false;
+            return size == 0 || fwrite( vec.data(), sizeof(vec[0]), size, fout ) == (size_t) size;
+        };
+        auto WriteTables = [ fout, &WriteVector ]( const auto &tables ){
+            long long count = tables.size();
+            if( fwrite( &count, sizeof(count), 1, fout ) != 1 ) return false;
+            for( const auto &table : tables ) if( !WriteVector(table) ) return false;
+            return true;
+        };
+        return fwrite( FILE_MAGIC, strlen(FILE_MAGIC), 1, fout ) == 1
+            && fwrite( &dt, sizeof(dt), 1, fout ) == 1
+            && WriteVector( global_initial_state ) && WriteVector( global_constants )
+            && WriteVector( global_state_f32_index ) && WriteVector( global_const_f32_index )
+            && WriteVector( global_table_const_f32_index ) && WriteVector( global_table_const_i64_index )
+            && WriteVector( global_table_state_f32_index ) && WriteVector( global_table_state_i64_index )
+            && WriteTables( global_tables_const_f32_arrays ) && WriteTables( global_tables_const_i64_arrays )
+            && WriteTables( global_tables_state_f32_arrays ) && WriteTables( global_tables_state_i64_arrays )
+            && fwrite( &global_const_tabref, sizeof(global_const_tabref), 1, fout ) == 1
+            && fwrite( &global_state_tabref, sizeof(global_state_tabref), 1, fout ) == 1
+            && WriteVector( work_item_kind ) && WriteTables( work_item_kind_names )
+            && WriteVector( work_item_wave ) && WriteVector( work_item_part ) && WriteVector( work_item_lanes_from );
+    }
+    // callbacks are left null, for each work unit
+    bool read_from_file(FILE *fin, float &dt){
+        auto ReadVector = [ fin ]( auto &vec ){
+            long long size;
+            if( fread( &size, sizeof(size), 1, fin ) != 1 || size < 0 ) return false;
+            vec.resize(size);
+            return size == 0 || fread( &vec[0], sizeof(vec[0]), size, fin ) == (size_t) size;
+        };
+        auto ReadTables = [ fin, &ReadVector ]( auto &tables ){
+            long long count;
+            if( fread( &count, sizeof(count), 1, fin ) != 1 || count < 0 ) return false;
+            tables.resize(count);
+            for( auto &table : tables ) if( !ReadVector(table) ) return false;
+            return true;
+        };
+        std::string magic( strlen(FILE_MAGIC), '\0' );
+        if( fread( &magic[0], magic.size(), 1, fin ) != 1 || magic != FILE_MAGIC ) return false;
+        bool ok = fread( &dt, sizeof(dt), 1, fin ) == 1
+            && ReadVector( global_initial_state ) && ReadVector( global_constants )
+            && ReadVector( global_state_f32_index ) && ReadVector( global_const_f32_index )
+            && ReadVector( global_table_const_f32_index ) && ReadVector( global_table_const_i64_index )
+            && ReadVector( global_table_state_f32_index ) && ReadVector( global_table_state_i64_index )
+            && ReadTables( global_tables_const_f32_arrays ) && ReadTables( global_tables_const_i64_arrays )
+            && ReadTables( global_tables_state_f32_arrays ) && ReadTables( global_tables_state_i64_arrays )
+            && fread( &global_const_tabref, sizeof(global_const_tabref), 1, fin ) == 1
+            && fread( &global_state_tabref, sizeof(global_state_tabref), 1, fin ) == 1
+            && ReadVector( work_item_kind ) && ReadTables( work_item_kind_names )
+            && ReadVector( work_item_wave ) && ReadVector( work_item_part ) && ReadVector( work_item_lanes_from );
+        if( !ok ) return false;
+        callbacks.assign( global_state_f32_index.size(), nullptr );
+        consecutive_kernels.clear();
+        is_boundary_item.clear();
+        interior_items.clear();
+        boundary_items.clear();
+        return true;
+    }
 };
 }
 #endif
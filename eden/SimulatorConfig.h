@@ -1,6 +1,8 @@
 #ifndef EDEN_SIMULATOR_CONFIG
 #define EDEN_SIMULATOR_CONFIG
 
+#include <string>
+
 extern "C" {
 // general options for the simulator
 struct SimulatorConfig{
@@ -18,6 +20,8 @@ struct SimulatorConfig{
 	bool dump_raw_state_table;
 	bool dump_raw_layout;
 	bool dump_array_locations = false;
+	bool profile_kernels = false;
+	bool perf_counters = false;
 	
 	bool use_icc;
 	bool tweak_lmvec;
@@ -32,9 +36,60 @@ struct SimulatorConfig{
 		CABLE_SOLVER_AUTO,
 		CABLE_FWD_EULER,
 		CABLE_BWD_EULER,
+		// elimination order, off-diagonals and factorized diagonal precomputed at setup, for a fixed dt
+		CABLE_BWD_EULER_HINES,
+		CABLE_CRANK_NICOLSON, // same as above, but second-order: axial currents are averaged between the start and end of the step
 	};
 	CableEquationSolver cable_solver;
 	
+	// how gating variables of native HH channels are advanced over a time step
+	enum GateSolver{
+		GATE_FWD_EULER, // q + dt * ( inf - q ) / tau
+		GATE_EXP_EULER, // inf + ( q - inf ) * exp( -dt / tau ), exact for constant inf and tau (Rush-Larsen)
+	};
+	GateSolver gate_solver;
+	
+	// how the continuous state variables of LEMS components are integrated
+	enum LemsIntegrator{
+		LEMS_EULER,         // forward Euler
+		LEMS_HEUN,          // explicit trapezoidal rule (RK2), second order
+		LEMS_RK4,           // classic fourth-order Runge-Kutta
+		LEMS_SEMI_IMPLICIT, // Euler, with the decaying linear part of each variable's derivative in itself taken implicitly
+	};
+	LemsIntegrator lems_integrator = LEMS_EULER;
+	
+	// precompute the voltage-dependent rates of native HH gates on a voltage grid (in mV), and interpolate in the kernels
+	bool rate_tables = false;
+	float rate_table_min = -150, rate_table_max = 100, rate_table_step = 0.1;
+	
+	// cells with more than this many compartments are split into work items of up to this many compartments each (0 for never)
+	long long split_cells_compartments = 0;
+	
+	// with bwd_euler_hines or crank_nicolson, the cable equations of up to this many instances of a cell type are solved together,
+	// lane-interleaved so that the elimination vectorizes across them (0 for each instance on its own)
+	long long hines_lanes = 0;
+	
+	// how cells are distributed over MPI nodes
+	enum PartitionStrategy{
+		PARTITION_EVEN,  // same amount of cells per node, in slices of GID's
+		PARTITION_COST,  // same estimated computational cost per node, in slices of GID's
+		PARTITION_GRAPH, // balanced estimated cost, also keeping connected cells on the same node
+	};
+	PartitionStrategy partition;
+	// under MPI, every node reads and keeps the whole network, rather than the connections and inputs of its own cells;
+	// the cost and graph strategies need this, since they partition the network after it is read
+	bool whole_network = false;
+	
+	// the NeuroML model to read
+	std::string nml_filename;
+	// stream the contents of bulky network elements from the NeuroML files, instead of loading them whole in the DOM
+	bool nml_streaming = true;
+	
+	// where to write the breakdown of startup time and memory as JSON, if anywhere
+	std::string startup_report_filename;
+	// where to save the tables of the model after instantiation, for testing/kernel_benchmark.cpp
+	std::string dump_tables_filename;
+	
 	SimulatorConfig(){
 		verbose = false;
 		debug = false;
@@ -49,6 +104,8 @@ struct SimulatorConfig{
 		output_assembly = false;
 		
 		cable_solver = CABLE_SOLVER_AUTO;
+		gate_solver = GATE_FWD_EULER;
+		partition = PARTITION_EVEN;
 		
 		override_random_seed = false;
 	}
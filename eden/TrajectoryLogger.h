@@ -1,6 +1,10 @@
 #ifndef EDEN_TRAJECTORYLOGGER_H
 #define EDEN_TRAJECTORYLOGGER_H
 
+#ifdef USE_MPI
+#include <mpi.h>
+#endif
+
 constexpr int column_width = 16;
 struct FixedWidthNumberPrinter{
     int column_size;
@@ -42,34 +46,74 @@ struct TrajectoryLogger {
     char tmps_column[ column_width + 5 ];
     FixedWidthNumberPrinter column_fmt;
 
+    // With sharded MPI output, each node writes its own columns to a shard of each log, and the first node merges them at the end
+    bool sharded = false;
+    int my_rank = 0;
+    int world_size = 1;
+    std::vector<std::string> logfile_paths;
+    std::vector<size_t> logfile_columns;
+
+    static std::string ShardPath( const std::string &logfile_path, int rank ){
+        return logfile_path + ".shard_" + std::to_string(rank);
+    }
+    // whether this node writes the column
+    bool IsLocalColumn( const EngineConfig::TrajectoryLogger::LogColumn &column ) const {
+#ifdef USE_MPI
+        if( sharded && column.on_node >= 0 && column.on_node != my_rank ) return false;
+#endif
+        return true;
+    }
+
     void open_trajectory_files(EngineConfig & engine_config) {
         // open the logs, one for each logger
         for(auto logger : engine_config.trajectory_loggers){
-            if (engine_config.use_mpi) {
+            if (engine_config.use_mpi && !sharded) {
                 assert( engine_config.my_mpi.rank == 0);
             }
-            const char *path = logger.logfile_path.c_str();
-            FILE *fout = fopen( path, "wt");
+            logfile_paths.push_back( logger.logfile_path );
+            logfile_columns.push_back( logger.columns.size() );
+
+            std::string path = logger.logfile_path;
+            std::string local_columns;
+            if( sharded ){
+                path = ShardPath( logger.logfile_path, my_rank );
+                for( size_t col = 0; col < logger.columns.size(); col++ ){
+                    if( IsLocalColumn( logger.columns[col] ) ) local_columns += " " + std::to_string(col);
+                }
+                // the first node's shard also gives the time column, the rest are needed only if they have columns
+                if( my_rank != 0 && local_columns.empty() ){
+                    trajectory_open_files.push_back(NULL);
+                    continue;
+                }
+            }
+            FILE *fout = fopen( path.c_str(), "wt");
             if(!fout){
                 auto errcode = errno;// NB: keep errno right away before it's overwritten
-                printf("Could not open trajectory log \"%s\" : %s\n", path, strerror(errcode) );
+                printf("Could not open trajectory log \"%s\" : %s\n", path.c_str(), strerror(errcode) );
                 exit(1);
             }
+            if( sharded ) fprintf( fout, "# shard columns:%s\n", local_columns.c_str() );
             trajectory_open_files.push_back(fout);
         }
     }
 
     TrajectoryLogger(EngineConfig & engine_config) : column_fmt(column_width, '\t', 0) {
+        if( engine_config.use_mpi ){
+            sharded = engine_config.my_mpi.sharded_output;
+            my_rank = engine_config.my_mpi.rank;
+            world_size = engine_config.my_mpi.world_size;
+        }
         open_trajectory_files(engine_config);
     }
 
     void write_output_logs(EngineConfig & engine_config, double time, float * global_state_now, /* for MPI??: */Table_F32 * global_tables_stateNow_f32) {
         for(size_t i = 0; i < engine_config.trajectory_loggers.size(); i++){
-            if (engine_config.use_mpi) {
+            if (engine_config.use_mpi && !sharded) {
                 assert(engine_config.my_mpi.rank == 0);
             }
             const auto &logger = engine_config.trajectory_loggers[i];
             FILE *& fout = trajectory_open_files[i];
+            if( !fout ) continue; // nothing to write on this node
 
             const ScaleEntry seconds = {"sec",  0, 1.0};
             const double time_scale_factor = Scales<Time>::native.ConvertTo(1, seconds);
@@ -118,6 +162,7 @@ struct TrajectoryLogger {
                 }
             };
             for( const auto &column : logger.columns ){
+                if( !IsLocalColumn(column) ) continue;
                 float col_val = GetColumnValue(column);
                 column_fmt.write( col_val, tmps_column );
                 fprintf( fout, "\t%s", tmps_column );
@@ -130,10 +175,118 @@ struct TrajectoryLogger {
     void close () {
         // close loggers
         for( auto &fout : trajectory_open_files ){
-            fclose(fout);
+            if( fout ) fclose(fout);
             fout = NULL;
         }
         trajectory_open_files.clear();
+
+#ifdef USE_MPI
+        if( sharded ){
+            // all shards must be complete before merging
+            MPI_Barrier( MPI_COMM_WORLD );
+            if( my_rank == 0 ) merge_shards();
+            sharded = false;
+        }
+#endif
+    }
+
+    static bool ReadLine( FILE *fin, std::string &line ){
+        line.clear();
+        char buf[4096];
+        while( fgets( buf, sizeof(buf), fin ) ){
+            line += buf;
+            if( !line.empty() && line.back() == '\n' ){
+                line.pop_back();
+                return true;
+            }
+        }
+        return !line.empty();
+    }
+    static void SplitTabs( const std::string &line, std::vector<std::string> &fields ){
+        fields.clear();
+        size_t start = 0;
+        while( true ){
+            size_t end = line.find( '\t', start );
+            fields.push_back( line.substr( start, end - start ) );
+            if( end == std::string::npos ) break;
+            start = end + 1;
+        }
+    }
+
+    // Put the columns from the shards of each node back in place, the result is the same as when a single node writes everything.
+    // NB: shards are read as text and copied verbatim, so the numbers are not re-formatted
+    void merge_shards(){
+        for( size_t i = 0; i < logfile_paths.size(); i++ ){
+            const auto &path = logfile_paths[i];
+
+            struct Shard{
+                std::string path;
+                FILE *fin;
+                std::vector<size_t> columns;
+            };
+            std::vector<Shard> shards;
+            for( int rank = 0; rank < world_size; rank++ ){
+                Shard shard;
+                shard.path = ShardPath( path, rank );
+                shard.fin = fopen( shard.path.c_str(), "rt" );
+                if( !shard.fin ) continue; // no columns on that node
+                std::string header;
+                ReadLine( shard.fin, header );
+                const char *cols = strchr( header.c_str(), ':' );
+                if( cols ) cols++;
+                while( cols && *cols ){
+                    char *end;
+                    long col = strtol( cols, &end, 10 );
+                    if( end == cols ) break;
+                    shard.columns.push_back( col );
+                    cols = end;
+                }
+                shards.push_back( shard );
+            }
+            if( shards.empty() ){
+                printf("Could not merge trajectory log \"%s\" : shards are missing\n", path.c_str() );
+                continue;
+            }
+
+            FILE *fout = fopen( path.c_str(), "wt" );
+            if(!fout){
+                auto errcode = errno;
+                printf("Could not open trajectory log \"%s\" : %s\n", path.c_str(), strerror(errcode) );
+                continue;
+            }
+            std::vector<std::string> columns( logfile_columns[i] );
+            std::string line, time;
+            std::vector<std::string> fields;
+            bool ok = true;
+            while( ok && ReadLine( shards[0].fin, line ) ){
+                for( size_t s = 0; s < shards.size(); s++ ){
+                    if( s > 0 && !ReadLine( shards[s].fin, line ) ){
+                        printf("Trajectory shard \"%s\" is shorter than the rest\n", shards[s].path.c_str() );
+                        ok = false;
+                        break;
+                    }
+                    SplitTabs( line, fields );
+                    if( fields.size() != shards[s].columns.size() + 1 ){
+                        printf("Trajectory shard \"%s\" has the wrong number of columns\n", shards[s].path.c_str() );
+                        ok = false;
+                        break;
+                    }
+                    if( s == 0 ) time = fields[0];
+                    for( size_t c = 0; c < shards[s].columns.size(); c++ ) columns.at( shards[s].columns[c] ) = fields[c + 1];
+                }
+                if( !ok ) break;
+                fprintf( fout, "%s", time.c_str() );
+                for( const auto &col : columns ) fprintf( fout, "\t%s", col.c_str() );
+                fprintf( fout, "\n" );
+            }
+            fclose(fout);
+
+            for( auto &shard : shards ){
+                fclose( shard.fin );
+                // keep the shards around if something went wrong
+                if( ok ) remove( shard.path.c_str() );
+            }
+        }
     }
 
     ~TrajectoryLogger() {
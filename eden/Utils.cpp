@@ -6,6 +6,17 @@
 #include <sys/resource.h>
 #endif
 
+#ifdef __linux__
+#include <linux/perf_event.h> // for hardware counters
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <errno.h>
+#endif
+
+#ifdef _OPENMP
+#include <omp.h> // to open hardware counters on each thread
+#endif
+
 std::vector<std::string> string_split(const std::string& str, const std::string& delim){
 	// straight from StackOverflow https://stackoverflow.com/a/37454181
     std::vector<std::string> tokens;
@@ -196,6 +207,229 @@ void ReportErrorInFile(FILE *error_log, const char *filename, const ptrdiff_t fi
 	va_end (args);
 }
 
+StartupPhases startup_phases;
+
+void StartupPhases::Add(const std::string &name, double seconds, int depth){
+	Phase phase = { name, depth, seconds, 0, 0 };
+#ifdef __linux__
+	phase.resident_bytes = getCurrentResidentSetBytes();
+	phase.peak_resident_bytes_so_far = getPeakResidentSetBytes();
+#endif
+	phases.push_back(phase);
+	gettimeofday(&last_end, NULL);
+}
+void StartupPhases::Lap(const std::string &name){
+	timeval now;
+	gettimeofday(&now, NULL);
+	Add( name, TimevalDeltaSec(last_end, now) );
+}
+
+bool StartupPhases::WriteReport(const char *filename, const RunMetaData &metadata, int mpi_rank, int mpi_ranks) const {
+	FILE *fout = fopen(filename, "w");
+	if(!fout){
+		perror(filename);
+		return false;
+	}
+	// names may come from the model, so they must be escaped
+	auto JsonString = []( const std::string &str ){
+		std::string ret = "\"";
+		for( unsigned char c : str ){
+			if( c == '"' || c == '\\' ){ ret += '\\'; ret += c; }
+			else if( c < 0x20 ){
+				char tmps[10];
+				sprintf(tmps, "\\u%04x", c);
+				ret += tmps;
+			}
+			else ret += c;
+		}
+		return ret + "\"";
+	};
+	// and NaN's are not valid JSON
+	auto JsonNumber = []( double value ){
+		if( !std::isfinite(value) ) return std::string("null");
+		char tmps[40];
+		sprintf(tmps, "%.6f", value);
+		return std::string(tmps);
+	};
+
+	fprintf(fout, "{\n");
+	fprintf(fout, "\t\"mpi_rank\": %d,\n", mpi_rank);
+	fprintf(fout, "\t\"mpi_ranks\": %d,\n", mpi_ranks);
+	fprintf(fout, "\t\"config_time_sec\": %s,\n", JsonNumber(metadata.config_time_sec).c_str());
+	fprintf(fout, "\t\"init_time_sec\": %s,\n", JsonNumber(metadata.init_time_sec).c_str());
+	fprintf(fout, "\t\"run_time_sec\": %s,\n", JsonNumber(metadata.run_time_sec).c_str());
+	fprintf(fout, "\t\"peak_resident_bytes\": %lld,\n", (long long) metadata.peak_resident_memory_bytes);
+	fprintf(fout, "\t\"phases\": [\n");
+	for( size_t i = 0; i < phases.size(); i++ ){
+		const Phase &phase = phases[i];
+		fprintf(fout, "\t\t{ \"name\": %s, \"depth\": %d, \"seconds\": %s, \"resident_bytes\": %lld, \"peak_resident_bytes_so_far\": %lld }%s\n",
+			JsonString(phase.name).c_str(), phase.depth, JsonNumber(phase.seconds).c_str(),
+			(long long) phase.resident_bytes, (long long) phase.peak_resident_bytes_so_far,
+			( i + 1 < phases.size() ) ? "," : "" );
+	}
+	fprintf(fout, "\t]\n");
+	fprintf(fout, "}\n");
+
+	if( fclose(fout) != 0 ){
+		perror(filename);
+		return false;
+	}
+	return true;
+}
+
+
+const char *HardwareCounters::Name(int counter){
+	switch(counter){
+		case CYCLES       : return "Cycles";
+		case INSTRUCTIONS : return "Instructions";
+		case LLC_MISSES   : return "LLC misses";
+		case BRANCH_MISSES: return "Branch misses";
+		default: return "?";
+	}
+}
+
+#ifdef __linux__
+// open all counters for the calling thread as one group, so they count over the same intervals and can be read with one call
+// if the first one cannot be opened, the next one that can leads the group
+static bool OpenCounterGroup( HardwareCounters::Group &group, std::string &error ){
+	const uint64_t event_configs[HardwareCounters::COUNTER_COUNT] = {
+		PERF_COUNT_HW_CPU_CYCLES,
+		PERF_COUNT_HW_INSTRUCTIONS,
+		PERF_COUNT_HW_CACHE_MISSES, // usually the last level cache
+		PERF_COUNT_HW_BRANCH_MISSES,
+	};
+	for( int i = 0; i < HardwareCounters::COUNTER_COUNT; i++ ){
+		perf_event_attr attr;
+		memset(&attr, 0, sizeof(attr));
+		attr.type = PERF_TYPE_HARDWARE;
+		attr.size = sizeof(attr);
+		attr.config = event_configs[i];
+		attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+		// user space only, which is also allowed with the default perf_event_paranoid setting
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+
+		int fd = (int) syscall( __NR_perf_event_open, &attr, 0 /* this thread */, -1 /* on any cpu */, group.leader_fd, 0 );
+		if( fd < 0 ){
+			if( !error.empty() ) error += "; ";
+			error += std::string(HardwareCounters::Name(i)) + ": " + strerror(errno);
+			continue;
+		}
+		group.fds[i] = fd;
+		if( group.leader_fd < 0 ) group.leader_fd = fd;
+	}
+	if( group.leader_fd < 0 ) return false;
+
+	ioctl( group.leader_fd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP );
+	ioctl( group.leader_fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP );
+	return true;
+}
+static bool ReadCounterGroup( const HardwareCounters::Group &group, HardwareCounters::Values &values ){
+	values = HardwareCounters::Values();
+	if( group.leader_fd < 0 ) return false;
+
+	// number of counters, time enabled, time running, then the counters in the order they were opened
+	uint64_t buf[3 + HardwareCounters::COUNTER_COUNT];
+	ssize_t got = read( group.leader_fd, buf, sizeof(buf) );
+	if( got < (ssize_t)( 3 * sizeof(buf[0]) ) ) return false;
+	const uint64_t nr = buf[0], time_enabled = buf[1], time_running = buf[2];
+	if( time_running == 0 ) return false; // the group never got on the PMU, eg. the thread has not run since
+	// scale up, in case the group had to share the PMU with other events
+	const double scale = (double) time_enabled / time_running;
+
+	uint64_t pos = 0;
+	for( int i = 0; i < HardwareCounters::COUNTER_COUNT && pos < nr; i++ ){
+		if( group.fds[i] < 0 ) continue;
+		values.counts[i] = (int64_t)( buf[3 + pos] * scale );
+		pos++;
+	}
+	return true;
+}
+static void CloseCounterGroup( HardwareCounters::Group &group ){
+	// members first, the leader last
+	for( int i = HardwareCounters::COUNTER_COUNT - 1; i >= 0; i-- ){
+		if( group.fds[i] >= 0 && group.fds[i] != group.leader_fd ) close(group.fds[i]);
+		group.fds[i] = -1;
+	}
+	if( group.leader_fd >= 0 ) close(group.leader_fd);
+	group.leader_fd = -1;
+}
+
+bool HardwareCounters::Open(){
+	Close();
+	int threads = 1;
+#ifdef _OPENMP
+	threads = omp_get_max_threads();
+#endif
+	// each thread opens its own group, for the counters to follow it
+	std::vector<Group> groups( threads );
+	std::vector<std::string> errors( threads );
+	#pragma omp parallel num_threads( threads )
+	{
+		int thread = 0;
+	#ifdef _OPENMP
+		thread = omp_get_thread_num();
+	#endif
+		OpenCounterGroup( groups[thread], errors[thread] );
+	}
+	// the same counters are expected to be available on all threads, report the first thread's reasons if not
+	error = errors[0];
+	bool all_open = true;
+	for( int thread = 0; thread < threads; thread++ ){
+		if( groups[thread].leader_fd < 0 ){
+			if( thread > 0 && errors[thread] != errors[0] ) error += "; none on thread " + std::to_string(thread) + ": " + errors[thread];
+			all_open = false;
+		}
+	}
+	if( !all_open ){
+		for( auto &group : groups ) CloseCounterGroup( group );
+		return false;
+	}
+	thread_groups = groups;
+	return true;
+}
+bool HardwareCounters::Read(Values &values) const {
+	values = Values();
+	bool any = false;
+	for( const auto &group : thread_groups ){
+		Values thread_values;
+		// a thread that has not run since the counters were opened has nothing to add
+		if( !ReadCounterGroup( group, thread_values ) ) continue;
+		values += thread_values;
+		any = true;
+	}
+	return any;
+}
+bool HardwareCounters::ReadThread(Values &values) const {
+	values = Values();
+	int thread = 0;
+#ifdef _OPENMP
+	thread = omp_get_thread_num();
+#endif
+	if( thread >= (int) thread_groups.size() ) return false;
+	return ReadCounterGroup( thread_groups[thread], values );
+}
+void HardwareCounters::Close(){
+	for( auto &group : thread_groups ) CloseCounterGroup( group );
+	thread_groups.clear();
+	error.clear();
+}
+#else
+bool HardwareCounters::Open(){
+	error = "not supported on this platform";
+	return false;
+}
+bool HardwareCounters::Read(Values &values) const {
+	values = Values();
+	return false;
+}
+bool HardwareCounters::ReadThread(Values &values) const {
+	values = Values();
+	return false;
+}
+void HardwareCounters::Close(){}
+#endif
+
 
 //------------------> Windows specific util routines
 #ifdef _WIN32
@@ -63,9 +63,24 @@ public:
     long long * host_tables_state_i64_sizes  () const override { return m_global_tables_state_i64_sizes; }
 
 //    functionality
-    void execute_work_items(EngineConfig & engine_config, SimulatorConfig & config, int step, double time) override {
-        execute_work_items_one_by_one(engine_config, config, step, time);
-//        execute_work_items_as_consecutives(engine_config, config, step, time);
+    void execute_work_items(EngineConfig & engine_config, SimulatorConfig & config, int step, double time, WorkItemSet which_items) override {
+        if( which_items == INTERIOR_WORK_ITEMS ){
+            execute_work_items_from_list(engine_config, config, step, time, tabs.interior_items);
+        }
+        else if( which_items == BOUNDARY_WORK_ITEMS ){
+            execute_work_items_from_list(engine_config, config, step, time, tabs.boundary_items);
+        }
+        else{
+            // both sets cover all work items, in an order that keeps the waves of split cells apart
+            execute_work_items_from_list(engine_config, config, step, time, tabs.interior_items);
+            execute_work_items_from_list(engine_config, config, step, time, tabs.boundary_items);
+//            execute_work_items_one_by_one(engine_config, config, step, time);
+//            execute_work_items_as_consecutives(engine_config, config, step, time);
+        }
+    }
+    void rebind_const_tables() override {
+        // the global constants are also a const table, which may have been moved
+        if( tabs.global_const_tabref >= 0 ) m_global_constants = state->global_tables_const_f32_arrays[tabs.global_const_tabref];
     }
     void synchronize() const override{
        //nothing to be done yet
@@ -114,46 +129,79 @@ public:
     }
 
 //    actuall working functions
+    void execute_work_item(SimulatorConfig & config, long long item, int step, double time, const float dt) {
+        if(config.debug){
+            printf("item %lld start\n", item);
+            // if(my_mpi.rank != 0) continue;
+            // continue;
+            fflush(stdout);
+        }
+
+        tabs.callbacks[item]( (float)time,
+                              dt,
+                              m_global_constants,
+                              m_global_const_f32_index[item],
+                              m_global_tables_const_f32_sizes,
+                              m_global_tables_const_f32_arrays,
+                              m_global_table_const_f32_index[item],
+                              m_global_tables_const_i64_sizes,
+                              m_global_tables_const_i64_arrays,
+                              m_global_table_const_i64_index[item],
+                              m_global_tables_state_f32_sizes,
+                              m_global_tables_stateNow_f32,
+                              m_global_tables_stateNext_f32,
+                              m_global_table_state_f32_index[item],
+                              m_global_tables_state_i64_sizes,
+                              m_global_tables_stateNow_i64,
+                              m_global_tables_stateNext_i64,
+                              m_global_table_state_i64_index[item],
+                              m_global_state_now,
+                              m_global_state_next,
+                              m_global_state_f32_index[item],
+                              step
+        );
+        if(config.debug){
+            printf("item %lld end\n", item);
+            fflush(stdout);
+        }
+    }
     void execute_work_items_one_by_one(EngineConfig & engine_config, SimulatorConfig & config, int step, double time) {
         //prepare for parallel iteration
         const float dt = engine_config.dt;
+        if( kernel_profile ){
+            kernel_profile->ExecuteTimed( engine_config.work_items,
+                []( size_t idx ){ return (long long) idx; },
+                [ & ]( long long item ){ execute_work_item(config, item, step, time, dt); } );
+            return;
+        }
         // Execute all work items
         //#pragma omp parallel for schedule(runtime)
         for( long long item = 0; item < engine_config.work_items; item++ ){
-            if(config.debug){
-                printf("item %lld start\n", item);
-                // if(my_mpi.rank != 0) continue;
-                // continue;
-                fflush(stdout);
+            execute_work_item(config, item, step, time, dt);
+        }
+    }
+    void execute_work_items_from_list(EngineConfig & engine_config, SimulatorConfig & config, int step, double time, const std::vector<long long> &items) {
+        //prepare for parallel iteration
+        const float dt = engine_config.dt;
+        // Execute the selected work items, in the given order; a wave can only start when the earlier ones are done.
+        // With cells split into parts, the items of each wave are spread over the threads
+        const bool parallel = ( config.split_cells_compartments > 0 );
+        for( size_t wave_start = 0; wave_start < items.size(); ){
+            size_t wave_end = wave_start + 1;
+            while( wave_end < items.size() && tabs.wave_of(items[wave_end]) == tabs.wave_of(items[wave_start]) ) wave_end++;
+            if( kernel_profile ){
+                kernel_profile->ExecuteTimed( wave_end - wave_start,
+                    [ &items, wave_start ]( size_t idx ){ return items[wave_start + idx]; },
+                    [ & ]( long long item ){ execute_work_item(config, item, step, time, dt); },
+                    parallel );
             }
-
-            tabs.callbacks[item]( (float)time,
-                                  dt,
-                                  m_global_constants,
-                                  m_global_const_f32_index[item],
-                                  m_global_tables_const_f32_sizes,
-                                  m_global_tables_const_f32_arrays,
-                                  m_global_table_const_f32_index[item],
-                                  m_global_tables_const_i64_sizes,
-                                  m_global_tables_const_i64_arrays,
-                                  m_global_table_const_i64_index[item],
-                                  m_global_tables_state_f32_sizes,
-                                  m_global_tables_stateNow_f32,
-                                  m_global_tables_stateNext_f32,
-                                  m_global_table_state_f32_index[item],
-                                  m_global_tables_state_i64_sizes,
-                                  m_global_tables_stateNow_i64,
-                                  m_global_tables_stateNext_i64,
-                                  m_global_table_state_i64_index[item],
-                                  m_global_state_now,
-                                  m_global_state_next,
-                                  m_global_state_f32_index[item],
-                                  step
-            );
-            if(config.debug){
-                printf("item %lld end\n", item);
-                fflush(stdout);
+            else{
+                #pragma omp parallel for schedule(dynamic) if( parallel )
+                for( size_t idx = wave_start; idx < wave_end; idx++ ){
+                    execute_work_item(config, items[idx], step, time, dt);
+                }
             }
+            wave_start = wave_end;
         }
     }
     void execute_work_items_as_consecutives(EngineConfig & engine_config, SimulatorConfig & config, int step, double time) {
@@ -41,7 +41,10 @@ public:
     long long * host_tables_state_i64_sizes  () const override { return m_host_tables_state_i64_sizes;} //todo
 
 //    functionality
-    void execute_work_items(EngineConfig & engine_config, SimulatorConfig & config, int step, double time) override{
+    void execute_work_items(EngineConfig & engine_config, SimulatorConfig & config, int step, double time, WorkItemSet which_items) override{
+        // host tables (with the MPI mirrors) are uploaded once per step, so everything runs after communication is done
+        // TODO overlap with interior items, when the mirror buffers get uploaded separately
+        if( which_items == INTERIOR_WORK_ITEMS ) return;
 #ifdef USE_GPU
         execute_work_gpu(engine_config,config, step, time, engine_config.threads_per_block);
 #else
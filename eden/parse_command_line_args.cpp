@@ -21,7 +21,7 @@ void print_eden_cli_header() {
     log(LOG_INFO) << "Build version " <<  BUILD_STAMP  << LOG_ENDL;
 }
 
-void parse_command_line_args(int argc, char ** argv, EngineConfig & engine_config, SimulatorConfig & config, Model & model, double & config_time_sec) {
+void parse_command_line_args(int argc, char ** argv, EngineConfig & engine_config, SimulatorConfig & config, double & config_time_sec) {
 	INIT_LOG();
     timeval config_start, config_end;
 	gettimeofday(&config_start, NULL);
@@ -32,20 +32,12 @@ void parse_command_line_args(int argc, char ** argv, EngineConfig & engine_confi
 		
 		// model options
 		if(arg == "nml"){
-			//read JSON
 			if(i == argc - 1){
 			    log(LOG_ERR) << "\"cmdline: NeuroML filename missing\"" << LOG_ENDL;
 				exit(1);
 			}
-			
-			timeval nml_start, nml_end;
-			gettimeofday(&nml_start, NULL);
-			if(!( ReadNeuroML(argv[i+1], model, true) )){
-                log(LOG_ERR) << "cmdline: could not make sense of NeuroML file" << LOG_ENDL;
-				exit(1);
-			}
-			gettimeofday(&nml_end, NULL);
-            log(LOG_DEBUG) << "cmdline: Parsed "<<  argv[i+1]  << " in " << TimevalDeltaSec(nml_start, nml_end) << " seconds" << LOG_ENDL;
+			// read later, when it is known which MPI node keeps which part of the network
+			config.nml_filename = argv[i+1];
 			model_selected = true;
 			i++;
 		}
@@ -83,16 +75,115 @@ void parse_command_line_args(int argc, char ** argv, EngineConfig & engine_confi
 			else if( soltype == "bwd_euler" ){
 				config.cable_solver = SimulatorConfig::CABLE_BWD_EULER;
 			}
+			else if( soltype == "bwd_euler_hines" ){
+				config.cable_solver = SimulatorConfig::CABLE_BWD_EULER_HINES;
+			}
+			else if( soltype == "crank_nicolson" ){
+				config.cable_solver = SimulatorConfig::CABLE_CRANK_NICOLSON;
+			}
 			else if( soltype == "auto" ){
 				config.cable_solver = SimulatorConfig::CABLE_SOLVER_AUTO;
 			}
 			else{
-			    log(LOG_ERR) <<"cmdline: unknown  " << arg.c_str() << "  type " << soltype.c_str() << " choices are auto, fwd_euler, bwd_euler" << LOG_ENDL;
+			    log(LOG_ERR) <<"cmdline: unknown  " << arg.c_str() << "  type " << soltype.c_str() << " choices are auto, fwd_euler, bwd_euler, bwd_euler_hines, crank_nicolson" << LOG_ENDL;
+				exit(1);
+			}
+			i++; // used following token too
+		}
+		else if(arg == "lems_integrator"){
+			if(i == argc - 1){
+			    log(LOG_ERR) <<"cmdline: "<< arg.c_str() <<" type missing" << LOG_ENDL;
+				exit(1);
+			}
+			const std::string soltype = argv[i+1];
+			if( soltype == "euler" ){
+				config.lems_integrator = SimulatorConfig::LEMS_EULER;
+			}
+			else if( soltype == "heun" || soltype == "rk2" ){
+				config.lems_integrator = SimulatorConfig::LEMS_HEUN;
+			}
+			else if( soltype == "rk4" ){
+				config.lems_integrator = SimulatorConfig::LEMS_RK4;
+			}
+			else if( soltype == "semi_implicit" ){
+				config.lems_integrator = SimulatorConfig::LEMS_SEMI_IMPLICIT;
+			}
+			else{
+			    log(LOG_ERR) <<"cmdline: unknown  " << arg.c_str() << "  type " << soltype.c_str() << " choices are euler, heun (or rk2), rk4, semi_implicit" << LOG_ENDL;
+				exit(1);
+			}
+			i++; // used following token too
+		}
+		else if(arg == "gate_solver"){
+			if(i == argc - 1){
+			    log(LOG_ERR) <<"cmdline: "<< arg.c_str() <<" type missing" << LOG_ENDL;
+				exit(1);
+			}
+			const std::string soltype = argv[i+1];
+			if( soltype == "fwd_euler" ){
+				config.gate_solver = SimulatorConfig::GATE_FWD_EULER;
+			}
+			else if( soltype == "exp_euler" ){
+				config.gate_solver = SimulatorConfig::GATE_EXP_EULER;
+			}
+			else{
+			    log(LOG_ERR) <<"cmdline: unknown  " << arg.c_str() << "  type " << soltype.c_str() << " choices are fwd_euler, exp_euler" << LOG_ENDL;
+				exit(1);
+			}
+			i++; // used following token too
+		}
+		else if(arg == "rate_tables"){
+			config.rate_tables = true;
+		}
+		else if(arg == "rate_table_grid"){
+			if(i + 3 >= argc){
+			    log(LOG_ERR) <<"cmdline: "<< arg.c_str() <<" needs the lowest and highest voltage, and voltage step (in mV)" << LOG_ENDL;
+				exit(1);
+			}
+			float vmin, vmax, vstep;
+			if(
+				sscanf( argv[i+1], "%f", &vmin ) != 1 || sscanf( argv[i+2], "%f", &vmax ) != 1 || sscanf( argv[i+3], "%f", &vstep ) != 1
+				|| !( vmin < vmax ) || !( vstep > 0 ) || ( vmax - vmin ) / vstep > 1e7
+			){
+			    log(LOG_ERR) <<"cmdline: "<< arg.c_str() <<" must be a lowest voltage, a higher voltage and a reasonable positive step (in mV), not " << argv[i+1] << " " << argv[i+2] << " " << argv[i+3] << LOG_ENDL;
+				exit(1);
+			}
+			config.rate_tables = true;
+			config.rate_table_min = vmin;
+			config.rate_table_max = vmax;
+			config.rate_table_step = vstep;
+			i += 3; // used following tokens too
+		}
+		else if(arg == "split_cells"){
+			if(i == argc - 1){
+			    log(LOG_ERR) <<"cmdline: "<< arg.c_str() <<" needs the number of compartments, above which cells are split" << LOG_ENDL;
+				exit(1);
+			}
+			long long compartments;
+			if( sscanf( argv[i+1], "%lld", &compartments ) != 1 || compartments < 1 ){
+			    log(LOG_ERR) <<"cmdline: "<< arg.c_str() <<" must be a positive number of compartments, not " << argv[i+1] << LOG_ENDL;
+				exit(1);
+			}
+			config.split_cells_compartments = compartments;
+			i++; // used following token too
+		}
+		else if(arg == "hines_lanes"){
+			if(i == argc - 1){
+			    log(LOG_ERR) <<"cmdline: "<< arg.c_str() <<" needs the number of cells to solve together" << LOG_ENDL;
+				exit(1);
+			}
+			long long lanes;
+			if( sscanf( argv[i+1], "%lld", &lanes ) != 1 || lanes < 1 || lanes > 1024 ){
+			    log(LOG_ERR) <<"cmdline: "<< arg.c_str() <<" must be a number of cells from 1 to 1024, not " << argv[i+1] << LOG_ENDL;
 				exit(1);
 			}
+			config.hines_lanes = lanes;
 			i++; // used following token too
 		}
 		// debugging options
+		else if(arg == "nml_no_streaming"){
+			config.nml_streaming = false;
+		}
 		else if(arg == "verbose"){
 			config.verbose = true;
 		}
@@ -133,6 +224,28 @@ void parse_command_line_args(int argc, char ** argv, EngineConfig & engine_confi
         else if(arg == "dump_array_locations") {
             config.dump_array_locations = true;
         }
+        else if(arg == "startup_report") {
+            if(i == argc - 1){
+                log(LOG_ERR) <<"cmdline: "<< arg.c_str() <<" filename missing" << LOG_ENDL;
+                exit(1);
+            }
+            config.startup_report_filename = argv[i+1];
+            i++; // used following token too
+        }
+        else if(arg == "dump_tables") {
+            if(i == argc - 1){
+                log(LOG_ERR) <<"cmdline: "<< arg.c_str() <<" filename missing" << LOG_ENDL;
+                exit(1);
+            }
+            config.dump_tables_filename = argv[i+1];
+            i++; // used following token too
+        }
+        else if(arg == "profile_kernels") {
+            config.profile_kernels = true;
+        }
+        else if(arg == "perf_counters") {
+            config.perf_counters = true;
+        }
 #ifdef USE_GPU
         else if(arg == "gpu") {
             engine_config.backend = backend_kind_gpu;
@@ -148,6 +261,69 @@ void parse_command_line_args(int argc, char ** argv, EngineConfig & engine_confi
         else if(arg == "mpi") {
             engine_config.use_mpi = true;
         }
+        else if(arg == "mpi_partition") {
+            if(i == argc - 1){
+                log(LOG_ERR) <<"cmdline: "<< arg.c_str() <<" type missing" << LOG_ENDL;
+                exit(1);
+            }
+            const std::string parttype = argv[i+1];
+            if( parttype == "even" ){
+                config.partition = SimulatorConfig::PARTITION_EVEN;
+            }
+            else if( parttype == "cost" ){
+                config.partition = SimulatorConfig::PARTITION_COST;
+            }
+            else if( parttype == "graph" ){
+                config.partition = SimulatorConfig::PARTITION_GRAPH;
+            }
+            else{
+                log(LOG_ERR) <<"cmdline: unknown  " << arg.c_str() << "  type " << parttype.c_str() << " choices are even, cost, graph" << LOG_ENDL;
+                exit(1);
+            }
+            i++; // used following token too
+        }
+        else if(arg == "mpi_exchange") {
+            if(i == argc - 1){
+                log(LOG_ERR) <<"cmdline: "<< arg.c_str() <<" type missing" << LOG_ENDL;
+                exit(1);
+            }
+            const std::string exchtype = argv[i+1];
+            if( exchtype == "probe" ){
+                engine_config.my_mpi.exchange = EngineConfig::MpiContext::EXCHANGE_PROBE;
+            }
+            else if( exchtype == "neighbor" ){
+                engine_config.my_mpi.exchange = EngineConfig::MpiContext::EXCHANGE_NEIGHBOR;
+            }
+            else{
+                log(LOG_ERR) <<"cmdline: unknown  " << arg.c_str() << "  type " << exchtype.c_str() << " choices are probe, neighbor" << LOG_ENDL;
+                exit(1);
+            }
+            i++; // used following token too
+        }
+        else if(arg == "mpi_output") {
+            if(i == argc - 1){
+                log(LOG_ERR) <<"cmdline: "<< arg.c_str() <<" type missing" << LOG_ENDL;
+                exit(1);
+            }
+            const std::string outtype = argv[i+1];
+            if( outtype == "gather" ){
+                engine_config.my_mpi.sharded_output = false;
+            }
+            else if( outtype == "shards" ){
+                engine_config.my_mpi.sharded_output = true;
+            }
+            else{
+                log(LOG_ERR) <<"cmdline: unknown  " << arg.c_str() << "  type " << outtype.c_str() << " choices are gather, shards" << LOG_ENDL;
+                exit(1);
+            }
+            i++; // used following token too
+        }
+        else if(arg == "mpi_shared_tables") {
+            engine_config.my_mpi.share_const_tables = true;
+        }
+        else if(arg == "mpi_whole_network") {
+            config.whole_network = true;
+        }
 #endif
         else if(arg == "dump_array_locations") {
             config.dump_array_locations = true;
@@ -179,6 +355,11 @@ void parse_command_line_args(int argc, char ** argv, EngineConfig & engine_confi
 		log(LOG_ERR) << "NeuroML model not selected (select one with nml <file> in command line)" << LOG_ENDL;
 		exit(2);
 	}
+	// the cost and graph strategies look at the whole network to partition it, so each rank cannot keep just its own slice
+	if(engine_config.use_mpi && config.partition != SimulatorConfig::PARTITION_EVEN && !config.whole_network){
+		log(LOG_ERR) << "cmdline: mpi_partition cost and graph need the whole network on every MPI rank, add mpi_whole_network to read it so" << LOG_ENDL;
+		exit(1);
+	}
     if (engine_config.backend != backend_kind_gpu && engine_config.trove) {
 		log(LOG_WARN) << "Can not use TROVE in CPU mode" << LOG_ENDL;
         engine_config.trove = false;
@@ -186,3 +367,22 @@ void parse_command_line_args(int argc, char ** argv, EngineConfig & engine_confi
 	gettimeofday(&config_end, NULL);
 	config_time_sec = TimevalDeltaSec(config_start, config_end);
 }
+
+void read_model(const EngineConfig & engine_config, const SimulatorConfig & config, Model & model, double & config_time_sec) {
+	INIT_LOG();
+	timeval nml_start, nml_end;
+	gettimeofday(&nml_start, NULL);
+	// under MPI, each node keeps only the connections and inputs that touch its own cells, as partitioned evenly
+	NetworkSlice keep_slice;
+	if(engine_config.use_mpi && !config.whole_network){
+		keep_slice.node = engine_config.my_mpi.rank;
+		keep_slice.total_nodes = engine_config.my_mpi.world_size;
+	}
+	if(!( ReadNeuroML(config.nml_filename.c_str(), model, true, stdout, stderr, keep_slice, config.nml_streaming) )){
+		log(LOG_ERR) << "cmdline: could not make sense of NeuroML file" << LOG_ENDL;
+		exit(1);
+	}
+	gettimeofday(&nml_end, NULL);
+	log(LOG_DEBUG) << "cmdline: Parsed "<<  config.nml_filename  << " in " << TimevalDeltaSec(nml_start, nml_end) << " seconds" << LOG_ENDL;
+	config_time_sec += TimevalDeltaSec(nml_start, nml_end);
+}
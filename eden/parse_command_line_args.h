@@ -6,6 +6,8 @@
 #include "EngineConfig.h"
 
 void print_eden_cli_header();
-void parse_command_line_args(int argc, char ** argv, EngineConfig & engineConfig, SimulatorConfig & config, Model & model, double & config_time_sec);
+void parse_command_line_args(int argc, char ** argv, EngineConfig & engineConfig, SimulatorConfig & config, double & config_time_sec);
+// once MPI is set up, since each node may keep only its own part of the network
+void read_model(const EngineConfig & engineConfig, const SimulatorConfig & config, Model & model, double & config_time_sec);
 
 #endif
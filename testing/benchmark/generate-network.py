@@ -0,0 +1,214 @@
+#!/usr/bin/env python3
+# Generate a synthetic NeuroML network for benchmarking EDEN, in the working directory.
+# Usage: generate-network.py <variant> <cells> [--fan-in N] [--compartments N] [--cell-types N] [--channels N] [--length ms] [--seed N]
+# Variants:
+#   point  - integrate-and-fire point neurons with exponential synapses, a tenth of them driven by current pulses
+#   hh     - single-compartment Hodgkin-Huxley cells, otherwise as above
+#   multi  - multi-compartment Hodgkin-Huxley cells, with synapses spread over the dendrites
+#   gap    - single-compartment Hodgkin-Huxley cells coupled by gap junctions instead of synapses
+#   spikes - point neurons that all fire fast, with a large fan-in; stresses spike delivery
+# With more than one cell type, the cells are split over a population of each type, which receives connections from the population before it;
+# the types are copies of the same cell, but EDEN makes code for each of them, as for different cells. Extra channels make the code of each cell larger.
+# Connections are written as binary tables (see <EdenConnectionTable> in the README), so that files stay small for a million cells.
+# Writes LEMS_<variant>_<cells>.xml (with the non-default cell types and channels added to the name), which records one cell's membrane potential, and prints a summary as JSON.
+import argparse, array, json, random, sys
+
+VARIANTS = ['point', 'hh', 'multi', 'gap', 'spikes']
+
+parser = argparse.ArgumentParser()
+parser.add_argument('variant', choices=VARIANTS)
+parser.add_argument('cells', type=int)
+parser.add_argument('--fan-in', type=int, default=None, help='connections per cell (default 10, 100 for spikes, 2 for gap)')
+parser.add_argument('--compartments', type=int, default=10, help='for multi')
+parser.add_argument('--cell-types', type=int, default=1, help='distinct cell types, in as many populations')
+parser.add_argument('--channels', type=int, default=0, help='extra potassium-like channels on each cell, for hh, multi and gap')
+parser.add_argument('--length', type=float, default=50, help='simulated time in ms')
+parser.add_argument('--step', type=float, default=0.025, help='time step in ms')
+parser.add_argument('--seed', type=int, default=1)
+args = parser.parse_args()
+
+variant, cells = args.variant, args.cells
+fan_in = args.fan_in if args.fan_in is not None else { 'spikes': 100, 'gap': 2 }.get(variant, 10)
+cell_types = max(1, min(args.cell_types, cells))
+random.seed(args.seed)
+name = '%s_%d' % (variant, cells)
+if cell_types > 1: name += '_types%d' % cell_types
+if args.channels > 0: name += '_channels%d' % args.channels
+
+# one population per cell type, of about the same size
+pop_sizes = [ cells // cell_types + (k < cells % cell_types) for k in range(cell_types) ]
+pop_names = [ 'pop' ] if cell_types == 1 else [ 'pop%d' % k for k in range(cell_types) ]
+
+def WriteNpyTable(filename, rows):
+	# a .npy file of little-endian doubles, without numpy
+	columns = 9
+	values = array.array('d', (value for row in rows for value in row))
+	if sys.byteorder != 'little': values.byteswap()
+	header = "{'descr': '<f8', 'fortran_order': False, 'shape': (%d, %d), }" % (len(values) // columns, columns)
+	# magic, version and header length take 10 bytes; the whole preamble is padded to 64 bytes, ending in newline
+	header += ' ' * (63 - (10 + len(header)) % 64) + '\n'
+	with open(filename, 'wb') as f:
+		f.write(b'\x93NUMPY\x01\x00' + len(header).to_bytes(2, 'little') + header.encode('latin1'))
+		values.tofile(f)
+
+def RandomConnections(pre_cells, post_cells, compartments_per_cell):
+	# fan_in random presynaptic cells for each cell; on a random compartment of the postsynaptic cell
+	conn_id = 0
+	for post in range(post_cells):
+		for _ in range(fan_in):
+			pre = random.randrange(pre_cells)
+			post_seg = random.randrange(compartments_per_cell)
+			yield (conn_id, pre, 0, 0.5, post, post_seg, 0.5, 0.5 + random.random(), 1 + 4 * random.random())
+			conn_id += 1
+
+def GapJunctions(pre_cells, post_cells):
+	# fan_in partners for each cell; weights and delays do not apply
+	nan = float('nan')
+	conn_id = 0
+	for post in range(post_cells):
+		for _ in range(fan_in):
+			pre = random.randrange(pre_cells)
+			yield (conn_id, pre, 0, 0.5, post, 0, 0.5, nan, nan)
+			conn_id += 1
+
+HH_CHANNELS = '''
+	<ionChannelHH id="passiveChan" conductance="10pS"/>
+	<ionChannelHH id="naChan" conductance="10pS" species="na">
+		<gateHHrates id="m" instances="3">
+			<forwardRate type="HHExpLinearRate" rate="1per_ms" midpoint="-40mV" scale="10mV"/>
+			<reverseRate type="HHExpRate" rate="4per_ms" midpoint="-65mV" scale="-18mV"/>
+		</gateHHrates>
+		<gateHHrates id="h" instances="1">
+			<forwardRate type="HHExpRate" rate="0.07per_ms" midpoint="-65mV" scale="-20mV"/>
+			<reverseRate type="HHSigmoidRate" rate="1per_ms" midpoint="-35mV" scale="10mV"/>
+		</gateHHrates>
+	</ionChannelHH>
+	<ionChannelHH id="kChan" conductance="10pS" species="k">
+		<gateHHrates id="n" instances="4">
+			<forwardRate type="HHExpLinearRate" rate="0.1per_ms" midpoint="-55mV" scale="10mV"/>
+			<reverseRate type="HHExpRate" rate="0.125per_ms" midpoint="-65mV" scale="-80mV"/>
+		</gateHHrates>
+	</ionChannelHH>
+'''
+
+# like kChan, with a different gate each, so that the code for each is made apart
+EXTRA_CHANNELS = ''.join('''
+	<ionChannelHH id="extraChan%d" conductance="10pS" species="k">
+		<gateHHrates id="n" instances="%d">
+			<forwardRate type="HHExpLinearRate" rate="0.1per_ms" midpoint="%gmV" scale="10mV"/>
+			<reverseRate type="HHExpRate" rate="0.125per_ms" midpoint="-65mV" scale="-80mV"/>
+		</gateHHrates>
+	</ionChannelHH>
+''' % (i, 1 + i % 4, -55 - i % 10) for i in range(args.channels))
+EXTRA_CHANNEL_DENSITIES = ''.join(
+	'\t\t\t\t<channelDensity id="extraChans%d" ionChannel="extraChan%d" condDensity="0.1 S_per_m2" erev="-77mV" ion="k"/>\n' % (i, i)
+	for i in range(args.channels))
+
+def HHCell(cell_id, compartments):
+	# a soma of 1000 um^2, and a chain of thin dendrites
+	segments = '\t\t\t<segment id="0" name="soma"><proximal x="0" y="0" z="0" diameter="17.841"/><distal x="17.841" y="0" z="0" diameter="17.841"/></segment>\n'
+	for seg in range(1, compartments):
+		segments += '\t\t\t<segment id="%d" name="dend%d"><parent segment="%d"/><distal x="%g" y="0" z="0" diameter="2"/></segment>\n' % (seg, seg, seg - 1, 17.841 + 20 * seg)
+	return '''
+	<cell id="%s">
+		<morphology id="%s_morphology">
+%s		</morphology>
+		<biophysicalProperties id="%s_biophysics">
+			<membraneProperties>
+				<channelDensity id="leak" ionChannel="passiveChan" condDensity="3.0 S_per_m2" erev="-54.3mV" ion="non_specific"/>
+				<channelDensity id="naChans" ionChannel="naChan" condDensity="120.0 mS_per_cm2" erev="50.0 mV" ion="na"/>
+				<channelDensity id="kChans" ionChannel="kChan" condDensity="360 S_per_m2" erev="-77mV" ion="k"/>
+%s				<spikeThresh value="-20mV"/>
+				<specificCapacitance value="1.0 uF_per_cm2"/>
+				<initMembPotential value="-65mV"/>
+			</membraneProperties>
+			<intracellularProperties>
+				<resistivity value="0.1 kohm_cm"/>
+			</intracellularProperties>
+		</biophysicalProperties>
+	</cell>
+''' % (cell_id, cell_id, segments, cell_id, EXTRA_CHANNEL_DENSITIES)
+
+def CellIds(cell):
+	return [ cell ] if cell_types == 1 else [ '%s%d' % (cell, k) for k in range(cell_types) ]
+
+compartments = 1
+if variant in ('point', 'spikes'):
+	cell = 'iaf'
+	components = ''
+	for cell_id in CellIds(cell):
+		components += '\t<iafCell id="%s" leakReversal="-65mV" thresh="-50mV" reset="-65mV" C="1.0nF" leakConductance="0.05uS"/>\n' % cell_id
+	pulse = '2nA' if variant == 'point' else '3nA'
+	weight_scale = 0.05 if variant == 'spikes' else 1 # the fan-in is large
+	quantity = '%s[0]/v' % pop_names[0]
+else:
+	cell = 'hhcell'
+	compartments = args.compartments if variant == 'multi' else 1
+	components = HH_CHANNELS + EXTRA_CHANNELS + ''.join(HHCell(cell_id, compartments) for cell_id in CellIds(cell))
+	pulse = '0.15nA'
+	weight_scale = 1
+	quantity = '%s/0/%s/0/v' % (pop_names[0], CellIds(cell)[0])
+
+components += '\t<expOneSynapse id="syn" gbase="%gnS" erev="0mV" tauDecay="2ms"/>\n' % (0.5 * weight_scale)
+components += '\t<gapJunction id="gj" conductance="0.5nS"/>\n'
+components += '\t<pulseGenerator id="pulse" delay="1ms" duration="%gms" amplitude="%s"/>\n' % (args.length, pulse)
+
+# each population receives connections from the one before it, or from itself if there is only one
+projections = ''
+for post in range(cell_types):
+	pre = (post - 1) % cell_types
+	suffix = '' if cell_types == 1 else '_%d' % post
+	table = '%s.connections%s.npy' % (name, suffix)
+	if variant == 'gap':
+		WriteNpyTable(table, GapJunctions(pop_sizes[pre], pop_sizes[post]))
+		projections += '''		<electricalProjection id="gaps%s" presynapticPopulation="%s" postsynapticPopulation="%s">
+			<EdenConnectionTable href="%s" synapse="gj"/>
+		</electricalProjection>
+''' % (suffix, pop_names[pre], pop_names[post], table)
+	else:
+		WriteNpyTable(table, RandomConnections(pop_sizes[pre], pop_sizes[post], compartments))
+		projections += '''		<projection id="synapses%s" presynapticPopulation="%s" postsynapticPopulation="%s" synapse="syn">
+			<EdenConnectionTable href="%s"/>
+		</projection>
+''' % (suffix, pop_names[pre], pop_names[post], table)
+
+# drive all cells when spikes are the point, a tenth of them otherwise
+driven = 0
+input_lists = ''
+for k, (pop_name, cell_id) in enumerate(zip(pop_names, CellIds(cell))):
+	pop_driven = range(pop_sizes[k]) if variant == 'spikes' else range(0, pop_sizes[k], 10)
+	driven += len(pop_driven)
+	inputs = ''.join('\t\t\t<input id="%d" target="../%s/%d/%s" destination="synapses"/>\n' % (i, pop_name, c, cell_id) for i, c in enumerate(pop_driven))
+	input_lists += '\t\t<inputList id="stim%s" population="%s" component="pulse">\n%s\t\t</inputList>\n' % ('' if cell_types == 1 else k, pop_name, inputs)
+
+with open('%s.nml' % name, 'w') as f:
+	f.write('<neuroml xmlns="http://www.neuroml.org/schema/neuroml2" id="%s">\n' % name)
+	f.write(components)
+	f.write('\t<network id="net" type="networkWithTemperature" temperature="6.3 degC">\n')
+	for pop_name, cell_id, size in zip(pop_names, CellIds(cell), pop_sizes):
+		f.write('\t\t<population id="%s" component="%s" size="%d"/>\n' % (pop_name, cell_id, size))
+	f.write(projections)
+	f.write(input_lists)
+	f.write('\t</network>\n</neuroml>\n')
+
+with open('LEMS_%s.xml' % name, 'w') as f:
+	f.write('''<Lems>
+	<Target component="sim"/>
+	<Include file="Cells.xml"/>
+	<Include file="Networks.xml"/>
+	<Include file="Simulation.xml"/>
+	<Include file="%s.nml"/>
+	<Simulation id="sim" length="%gms" step="%gms" target="net">
+		<OutputFile id="of" fileName="%s.results.gen.txt">
+			<OutputColumn id="v0" quantity="%s"/>
+		</OutputFile>
+	</Simulation>
+</Lems>
+''' % (name, args.length, args.step, name, quantity))
+
+print(json.dumps({
+	'variant': variant, 'cells': cells, 'compartments_per_cell': compartments,
+	'cell_types': cell_types, 'extra_channels': args.channels if cell != 'iaf' else 0,
+	'connections': cells * fan_in, 'inputs': driven,
+	'steps': int(round(args.length / args.step)), 'lems_file': 'LEMS_%s.xml' % name,
+}))
@@ -0,0 +1,87 @@
+#!/bin/bash
+# Simulation speed, setup time and peak memory of EDEN on synthetic networks, recorded as JSON for comparison across commits.
+# Usage: network-benchmark.bash <eden executable> [more eden executables ...]
+# The networks are made by generate-network.py; what is run can be set through:
+#   VARIANTS  network variants (default: point hh multi gap spikes)
+#   SIZES     cell counts (default: 1000 10000 100000)
+#   LENGTH    simulated time in ms (default: 50)
+#   THREADS   values of OMP_NUM_THREADS to run with (default: 1)
+#   RANKS     MPI rank counts to run with, for MPI-enabled executables (default: none, run without mpirun)
+#   RUNS      runs of each configuration; the fastest is kept (default: 1)
+#   OUTPUT    where to write the results (default: benchmark.<commit>.json in the working directory)
+# extra EDEN arguments can be passed through EDEN_ARGS, and mpirun arguments through MPIRUN_ARGS
+set -e
+
+[ $# -ge 1 ] || { echo "usage: $0 <eden executable> [more eden executables ...]"; exit 2; }
+REPO_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")/../.." && pwd)"
+VARIANTS=${VARIANTS:-point hh multi gap spikes}
+SIZES=${SIZES:-1000 10000 100000}
+LENGTH=${LENGTH:-50}
+THREADS=${THREADS:-1}
+RANKS=${RANKS:-}
+RUNS=${RUNS:-1}
+COMMIT="$(git -C "$REPO_DIR" rev-parse --short HEAD 2>/dev/null || echo unknown)"
+git -C "$REPO_DIR" diff --quiet HEAD 2>/dev/null || COMMIT="$COMMIT-dirty"
+OUTPUT="$(realpath -m "${OUTPUT:-benchmark.$COMMIT.json}")"
+
+EDENS=()
+for EDEN in "$@"; do EDENS+=("$(realpath "$EDEN")"); done
+if [ -n "$RANKS" ]; then command -v mpirun > /dev/null || { echo "RANKS is set, but mpirun is not available"; exit 2; }; fi
+
+# run in a scratch directory, since EDEN drops generated code and logs in the working directory
+WORK_DIR="$(mktemp -d)"
+trap 'rm -rf "$WORK_DIR"' EXIT
+cd "$WORK_DIR"
+
+# Run one configuration, and print the metrics EDEN reports as JSON fields
+RunOnce(){
+	local EDEN="$1" LEMS="$2" NP="$3"
+	rm -f log_node_*.gen.txt
+	if [ "$NP" -gt 0 ]; then
+		OMP_NUM_THREADS=$NT mpirun $MPIRUN_ARGS -np "$NP" "$EDEN" nml "$LEMS" mpi $EDEN_ARGS > run.log 2>&1 || { cat run.log >&2; return 1; }
+	else
+		OMP_NUM_THREADS=$NT "$EDEN" nml "$LEMS" $EDEN_ARGS > run.log 2>&1 || { cat run.log >&2; return 1; }
+	fi
+	# the first rank prints to the console and the rest to log files; peak memory is reported by each
+	awk '
+		/^Config:/ { config = $2; setup = $4; run = $6 }
+		/^Peak:/ { if( $2 > peak ) peak = $2; total += $2 }
+		END { printf "\"config_time_sec\": %s, \"setup_time_sec\": %s, \"run_time_sec\": %s, \"peak_resident_bytes\": %d, \"total_peak_resident_bytes\": %d", config, setup, run, peak, total }
+	' run.log $(ls log_node_*.gen.txt 2> /dev/null)
+}
+
+echo "[" > "$OUTPUT"
+FIRST=1
+for VARIANT in $VARIANTS; do
+	for SIZE in $SIZES; do
+		NETWORK=$(python3 "$REPO_DIR/testing/benchmark/generate-network.py" "$VARIANT" "$SIZE" --length "$LENGTH")
+		LEMS="LEMS_${VARIANT}_${SIZE}.xml"
+		STEPS=$(echo "$NETWORK" | sed -n 's/.*"steps": \([0-9]*\).*/\1/p')
+		for EDEN in "${EDENS[@]}"; do
+			for NT in $THREADS; do
+				# 0 ranks for running without mpirun
+				for NP in ${RANKS:-0}; do
+					BEST=
+					for RUN in $(seq "$RUNS"); do
+						METRICS=$(RunOnce "$EDEN" "$LEMS" "$NP")
+						RUN_TIME=$(echo "$METRICS" | sed -n 's/.*"run_time_sec": \([0-9.]*\).*/\1/p')
+						if [ -z "$BEST" ] || awk -v a="$RUN_TIME" -v b="$BEST_TIME" 'BEGIN { exit !( a + 0 < b + 0 ) }'; then
+							BEST="$METRICS"; BEST_TIME="$RUN_TIME"
+						fi
+					done
+					STEPS_PER_SEC=$(awk -v s="$STEPS" -v t="$BEST_TIME" 'BEGIN { printf "%.3f", ( t > 0 ) ? s / t : 0 }')
+					MPI=$( [ "$NP" -gt 0 ] && echo true || echo false )
+					echo "$VARIANT $SIZE cells, $NT threads, $( [ "$NP" -gt 0 ] && echo "$NP ranks" || echo "no MPI" ): $STEPS_PER_SEC steps/sec ($EDEN)"
+
+					[ -n "$FIRST" ] || echo "," >> "$OUTPUT"
+					FIRST=
+					printf '{ "commit": "%s", "eden": "%s", "network": %s, "threads": %d, "mpi": %s, "ranks": %d, %s, "steps_per_sec": %s }' \
+						"$COMMIT" "$EDEN" "$NETWORK" "$NT" "$MPI" "$(( NP > 0 ? NP : 1 ))" "$BEST" "$STEPS_PER_SEC" >> "$OUTPUT"
+				done
+			done
+		done
+		rm -f ./*.nml ./*.npy ./*.gen.*
+	done
+done
+echo "]" >> "$OUTPUT"
+echo "results written to $OUTPUT"
@@ -0,0 +1,86 @@
+#!/bin/bash
+# Time to load a large synthetic NeuroML network, for one or more builds of EDEN.
+# The network is made to lean on name and ID lookups: many populations with sparse instance IDs,
+# connections and inputs that refer to them, and many named input sources.
+# Usage: parser-benchmark.bash <eden executable> [more eden executables ...]
+# the size can be set through CELLS, CONNECTIONS, INPUTS and POPULATIONS, and the number of runs (best is kept) through RUNS
+set -e
+
+[ $# -ge 1 ] || { echo "usage: $0 <eden executable> [more eden executables ...]"; exit 2; }
+CELLS=${CELLS:-50000}
+CONNECTIONS=${CONNECTIONS:-500000}
+INPUTS=${INPUTS:-50000}
+POPULATIONS=${POPULATIONS:-500}
+RUNS=${RUNS:-3}
+
+EDENS=()
+for EDEN in "$@"; do EDENS+=("$(realpath "$EDEN")"); done
+
+# run in a scratch directory, since EDEN drops generated code and logs in the working directory
+WORK_DIR="$(mktemp -d)"
+trap 'rm -rf "$WORK_DIR"' EXIT
+cd "$WORK_DIR"
+
+python3 - "$CELLS" "$CONNECTIONS" "$INPUTS" "$POPULATIONS" <<'PY'
+import random, sys
+cells, connections, inputs, populations = [int(x) for x in sys.argv[1:]]
+random.seed(1)
+per_pop = max(1, cells // populations)
+# sparse, but increasing instance ID's
+pop_ids = [ sorted(random.sample(range(per_pop * 4), per_pop)) for _ in range(populations) ]
+sources = 100
+
+with open('bench.nml', 'w') as f:
+    f.write('<neuroml xmlns="http://www.neuroml.org/schema/neuroml2" id="bench">\n')
+    f.write('    <iafCell id="iaf" leakReversal="-65mV" thresh="-50mV" reset="-65mV" C="1.0nF" leakConductance="0.05uS"/>\n')
+    f.write('    <expOneSynapse id="syn" gbase="0.5nS" erev="0mV" tauDecay="5ms"/>\n')
+    for s in range(sources):
+        f.write('    <pulseGenerator id="pulse_generator_number_%d" delay="1ms" duration="5ms" amplitude="%gnA"/>\n' % (s, 1 + s / sources))
+    f.write('    <network id="net" type="networkWithTemperature" temperature="6.3 degC">\n')
+    for p, ids in enumerate(pop_ids):
+        f.write('        <population id="population_number_%d" component="iaf" type="populationList" size="%d">\n' % (p, len(ids)))
+        for i in ids:
+            f.write('            <instance id="%d"><location x="%d" y="%d" z="0"/></instance>\n' % (i, i, p))
+        f.write('        </population>\n')
+    # connections are grouped in projections between random pairs of populations
+    projections = max(1, populations // 2)
+    per_proj = connections // projections
+    for j in range(projections):
+        pre, post = random.randrange(populations), random.randrange(populations)
+        f.write('        <projection id="projection_number_%d" presynapticPopulation="population_number_%d" postsynapticPopulation="population_number_%d" synapse="syn">\n' % (j, pre, post))
+        for c in range(per_proj):
+            f.write('            <connectionWD id="%d" preCellId="../population_number_%d/%d/iaf" postCellId="../population_number_%d/%d/iaf" weight="%.4g" delay="%.4gms"/>\n'
+                % (c, pre, random.choice(pop_ids[pre]), post, random.choice(pop_ids[post]), random.random(), 1 + random.random()))
+        f.write('        </projection>\n')
+    for n in range(inputs):
+        p = random.randrange(populations)
+        f.write('        <explicitInput target="population_number_%d[%d]" input="pulse_generator_number_%d"/>\n' % (p, random.choice(pop_ids[p]), random.randrange(sources)))
+    f.write('    </network>\n</neuroml>\n')
+
+with open('LEMS_bench.xml', 'w') as f:
+    f.write('''<Lems>
+    <Target component="sim"/>
+    <Include file="Cells.xml"/>
+    <Include file="Networks.xml"/>
+    <Include file="Simulation.xml"/>
+    <Include file="bench.nml"/>
+    <Simulation id="sim" length="0.1ms" step="0.025ms" target="net">
+        <OutputFile id="of" fileName="results.gen.txt">
+            <OutputColumn id="v0" quantity="population_number_0/%d/iaf/v"/>
+        </OutputFile>
+    </Simulation>
+</Lems>
+''' % pop_ids[0][0])
+PY
+echo "network: $CELLS cells in $POPULATIONS populations, $CONNECTIONS connections, $INPUTS inputs ($(du -h bench.nml | cut -f1))"
+
+for EDEN in "${EDENS[@]}"; do
+	BEST=
+	for RUN in $(seq "$RUNS"); do
+		"$EDEN" nml LEMS_bench.xml > run.log 2>&1 || { cat run.log; exit 1; }
+		# the time to read the model is reported as Config
+		CONFIG=$(awk '/^Config:/ { print $2 }' run.log)
+		BEST=$(awk -v a="$CONFIG" -v b="$BEST" 'BEGIN { print ( b == "" || a + 0 < b + 0 ) ? a : b }')
+	done
+	echo "$EDEN: load time $BEST s (best of $RUNS)"
+done
@@ -0,0 +1,101 @@
+#!/bin/bash
+# Time to the first step of EDEN on synthetic networks, broken down by setup phase and recorded as JSON for comparison across commits.
+# Usage: startup-benchmark.bash <eden executable> [more eden executables ...]
+# Starting from a base network, each of these is varied in turn, with the rest as in the base network:
+#   CELL_TYPES    distinct cell types (default: 1 4 16 64; base: 1)
+#   COMPARTMENTS  compartments per cell (default: 1 10 100; base: 10)
+#   CHANNELS      extra ion channels per cell (default: 0 4 16; base: 0)
+#   FAN_IN        connections per cell (default: 10 100 1000; base: 10)
+# and the base network has CELLS cells (default: 1000) of the multi variant of generate-network.py.
+# RUNS sets the runs of each network, the fastest setup is kept (default: 1), and OUTPUT where the results are written
+# (default: startup-benchmark.<commit>.json in the working directory); extra EDEN arguments can be passed through EDEN_ARGS.
+# The phases are taken from EDEN's startup_report, and summed up as:
+#   read_sec         reading and parsing the NeuroML/LEMS files
+#   analysis_sec     analysis of each cell type, for its code (connectivity of the network is in other_sec)
+#   code_sec         code generation for each cell type
+#   compile_sec      compilation and loading of the code for each cell type
+#   instantiate_sec  laying out the cells and inputs in the simulation tables
+#   wiring_sec       laying out the synapses and gap junctions, and exchanging their lists under MPI
+#   other_sec        the rest of the time to the first step
+set -e
+
+[ $# -ge 1 ] || { echo "usage: $0 <eden executable> [more eden executables ...]"; exit 2; }
+REPO_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")/../.." && pwd)"
+CELLS=${CELLS:-1000}
+CELL_TYPES=${CELL_TYPES:-1 4 16 64}
+COMPARTMENTS=${COMPARTMENTS:-1 10 100}
+CHANNELS=${CHANNELS:-0 4 16}
+FAN_IN=${FAN_IN:-10 100 1000}
+RUNS=${RUNS:-1}
+COMMIT="$(git -C "$REPO_DIR" rev-parse --short HEAD 2>/dev/null || echo unknown)"
+git -C "$REPO_DIR" diff --quiet HEAD 2>/dev/null || COMMIT="$COMMIT-dirty"
+OUTPUT="$(realpath -m "${OUTPUT:-startup-benchmark.$COMMIT.json}")"
+
+EDENS=()
+for EDEN in "$@"; do EDENS+=("$(realpath "$EDEN")"); done
+
+# run in a scratch directory, since EDEN drops generated code and logs in the working directory
+WORK_DIR="$(mktemp -d)"
+trap 'rm -rf "$WORK_DIR"' EXIT
+cd "$WORK_DIR"
+
+# Sum up the phases of a startup report, and print them as JSON fields
+SummarizeReport(){
+	python3 - "$1" <<'PY'
+import json, sys
+report = json.load(open(sys.argv[1]))
+sums = { key: 0.0 for key in ('read', 'analysis', 'code', 'compile', 'instantiate', 'wiring', 'other') }
+for phase in report['phases']:
+	name, seconds = phase['name'], phase['seconds'] or 0.0
+	# sub-phases of each cell type are listed before the phase of all cell types, which contains them
+	if phase['depth'] > 0:
+		if name.endswith(': analysis'): sums['analysis'] += seconds
+		elif name.endswith(': code'): sums['code'] += seconds
+		else: sums['compile'] += seconds
+	elif name == 'model: cell types':
+		sums['other'] += max(0.0, seconds - sum(p['seconds'] or 0.0 for p in report['phases'] if p['depth'] > 0))
+	elif name.startswith('neuroml:'): sums['read'] += seconds
+	elif name in ('model: populations', 'model: inputs'): sums['instantiate'] += seconds
+	elif name in ('model: synapses', 'model: recvlists', 'model: list exchange', 'model: mirrors'): sums['wiring'] += seconds
+	else: sums['other'] += seconds
+fields = [ '"%s_sec": %.6f' % (key, value) for key, value in sums.items() ]
+fields.append('"startup_sec": %.6f' % sum(sums.values()))
+fields.append('"peak_resident_bytes": %d' % report['peak_resident_bytes'])
+print(', '.join(fields))
+PY
+}
+
+echo "[" > "$OUTPUT"
+FIRST=1
+# the parameter to vary, and its values; the others stay at the base values
+for SWEEP in "cell-types:$CELL_TYPES" "compartments:$COMPARTMENTS" "channels:$CHANNELS" "fan-in:$FAN_IN"; do
+	PARAM=${SWEEP%%:*}
+	for VALUE in ${SWEEP#*:}; do
+		declare -A ARGS=( [cell-types]=1 [compartments]=10 [channels]=0 [fan-in]=10 )
+		ARGS[$PARAM]=$VALUE
+		NETWORK=$(python3 "$REPO_DIR/testing/benchmark/generate-network.py" multi "$CELLS" --length 0.1 \
+			--cell-types "${ARGS[cell-types]}" --compartments "${ARGS[compartments]}" --channels "${ARGS[channels]}" --fan-in "${ARGS[fan-in]}")
+		LEMS=$(echo "$NETWORK" | sed -n 's/.*"lems_file": "\([^"]*\)".*/\1/p')
+		for EDEN in "${EDENS[@]}"; do
+			BEST=
+			for RUN in $(seq "$RUNS"); do
+				rm -f ./*.gen.*
+				"$EDEN" nml "$LEMS" startup_report startup.json $EDEN_ARGS > run.log 2>&1 || { cat run.log >&2; exit 1; }
+				METRICS=$(SummarizeReport startup.json)
+				STARTUP=$(echo "$METRICS" | sed -n 's/.*"startup_sec": \([0-9.]*\).*/\1/p')
+				if [ -z "$BEST" ] || awk -v a="$STARTUP" -v b="$BEST_STARTUP" 'BEGIN { exit !( a + 0 < b + 0 ) }'; then
+					BEST="$METRICS"; BEST_STARTUP="$STARTUP"
+				fi
+			done
+			echo "$PARAM $VALUE: $BEST_STARTUP sec to first step ($EDEN)"
+
+			[ -n "$FIRST" ] || echo "," >> "$OUTPUT"
+			FIRST=
+			printf '{ "commit": "%s", "eden": "%s", "varied": "%s", "network": %s, %s }' \
+				"$COMMIT" "$EDEN" "$PARAM" "$NETWORK" "$BEST" >> "$OUTPUT"
+		done
+		rm -f ./*.nml ./*.npy ./*.xml ./*.gen.*
+	done
+done
+echo "]" >> "$OUTPUT"
+echo "results written to $OUTPUT"
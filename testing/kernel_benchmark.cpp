@@ -0,0 +1,164 @@
+#include "Common.h"
+#include "backends/cpu/CpuBackend.h"
+
+#include <dlfcn.h>
+#include <chrono>
+
+// Times the generated kernel of one cell type, apart from the rest of the simulation:
+// loads the tables EDEN saved with the dump_tables flag and the compiled kernel (<cell type>_code.gen.so, left in the directory EDEN ran in),
+// and runs the kernel over the instances of the cell type for a number of steps.
+// Other work items are not run, so whatever they would feed into these instances stays at its initial value;
+// this is fine for timing, not for checking results.
+
+int main( int argc, char **argv ){
+
+	auto Usage = [ argv ](){
+		fprintf( stderr, "usage: %s <tables file> [--kind <cell type name or index>] [--kernel <.so file>] [--steps N] [--instances N]\n", argv[0] );
+		fprintf( stderr, "the tables file is written by eden ... dump_tables <tables file>\n" );
+		fprintf( stderr, "by default, the cell type with most instances is run, with the kernel EDEN left in the working directory\n" );
+	};
+	if( argc < 2 ){
+		Usage();
+		return 2;
+	}
+	const char *tables_filename = argv[1];
+	std::string kind_arg, kernel_filename;
+	long long steps = 1000, max_instances = -1;
+	for( int i = 2; i < argc; i++ ){
+		std::string arg = argv[i];
+		if( i + 1 >= argc ){
+			Usage();
+			return 2;
+		}
+		if( arg == "--kind" ) kind_arg = argv[++i];
+		else if( arg == "--kernel" ) kernel_filename = argv[++i];
+		else if( arg == "--steps" ) steps = atoll( argv[++i] );
+		else if( arg == "--instances" ) max_instances = atoll( argv[++i] );
+		else{
+			Usage();
+			return 2;
+		}
+	}
+
+	CpuBackend backend;
+	RawTables &tabs = backend.tabs;
+	float dt;
+	FILE *fin = fopen( tables_filename, "rb" );
+	if( !fin ){
+		fprintf( stderr, "error: could not open %s\n", tables_filename );
+		return 1;
+	}
+	if( !tabs.read_from_file( fin, dt ) ){
+		fprintf( stderr, "error: %s is not a tables file of this version of EDEN\n", tables_filename );
+		return 1;
+	}
+	fclose( fin );
+	if( tabs.work_item_kind_names.empty() ){
+		fprintf( stderr, "error: no cell types in %s\n", tables_filename );
+		return 1;
+	}
+
+	// pick the cell type
+	std::vector<long long> kind_instances( tabs.work_item_kind_names.size(), 0 );
+	for( long long item = 0; item < (long long) tabs.work_item_kind.size(); item++ ){
+		const long long kind = tabs.work_item_kind[item];
+		if( kind >= 0 && !tabs.is_part_item(item) ) kind_instances[kind]++;
+	}
+	long long kind = -1;
+	if( kind_arg.empty() ){
+		kind = std::max_element( kind_instances.begin(), kind_instances.end() ) - kind_instances.begin();
+	}
+	else{
+		for( size_t i = 0; i < tabs.work_item_kind_names.size(); i++ ){
+			if( tabs.work_item_kind_names[i] == kind_arg ) kind = i;
+		}
+		char *end;
+		long long index = strtoll( kind_arg.c_str(), &end, 10 );
+		if( kind < 0 && *end == '\0' && index >= 0 && index < (long long) kind_instances.size() ) kind = index;
+		if( kind < 0 ){
+			fprintf( stderr, "error: no cell type %s in %s; there are:\n", kind_arg.c_str(), tables_filename );
+			for( size_t i = 0; i < tabs.work_item_kind_names.size(); i++ ){
+				fprintf( stderr, "\t%zu %s (%lld instances)\n", i, tabs.work_item_kind_names[i].c_str(), kind_instances[i] );
+			}
+			return 1;
+		}
+	}
+	const std::string &kind_name = tabs.work_item_kind_names[kind];
+	if( kernel_filename.empty() ) kernel_filename = "./" + kind_name + "_code.gen.so";
+
+	// load the kernel, the same way EDEN does
+	void *dll_handle = dlopen( kernel_filename.c_str(), RTLD_NOW );
+	if( !dll_handle ){
+		fprintf( stderr, "error: could not load kernel %s: %s\n", kernel_filename.c_str(), dlerror() );
+		return 1;
+	}
+	// with the parts of a split cell, if any
+	auto LoadCallback = [ dll_handle, &kernel_filename ]( const std::string &function_name, IterationCallback &callback ){
+		*(void**)(& callback ) = dlsym( dll_handle, function_name.c_str() );
+		if( !callback ){
+			fprintf( stderr, "error: no kernel %s in %s: %s\n", function_name.c_str(), kernel_filename.c_str(), dlerror() );
+			return false;
+		}
+		return true;
+	};
+
+	std::vector<long long> items;
+	long long instances = 0;
+	long long first_left_out = -1; // the first instance past max_instances
+	for( long long item = 0; item < (long long) tabs.work_item_kind.size(); item++ ){
+		if( tabs.work_item_kind[item] != kind ) continue;
+		const bool part = tabs.is_part_item(item);
+		if( !part ){
+			if( max_instances >= 0 && instances >= max_instances && first_left_out < 0 ) first_left_out = item;
+			if( first_left_out >= 0 ) continue;
+			instances++;
+		}
+		else if( first_left_out >= 0 ){
+			// a part shared with instances that are run is still needed, even if it also runs on some that are not
+			const long long lanes_from = tabs.work_item_lanes_from.empty() ? -1 : tabs.work_item_lanes_from[item];
+			if( !( 0 <= lanes_from && lanes_from < first_left_out ) ) continue;
+		}
+		std::string function_name = part ? "doit_part_" + std::to_string( tabs.work_item_part[item] ) : "doit";
+		if( !LoadCallback( function_name, tabs.callbacks[item] ) ) return 1;
+		items.push_back( item );
+	}
+	// run the parts in their waves, as EDEN does
+	std::stable_sort( items.begin(), items.end(), [ &tabs ]( long long a, long long b ){ return tabs.wave_of(a) < tabs.wave_of(b); } );
+	if( items.empty() ){
+		fprintf( stderr, "error: no instances of %s to run\n", kind_name.c_str() );
+		return 1;
+	}
+
+	EngineConfig engine_config;
+	SimulatorConfig config;
+	engine_config.dt = dt;
+	engine_config.work_items = tabs.callbacks.size();
+	backend.init();
+
+	// estimate the bytes each instance touches, as for profile_kernels
+	KernelProfile profile( tabs, *backend.state, engine_config );
+	// for all instances of the cell type; scaled down if only some are run
+	const int64_t bytes_per_step = profile.kinds[kind].bytes_per_step * (double) instances / kind_instances[kind];
+
+	// the same initialization steps as the simulation, then the timed steps
+	double time = 0;
+	for( long long step = -3; step <= 0; step++ ){
+		backend.execute_work_items_from_list( engine_config, config, (int) step, time, items );
+		backend.swap_buffers();
+	}
+	auto start = std::chrono::steady_clock::now();
+	for( long long step = 1; step <= steps; step++ ){
+		backend.execute_work_items_from_list( engine_config, config, (int) step, time, items );
+		backend.swap_buffers();
+		time += dt;
+	}
+	const double seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+	const double instance_steps = (double) instances * steps;
+
+	printf( "cell type %s: %lld instances, %lld steps, kernel %s\n", kind_name.c_str(), instances, steps, kernel_filename.c_str() );
+	printf( "%.3lf sec, %.1lf nsec/instance/step, %lld bytes/instance, %.3lf GB/sec\n",
+		seconds, ( instance_steps > 0 ) ? seconds / instance_steps * 1e9 : 0,
+		(long long)( bytes_per_step / instances ), ( seconds > 0 ) ? (double) bytes_per_step * steps / seconds * 1e-9 : 0 );
+
+	return 0;
+}
@@ -0,0 +1,25 @@
+#!/bin/bash
+# Setup time breakdown of an MPI build of EDEN, at increasing numbers of ranks on the local machine.
+# Usage: setup-scaling.bash <eden executable> [LEMS simulation file] [rank counts ...]
+# extra EDEN arguments can be passed through EDEN_ARGS, and mpirun arguments through MPIRUN_ARGS
+set -e
+
+REPO_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")/../.." && pwd)"
+
+EDEN="$(realpath "${1:?usage: $0 <eden executable> [LEMS simulation file] [rank counts ...]}")"
+MODEL="$(realpath "${2:-$REPO_DIR/testing/validation_tests/neuroml/LEMS_EdenTest_DomainDecomposition.xml}")"
+shift 2 || shift $#
+RANKS="${*:-1 2 4 8}"
+
+# run in a scratch directory, since EDEN drops generated code and logs in the working directory
+WORK_DIR="$(mktemp -d)"
+trap 'rm -rf "$WORK_DIR"' EXIT
+cp -r "$(dirname "$MODEL")"/. "$WORK_DIR"
+cd "$WORK_DIR"
+
+for NP in $RANKS; do
+	echo "=== $NP ranks"
+	mpirun $MPIRUN_ARGS -np "$NP" "$EDEN" nml "$(basename "$MODEL")" mpi $EDEN_ARGS > run.log 2>&1 || { cat run.log; exit 1; }
+	# rank 0 prints the breakdown over all ranks
+	awk '/^Setup time breakdown/ { p = 1; print; next } p && /^\t/ { print; next } { p = 0 }' run.log
+done
@@ -0,0 +1,219 @@
+#include "Common.h"
+#include "NeuroML.h"
+#include "stdio.h"
+#include "ctype.h"
+#include "thirdparty/pugixml-1.9/pugixml.hpp"
+
+#include <map>
+
+// Converts the connections of NeuroML projections into binary tables, in the .npy format of NumPy,
+// and replaces them with <EdenConnectionTable> elements that EDEN loads in bulk.
+// Table columns: id, preCellId, preSegmentId, preFractionAlong, postCellId, postSegmentId, postFractionAlong, weight, delay (in ms)
+// Projections whose connections use different synapse types are left as they are.
+
+int main( int argc, char **argv ){
+
+	if( argc != 3 ){
+		fprintf( stderr, "usage: nml_connection_tables <input NeuroML file> <output NeuroML file>\n" );
+		fprintf( stderr, "tables are written next to the output file, named <output file>.<projection id>.npy\n" );
+		return 2;
+	}
+
+	const char *in_filename = argv[1];
+	const char *out_filename = argv[2];
+
+	pugi::xml_document doc;
+	pugi::xml_parse_result result = doc.load_file( in_filename );
+	if( !result ){
+		fprintf( stderr, "error: could not parse %s at offset %td: %s\n", in_filename, result.offset, result.description() );
+		return 1;
+	}
+
+	struct ConnectionSubType{
+		bool uses_weight;
+		bool uses_delay;
+		bool uses_old_format;
+	};
+	const std::map< std::string, ConnectionSubType > connection_types = {
+		{"connection"					, {false, false, true } },
+		{"connectionWD"					, {true , true , true } },
+		{"electricalConnection"			, {false, false, false} },
+		{"electricalConnectionInstance"	, {false, false, false} },
+		{"electricalConnectionInstanceW", {true , false, false} },
+		{"continuousConnection"			, {false, false, false} },
+		{"continuousConnectionInstance"	, {false, false, false} },
+		{"continuousConnectionInstanceW", {true , false, false} },
+	};
+	// these go on the table, so they must be the same for all connections in it
+	const char *synapse_attributes[] = { "synapse", "preComponent", "postComponent" };
+
+	// as in EDEN's NeuroML import
+	auto ParseCellRef = []( const char *refspec, long &id ){
+		const char *ptr = refspec;
+		if( strncmp( refspec, "../", 3 ) == 0 ) ptr += 3;
+		auto bracket = strchr( ptr, '[' );
+		auto slash = strchr( ptr, '/' );
+		if( bracket ) ptr = bracket + 1;
+		else if( slash ) ptr = slash + 1;
+		char *pEnd;
+		errno = 0;
+		id = strtol( ptr, &pEnd, 10 );
+		return !errno && pEnd != ptr;
+	};
+	auto ParseNumber = []( const char *str, double &value ){
+		char *pEnd;
+		errno = 0;
+		value = strtod( str, &pEnd );
+		if( errno || pEnd == str ) return false;
+		while( isspace(*pEnd) ) pEnd++;
+		return *pEnd == '\0';
+	};
+	// with the same time units as EDEN's NeuroML import
+	auto ParseDelay = []( const char *str, double &value_ms ){
+		double value;
+		char unit[100];
+		if( sscanf( str, "%lf%99s", &value, unit ) != 2 ) return false;
+		const ScaleEntry *scale = FindScale<Time>( unit );
+		if( !scale ) return false;
+		const ScaleEntry milliseconds = {"ms", -3, 1.0};
+		value_ms = scale->ConvertTo( value, milliseconds );
+		return true;
+	};
+
+	auto WriteNpy = []( const std::string &filename, const std::vector<double> &values, size_t columns ){
+		FILE *fout = fopen( filename.c_str(), "wb" );
+		if( !fout ) return false;
+
+		char dict[200];
+		snprintf( dict, sizeof(dict), "{'descr': '<f8', 'fortran_order': False, 'shape': (%zu, %zu), }", values.size() / columns, columns );
+		// pad the header with spaces, so that the data are aligned
+		std::string header = dict;
+		const size_t preamble_size = 10;
+		while( ( preamble_size + header.size() + 1 ) % 64 != 0 ) header += ' ';
+		header += '\n';
+
+		// NB: values are written in host byte order, which is little-endian on all supported platforms
+		const char preamble[8] = { '\x93', 'N', 'U', 'M', 'P', 'Y', 1, 0 };
+		unsigned char header_length[2] = { (unsigned char)( header.size() & 0xFF ), (unsigned char)( header.size() >> 8 ) };
+		bool ok =
+			   fwrite( preamble, sizeof(preamble), 1, fout ) == 1
+			&& fwrite( header_length, sizeof(header_length), 1, fout ) == 1
+			&& fwrite( header.data(), header.size(), 1, fout ) == 1
+			&& ( values.empty() || fwrite( values.data(), sizeof(double), values.size(), fout ) == values.size() );
+		if( fclose( fout ) != 0 ) ok = false;
+		return ok;
+	};
+
+	// tables are referenced relative to the output file
+	std::string out_dir, out_name = out_filename;
+	size_t last_slash_pos = out_name.rfind('/');
+	if( last_slash_pos != std::string::npos ){
+		out_dir = out_name.substr( 0, last_slash_pos + 1 );
+		out_name = out_name.substr( last_slash_pos + 1 );
+	}
+
+	const size_t COLUMNS = 9;
+	int tables_written = 0;
+	for( auto eRoot : doc.children() ){
+	for( auto eNet : eRoot.children() ){
+		if(!( strcmp( eNet.name(), "network" ) == 0 || strcmp( eNet.name(), "networkWithTemperature" ) == 0 )) continue;
+
+		for( auto eProj : eNet.children() ){
+			if(!(
+				   strcmp( eProj.name(), "projection" ) == 0
+				|| strcmp( eProj.name(), "electricalProjection" ) == 0
+				|| strcmp( eProj.name(), "continuousProjection" ) == 0
+			)) continue;
+			const char *proj_id = eProj.attribute("id").value();
+
+			std::vector<pugi::xml_node> connections;
+			for( auto eConn : eProj.children() ){
+				if( connection_types.count( eConn.name() ) ) connections.push_back( eConn );
+			}
+			if( connections.empty() ) continue;
+
+			bool uniform_synapses = true;
+			for( auto eConn : connections ){
+				for( auto attr : synapse_attributes ){
+					if( strcmp( eConn.attribute(attr).value(), connections[0].attribute(attr).value() ) != 0 ) uniform_synapses = false;
+				}
+			}
+			if( !uniform_synapses ){
+				printf( "projection %s: connections use different synapse types, left as is\n", proj_id );
+				continue;
+			}
+
+			std::vector<double> values;
+			values.reserve( connections.size() * COLUMNS );
+			for( auto eConn : connections ){
+				const ConnectionSubType &subtype = connection_types.at( eConn.name() );
+				const char *conn_id = eConn.attribute("id").value();
+				auto Fail = [ proj_id, conn_id ]( const char *what, const char *value ){
+					fprintf( stderr, "error: projection %s, connection %s: invalid %s \"%s\"\n", proj_id, conn_id, what, value );
+					return 1;
+				};
+
+				double id;
+				if( !ParseNumber( conn_id, id ) ) return Fail( "id", conn_id );
+				values.push_back( id );
+
+				for( int side = 0; side < 2; side++ ){
+					std::string prefix = side ? "post" : "pre";
+					std::string cell_attr = prefix + ( subtype.uses_old_format ? "CellId" : "Cell" );
+					std::string segment_attr = prefix + ( subtype.uses_old_format ? "SegmentId" : "Segment" );
+					std::string fraction_attr = prefix + "FractionAlong";
+
+					const char *sCell = eConn.attribute( cell_attr.c_str() ).value();
+					long cell;
+					if( !ParseCellRef( sCell, cell ) ) return Fail( cell_attr.c_str(), sCell );
+					values.push_back( cell );
+
+					const char *sSegment = eConn.attribute( segment_attr.c_str() ).value();
+					double segment = 0;
+					if( *sSegment && !ParseNumber( sSegment, segment ) ) return Fail( segment_attr.c_str(), sSegment );
+					values.push_back( segment );
+
+					const char *sFraction = eConn.attribute( fraction_attr.c_str() ).value();
+					double fraction = 0.5;
+					if( *sFraction && !ParseNumber( sFraction, fraction ) ) return Fail( fraction_attr.c_str(), sFraction );
+					values.push_back( fraction );
+				}
+
+				double weight = NAN, delay = NAN;
+				const char *sWeight = eConn.attribute("weight").value();
+				if( subtype.uses_weight && !ParseNumber( sWeight, weight ) ) return Fail( "weight", sWeight );
+				const char *sDelay = eConn.attribute("delay").value();
+				if( subtype.uses_delay && !ParseDelay( sDelay, delay ) ) return Fail( "delay", sDelay );
+				values.push_back( weight );
+				values.push_back( delay );
+			}
+
+			std::string table_name = out_name + "." + proj_id + ".npy";
+			if( !WriteNpy( out_dir + table_name, values, COLUMNS ) ){
+				perror( ( "writing " + out_dir + table_name ).c_str() );
+				return 1;
+			}
+
+			// and replace the connections with the table
+			pugi::xml_node eTable = eProj.insert_child_before( "EdenConnectionTable", connections[0] );
+			eTable.append_attribute("href") = table_name.c_str();
+			for( auto attr : synapse_attributes ){
+				const char *value = connections[0].attribute(attr).value();
+				if( *value ) eTable.append_attribute(attr) = value;
+			}
+			for( auto eConn : connections ) eProj.remove_child( eConn );
+
+			printf( "projection %s: %zu connections written to %s\n", proj_id, connections.size(), table_name.c_str() );
+			tables_written++;
+		}
+	}
+	}
+
+	if( !doc.save_file( out_filename, "    " ) ){
+		perror( ( std::string("writing ") + out_filename ).c_str() );
+		return 1;
+	}
+	printf( "%d connection tables written\n", tables_written );
+
+	return 0;
+}
@@ -1,7 +1,44 @@
 import sys
+import subprocess
 from eden_tools import *
 
 test_nml_dir = 'neuroml/'
+
+def WriteLargeNetwork( filename, pre_cells = 300, post_cells = 200 ):
+	'''Write a network with a projection of pre_cells * post_cells connections, several megabytes long, so that it is read in pieces'''
+	with open( filename, 'w' ) as f:
+		f.write('<?xml version="1.0" encoding="UTF-8"?>\n')
+		f.write('<neuroml xmlns="http://www.neuroml.org/schema/neuroml2" id="NML_EdenTestLargeNetwork">\n')
+		f.write('\t<iafCell id="iaf" leakReversal="-65mV" thresh="-50mV" reset="-65mV" C="0.2nF" leakConductance="0.01uS"/>\n')
+		f.write('\t<expOneSynapse id="syn" gbase="0.05nS" erev="0mV" tauDecay="2ms"/>\n')
+		f.write('\t<pulseGenerator id="stim" delay="1ms" duration="100ms" amplitude="0.25nA"/>\n')
+		f.write('\t<network id="EdenTestLargeNetwork">\n')
+		for pop, size in [ ('pre', pre_cells), ('post', post_cells) ]:
+			f.write('\t\t<population id="%s" component="iaf" type="populationList" size="%d">\n' % ( pop, size ) )
+			for i in range(size):
+				f.write('\t\t\t<instance id="%d"><location x="%d" y="0" z="0"/></instance>\n' % ( i, i ) )
+			f.write('\t\t</population>\n')
+		f.write('\t\t<projection id="proj" presynapticPopulation="pre" postsynapticPopulation="post" synapse="syn">\n')
+		conn_id = 0
+		for pre in range(pre_cells):
+			for post in range(post_cells):
+				f.write('\t\t\t<connectionWD id="%d" preCellId="../pre/%d/iaf" postCellId="../post/%d/iaf" weight="%.4f" delay="%.3fms"/>\n'
+					% ( conn_id, pre, post, ( ( pre * 7 + post * 13 ) % 100 ) / 100., 1 + ( ( pre + post ) % 50 ) * 0.1 ) )
+				conn_id += 1
+		f.write('\t\t</projection>\n')
+		f.write('\t\t<inputList id="stims" population="pre" component="stim">\n')
+		for i in range(pre_cells):
+			f.write('\t\t\t<inputW id="%d" target="../pre/%d/iaf" destination="synapses" weight="%.3f"/>\n' % ( i, i, 1 + i / pre_cells ) )
+		f.write('\t\t</inputList>\n')
+		f.write('\t</network>\n')
+		f.write('</neuroml>\n')
+
+# large enough to be streamed in pieces, too large to commit
+WriteLargeNetwork( test_nml_dir + 'EdenTest_LargeNetwork.gen.nml' )
+
+# the connections of all kinds of projections, converted to binary tables
+subprocess.check_call( [ 'nml_connection_tables', test_nml_dir + 'EdenTest_CoreSynapses.nml', test_nml_dir + 'EdenTest_CoreSynapses_Converted.gen.nml' ] )
+
 tests = [
 {
 	'type': 'smoke_test',
@@ -137,6 +174,296 @@ tests = [
 	'test_kwargs': { 'full_cmdline': ['mpirun','-n','4','eden-mpi', 'nml', test_nml_dir + 'LEMS_EdenTest_DomainDecomposition.xml' ], 'threads':2, 'verbose': True },
 	'validation_criteria': 'exact'
 },
+{
+	# cells are placed on other ranks, but each one is integrated the same way
+	'type': 'eden_vs_eden',
+	'sim_file': test_nml_dir + 'LEMS_EdenTest_DomainDecomposition.xml',
+	'truth_kwargs': { 'full_cmdline': ['mpirun','-n','4','eden-mpi', 'nml', test_nml_dir + 'LEMS_EdenTest_DomainDecomposition.xml', 'mpi' ], 'threads':2, 'verbose': True },
+	'test_kwargs': { 'full_cmdline': ['mpirun','-n','4','eden-mpi', 'nml', test_nml_dir + 'LEMS_EdenTest_DomainDecomposition.xml', 'mpi', 'mpi_whole_network', 'mpi_partition', 'cost' ], 'threads':2, 'verbose': True },
+	'validation_criteria': 'exact'
+},
+{
+	'type': 'eden_vs_eden',
+	'sim_file': test_nml_dir + 'LEMS_EdenTest_DomainDecomposition.xml',
+	'truth_kwargs': { 'full_cmdline': ['mpirun','-n','4','eden-mpi', 'nml', test_nml_dir + 'LEMS_EdenTest_DomainDecomposition.xml', 'mpi' ], 'threads':2, 'verbose': True },
+	'test_kwargs': { 'full_cmdline': ['mpirun','-n','4','eden-mpi', 'nml', test_nml_dir + 'LEMS_EdenTest_DomainDecomposition.xml', 'mpi', 'mpi_whole_network', 'mpi_partition', 'graph' ], 'threads':2, 'verbose': True },
+	'validation_criteria': 'exact'
+},
+{
+	# each rank keeps only the connections and inputs of its own cells by default
+	'type': 'eden_vs_eden',
+	'sim_file': test_nml_dir + 'LEMS_EdenTest_DomainDecomposition.xml',
+	'truth_kwargs': { 'full_cmdline': ['mpirun','-n','4','eden-mpi', 'nml', test_nml_dir + 'LEMS_EdenTest_DomainDecomposition.xml', 'mpi', 'mpi_whole_network' ], 'threads':2, 'verbose': True },
+	'test_kwargs': { 'full_cmdline': ['mpirun','-n','4','eden-mpi', 'nml', test_nml_dir + 'LEMS_EdenTest_DomainDecomposition.xml', 'mpi' ], 'threads':2, 'verbose': True },
+	'validation_criteria': 'exact'
+},
+{
+	'type': 'eden_vs_eden',
+	'sim_file': test_nml_dir + 'LEMS_EdenTest_DomainDecomposition.xml',
+	'truth_kwargs': { 'full_cmdline': ['mpirun','-n','4','eden-mpi', 'nml', test_nml_dir + 'LEMS_EdenTest_DomainDecomposition.xml', 'mpi' ], 'threads':2, 'verbose': True },
+	'test_kwargs': { 'full_cmdline': ['mpirun','-n','4','eden-mpi', 'nml', test_nml_dir + 'LEMS_EdenTest_DomainDecomposition.xml', 'mpi', 'mpi_exchange', 'neighbor' ], 'threads':2, 'verbose': True },
+	'validation_criteria': 'exact'
+},
+{
+	'type': 'eden_vs_eden',
+	'sim_file': test_nml_dir + 'LEMS_EdenTest_DomainDecomposition.xml',
+	'truth_kwargs': { 'full_cmdline': ['mpirun','-n','4','eden-mpi', 'nml', test_nml_dir + 'LEMS_EdenTest_DomainDecomposition.xml', 'mpi' ], 'threads':2, 'verbose': True },
+	'test_kwargs': { 'full_cmdline': ['mpirun','-n','4','eden-mpi', 'nml', test_nml_dir + 'LEMS_EdenTest_DomainDecomposition.xml', 'mpi', 'mpi_shared_tables' ], 'threads':2, 'verbose': True },
+	'validation_criteria': 'exact'
+},
+{
+	'type': 'eden_vs_eden',
+	'sim_file': test_nml_dir + 'LEMS_EdenTest_DomainDecomposition.xml',
+	'truth_kwargs': { 'full_cmdline': ['mpirun','-n','4','eden-mpi', 'nml', test_nml_dir + 'LEMS_EdenTest_DomainDecomposition.xml', 'mpi', 'mpi_output', 'gather' ], 'threads':2, 'verbose': True },
+	'test_kwargs': { 'full_cmdline': ['mpirun','-n','4','eden-mpi', 'nml', test_nml_dir + 'LEMS_EdenTest_DomainDecomposition.xml', 'mpi', 'mpi_output', 'shards' ], 'threads':2, 'verbose': True },
+	'validation_criteria': 'exact'
+},
+{
+	'type': 'eden_vs_eden',
+	'sim_file': test_nml_dir + 'LEMS_EdenTest_DomainDecomposition.xml',
+	'test_kwargs': { 'full_cmdline': ['eden', 'nml', test_nml_dir + 'LEMS_EdenTest_ConnectionTables.xml' ], 'verbose': True },
+	'validation_criteria': 'exact'
+},
+{
+	'type': 'eden_vs_eden',
+	'sim_file': test_nml_dir + 'LEMS_EdenTest_CoreSynapses.xml',
+	'test_kwargs': { 'full_cmdline': ['eden', 'nml', test_nml_dir + 'LEMS_EdenTest_CoreSynapses_Converted.xml' ], 'verbose': True },
+	'validation_criteria': 'exact'
+},
+{
+	'type': 'eden_vs_eden',
+	'sim_file': test_nml_dir + 'LEMS_EdenTest_LargeNetwork.xml',
+	'truth_kwargs': { 'extra_cmdline_args': ['nml_no_streaming'], 'verbose': True },
+	'test_kwargs': { 'verbose': True },
+	'validation_criteria': 'exact'
+},
+{
+	# cells split into work items are solved in a different order, so they only agree up to rounding
+	'type': 'eden_vs_eden',
+	'sim_file': test_nml_dir + 'LEMS_EdenTest_SplitCells.xml',
+	'truth_kwargs': { 'extra_cmdline_args': ['cable_solver', 'bwd_euler_hines'], 'threads':1, 'verbose': True },
+	'test_kwargs': { 'extra_cmdline_args': ['cable_solver', 'bwd_euler_hines', 'split_cells', '8'], 'threads':2, 'verbose': True },
+	'validation_criteria': {
+		'pop0/0/BranchedCell/0/v': { 'type': 'box', 'dt': 0.0, 'dv': 0.00001 },
+		'pop0/0/BranchedCell/20/v': { 'type': 'box', 'dt': 0.0, 'dv': 0.00001 },
+		'pop0/0/BranchedCell/40/v': { 'type': 'box', 'dt': 0.0, 'dv': 0.00001 },
+		'pop0/1/BranchedCell/0/v': { 'type': 'box', 'dt': 0.0, 'dv': 0.00001 },
+		'pop0/1/BranchedCell/30/v': { 'type': 'box', 'dt': 0.0, 'dv': 0.00001 },
+		'pop0/2/BranchedCell/0/v': { 'type': 'box', 'dt': 0.0, 'dv': 0.00001 },
+		'pop0/2/BranchedCell/20/v': { 'type': 'box', 'dt': 0.0, 'dv': 0.00001 },
+		'pop0/3/BranchedCell/0/v': { 'type': 'box', 'dt': 0.0, 'dv': 0.00001 },
+		'pop0/3/BranchedCell/52/v': { 'type': 'box', 'dt': 0.0, 'dv': 0.00001 },
+	},
+},
+{
+	'type': 'eden_vs_eden',
+	'sim_file': test_nml_dir + 'LEMS_EdenTest_SplitCells.xml',
+	'truth_kwargs': { 'extra_cmdline_args': ['cable_solver', 'crank_nicolson'], 'threads':1, 'verbose': True },
+	'test_kwargs': { 'extra_cmdline_args': ['cable_solver', 'crank_nicolson', 'split_cells', '8'], 'threads':2, 'verbose': True },
+	'validation_criteria': {
+		'pop0/0/BranchedCell/0/v': { 'type': 'box', 'dt': 0.0, 'dv': 0.00001 },
+		'pop0/0/BranchedCell/20/v': { 'type': 'box', 'dt': 0.0, 'dv': 0.00001 },
+		'pop0/0/BranchedCell/40/v': { 'type': 'box', 'dt': 0.0, 'dv': 0.00001 },
+		'pop0/1/BranchedCell/0/v': { 'type': 'box', 'dt': 0.0, 'dv': 0.00001 },
+		'pop0/1/BranchedCell/30/v': { 'type': 'box', 'dt': 0.0, 'dv': 0.00001 },
+		'pop0/2/BranchedCell/0/v': { 'type': 'box', 'dt': 0.0, 'dv': 0.00001 },
+		'pop0/2/BranchedCell/20/v': { 'type': 'box', 'dt': 0.0, 'dv': 0.00001 },
+		'pop0/3/BranchedCell/0/v': { 'type': 'box', 'dt': 0.0, 'dv': 0.00001 },
+		'pop0/3/BranchedCell/52/v': { 'type': 'box', 'dt': 0.0, 'dv': 0.00001 },
+	},
+},
+{
+	# cells solved together in lanes may also round differently, as the lanes are vectorized
+	'type': 'eden_vs_eden',
+	'sim_file': test_nml_dir + 'LEMS_EdenTest_SplitCells.xml',
+	'truth_kwargs': { 'extra_cmdline_args': ['cable_solver', 'bwd_euler_hines'], 'threads':1, 'verbose': True },
+	'test_kwargs': { 'extra_cmdline_args': ['cable_solver', 'bwd_euler_hines', 'hines_lanes', '4'], 'threads':2, 'verbose': True },
+	'validation_criteria': {
+		'pop0/0/BranchedCell/0/v': { 'type': 'box', 'dt': 0.0, 'dv': 0.00001 },
+		'pop0/0/BranchedCell/20/v': { 'type': 'box', 'dt': 0.0, 'dv': 0.00001 },
+		'pop0/0/BranchedCell/40/v': { 'type': 'box', 'dt': 0.0, 'dv': 0.00001 },
+		'pop0/1/BranchedCell/0/v': { 'type': 'box', 'dt': 0.0, 'dv': 0.00001 },
+		'pop0/1/BranchedCell/30/v': { 'type': 'box', 'dt': 0.0, 'dv': 0.00001 },
+		'pop0/2/BranchedCell/0/v': { 'type': 'box', 'dt': 0.0, 'dv': 0.00001 },
+		'pop0/2/BranchedCell/20/v': { 'type': 'box', 'dt': 0.0, 'dv': 0.00001 },
+		'pop0/3/BranchedCell/0/v': { 'type': 'box', 'dt': 0.0, 'dv': 0.00001 },
+		'pop0/3/BranchedCell/52/v': { 'type': 'box', 'dt': 0.0, 'dv': 0.00001 },
+	},
+},
+{
+	'type': 'eden_vs_eden',
+	'sim_file': test_nml_dir + 'LEMS_EdenTest_SplitCells.xml',
+	'truth_kwargs': { 'extra_cmdline_args': ['cable_solver', 'crank_nicolson'], 'threads':1, 'verbose': True },
+	'test_kwargs': { 'extra_cmdline_args': ['cable_solver', 'crank_nicolson', 'hines_lanes', '4'], 'threads':2, 'verbose': True },
+	'validation_criteria': {
+		'pop0/0/BranchedCell/0/v': { 'type': 'box', 'dt': 0.0, 'dv': 0.00001 },
+		'pop0/0/BranchedCell/20/v': { 'type': 'box', 'dt': 0.0, 'dv': 0.00001 },
+		'pop0/0/BranchedCell/40/v': { 'type': 'box', 'dt': 0.0, 'dv': 0.00001 },
+		'pop0/1/BranchedCell/0/v': { 'type': 'box', 'dt': 0.0, 'dv': 0.00001 },
+		'pop0/1/BranchedCell/30/v': { 'type': 'box', 'dt': 0.0, 'dv': 0.00001 },
+		'pop0/2/BranchedCell/0/v': { 'type': 'box', 'dt': 0.0, 'dv': 0.00001 },
+		'pop0/2/BranchedCell/20/v': { 'type': 'box', 'dt': 0.0, 'dv': 0.00001 },
+		'pop0/3/BranchedCell/0/v': { 'type': 'box', 'dt': 0.0, 'dv': 0.00001 },
+		'pop0/3/BranchedCell/52/v': { 'type': 'box', 'dt': 0.0, 'dv': 0.00001 },
+	},
+},
+{
+	# rates interpolated in tables only agree with the exact ones up to the table error
+	'type': 'eden_vs_eden',
+	'sim_file': test_nml_dir + 'LEMS_EdenTest_DomainDecomposition.xml',
+	'truth_kwargs': { 'verbose': True },
+	'test_kwargs': { 'extra_cmdline_args': ['rate_tables'], 'verbose': True },
+	'validation_criteria': {
+		'pop0/00/MultiCompCell/0/v': { 'type': 'box', 'dt': 0.0002, 'dv': 0.00005 },
+		'pop0/01/MultiCompCell/0/v': { 'type': 'box', 'dt': 0.0002, 'dv': 0.00005 },
+		'pop0/02/MultiCompCell/0/v': { 'type': 'box', 'dt': 0.0002, 'dv': 0.00005 },
+		'pop0/03/MultiCompCell/0/v': { 'type': 'box', 'dt': 0.0002, 'dv': 0.00005 },
+		'pop0/04/MultiCompCell/0/v': { 'type': 'box', 'dt': 0.0002, 'dv': 0.00005 },
+		'pop0/05/MultiCompCell/0/v': { 'type': 'box', 'dt': 0.0002, 'dv': 0.00005 },
+		'pop0/06/MultiCompCell/0/v': { 'type': 'box', 'dt': 0.0002, 'dv': 0.00005 },
+		'pop0/07/MultiCompCell/0/v': { 'type': 'box', 'dt': 0.0002, 'dv': 0.00005 },
+		'pop0/08/MultiCompCell/0/v': { 'type': 'box', 'dt': 0.0002, 'dv': 0.00005 },
+		'pop0/09/MultiCompCell/0/v': { 'type': 'box', 'dt': 0.0002, 'dv': 0.00005 },
+		'pop0/10/MultiCompCell/0/v': { 'type': 'box', 'dt': 0.0002, 'dv': 0.00005 },
+		'pop0/11/MultiCompCell/0/v': { 'type': 'box', 'dt': 0.0002, 'dv': 0.00005 },
+		'pop0/12/MultiCompCell/0/v': { 'type': 'box', 'dt': 0.0002, 'dv': 0.00005 },
+		'pop0/13/MultiCompCell/0/v': { 'type': 'box', 'dt': 0.0002, 'dv': 0.00005 },
+	},
+},
+{
+	# the two only agree up to the error of forward Euler, which is small at this step
+	'type': 'eden_vs_eden',
+	'sim_file': test_nml_dir + 'LEMS_EdenTest_CoreSynapses.xml',
+	'truth_kwargs': { 'extra_cmdline_args': ['gate_solver', 'fwd_euler'], 'verbose': True },
+	'test_kwargs': { 'extra_cmdline_args': ['gate_solver', 'exp_euler'], 'verbose': True },
+	'validation_criteria': {
+		'ChemPre/0/HHCell/0/v': { 'type': 'box', 'dt': 0.00005, 'dv': 0.0001 },
+		'ChemPost/01/PassiveCell/0/v': { 'type': 'box', 'dt': 0.00005, 'dv': 0.0001 },
+		'ChemPost/02/PassiveCell/0/v': { 'type': 'box', 'dt': 0.00005, 'dv': 0.0001 },
+		'ChemPost/03/PassiveCell/0/v': { 'type': 'box', 'dt': 0.00005, 'dv': 0.0001 },
+		'ChemPost/04/PassiveCell/0/v': { 'type': 'box', 'dt': 0.00005, 'dv': 0.0001 },
+		'ChemPost/05/PassiveCell/0/v': { 'type': 'box', 'dt': 0.00005, 'dv': 0.0001 },
+		'ChemPost/06/PassiveCell/0/v': { 'type': 'box', 'dt': 0.00005, 'dv': 0.0001 },
+		'ChemPost/07/PassiveCell/0/v': { 'type': 'box', 'dt': 0.00005, 'dv': 0.0001 },
+		'ChemPost/08/PassiveCell/0/v': { 'type': 'box', 'dt': 0.00005, 'dv': 0.0001 },
+		'ChemPost/09/PassiveCell/0/v': { 'type': 'box', 'dt': 0.00005, 'dv': 0.0001 },
+		'ChemPost/10/PassiveCell/0/v': { 'type': 'box', 'dt': 0.00005, 'dv': 0.0005 },
+		'ChemPost/21/PassiveCell/0/v': { 'type': 'box', 'dt': 0.00005, 'dv': 0.0001 },
+		'ContPre/01/PassiveCell/0/v': { 'type': 'box', 'dt': 0.00005, 'dv': 0.0001 },
+		'ContPre/02/PassiveCell/0/v': { 'type': 'box', 'dt': 0.00005, 'dv': 0.0001 },
+		'ContPre/03/PassiveCell/0/v': { 'type': 'box', 'dt': 0.00005, 'dv': 0.0001 },
+		'ContPost/02/PassiveCell/0/v': { 'type': 'box', 'dt': 0.00005, 'dv': 0.0001 },
+		'ContPost/03/PassiveCell/0/v': { 'type': 'box', 'dt': 0.00005, 'dv': 0.0001 },
+		'ContPost/04/PassiveCell/0/v': { 'type': 'box', 'dt': 0.00005, 'dv': 0.0001 },
+	},
+},
+{
+	# the higher-order integrators are checked against forward Euler with a ten times smaller step, which is closer to the exact solution
+	'type': 'eden_vs_eden',
+	'sim_file': test_nml_dir + 'LEMS_EdenTest_ArtificialCells.xml',
+	'truth_kwargs': { 'full_cmdline': ['eden', 'nml', test_nml_dir + 'LEMS_EdenTest_ArtificialCells_SmallStep.xml'], 'verbose': True },
+	'test_kwargs': { 'extra_cmdline_args': ['lems_integrator', 'heun'], 'verbose': True },
+	'validation_criteria': {
+		'Pop_iafTauCell[0]/v': { 'type': 'box', 'dt': 0.0002, 'dv': 0.0001 },
+		'Pop_iafTauRefCell[0]/v': { 'type': 'box', 'dt': 0.0002, 'dv': 0.0001 },
+		'Pop_iafCell[0]/v': { 'type': 'box', 'dt': 0.001, 'dv': 0.0001 },
+		'Pop_iafRefCell[0]/v': { 'type': 'box', 'dt': 0.001, 'dv': 0.0001 },
+		'Pop_izhikevich2007Cell[0]/v': { 'type': 'box', 'dt': 0.0002, 'dv': 0.001 },
+		'Pop_fitzHughNagumoCell[0]/V': { 'type': 'box', 'dt': 0.0002, 'dv': 0.0001 },
+		'Pop_fitzHughNagumo1969Cell[0]/V': { 'type': 'box', 'dt': 0.0002, 'dv': 0.001 },
+		'Pop_IF_curr_alpha[0]/v': { 'type': 'box', 'dt': 0.0002, 'dv': 0.0001 },
+		'Pop_IF_curr_exp[0]/v': { 'type': 'box', 'dt': 0.0002, 'dv': 0.0001 },
+		'Pop_IF_cond_alpha[0]/v': { 'type': 'box', 'dt': 0.0002, 'dv': 0.0001 },
+		'Pop_IF_cond_exp[0]/v': { 'type': 'box', 'dt': 0.0002, 'dv': 0.0001 },
+		'Pop_HH_cond_exp[0]/v': { 'type': 'box', 'dt': 0.0002, 'dv': 0.0005 },
+	},
+},
+{
+	'type': 'eden_vs_eden',
+	'sim_file': test_nml_dir + 'LEMS_EdenTest_ArtificialCells.xml',
+	'truth_kwargs': { 'full_cmdline': ['eden', 'nml', test_nml_dir + 'LEMS_EdenTest_ArtificialCells_SmallStep.xml'], 'verbose': True },
+	'test_kwargs': { 'extra_cmdline_args': ['lems_integrator', 'rk4'], 'verbose': True },
+	'validation_criteria': {
+		'Pop_iafTauCell[0]/v': { 'type': 'box', 'dt': 0.0002, 'dv': 0.0001 },
+		'Pop_iafTauRefCell[0]/v': { 'type': 'box', 'dt': 0.0002, 'dv': 0.0001 },
+		'Pop_iafCell[0]/v': { 'type': 'box', 'dt': 0.001, 'dv': 0.0001 },
+		'Pop_iafRefCell[0]/v': { 'type': 'box', 'dt': 0.001, 'dv': 0.0001 },
+		'Pop_izhikevich2007Cell[0]/v': { 'type': 'box', 'dt': 0.0002, 'dv': 0.001 },
+		'Pop_fitzHughNagumoCell[0]/V': { 'type': 'box', 'dt': 0.0002, 'dv': 0.0001 },
+		'Pop_fitzHughNagumo1969Cell[0]/V': { 'type': 'box', 'dt': 0.0002, 'dv': 0.001 },
+		'Pop_IF_curr_alpha[0]/v': { 'type': 'box', 'dt': 0.0002, 'dv': 0.0001 },
+		'Pop_IF_curr_exp[0]/v': { 'type': 'box', 'dt': 0.0002, 'dv': 0.0001 },
+		'Pop_IF_cond_alpha[0]/v': { 'type': 'box', 'dt': 0.0002, 'dv': 0.0001 },
+		'Pop_IF_cond_exp[0]/v': { 'type': 'box', 'dt': 0.0002, 'dv': 0.0001 },
+		'Pop_HH_cond_exp[0]/v': { 'type': 'box', 'dt': 0.0002, 'dv': 0.0005 },
+	},
+},
+{
+	# semi-implicit Euler is first-order too, so it is checked against forward Euler at the same step
+	'type': 'eden_vs_eden',
+	'sim_file': test_nml_dir + 'LEMS_EdenTest_ArtificialCells.xml',
+	'truth_kwargs': { 'extra_cmdline_args': ['lems_integrator', 'euler'], 'verbose': True },
+	'test_kwargs': { 'extra_cmdline_args': ['lems_integrator', 'semi_implicit'], 'verbose': True },
+	'validation_criteria': {
+		'Pop_iafTauCell[0]/v': { 'type': 'box', 'dt': 0.0005, 'dv': 0.0001 },
+		'Pop_iafTauRefCell[0]/v': { 'type': 'box', 'dt': 0.0005, 'dv': 0.0001 },
+		'Pop_iafCell[0]/v': { 'type': 'box', 'dt': 0.0005, 'dv': 0.0001 },
+		'Pop_iafRefCell[0]/v': { 'type': 'box', 'dt': 0.0005, 'dv': 0.0001 },
+		'Pop_izhikevich2007Cell[0]/v': { 'type': 'box', 'dt': 0.0005, 'dv': 0.0001 },
+		'Pop_fitzHughNagumoCell[0]/V': { 'type': 'box', 'dt': 0.0005, 'dv': 0.0001 },
+		'Pop_fitzHughNagumo1969Cell[0]/V': { 'type': 'box', 'dt': 0.0005, 'dv': 0.0001 },
+		'Pop_IF_curr_alpha[0]/v': { 'type': 'box', 'dt': 0.0005, 'dv': 0.0001 },
+		'Pop_IF_curr_exp[0]/v': { 'type': 'box', 'dt': 0.0005, 'dv': 0.0001 },
+		'Pop_IF_cond_alpha[0]/v': { 'type': 'box', 'dt': 0.0005, 'dv': 0.0001 },
+		'Pop_IF_cond_exp[0]/v': { 'type': 'box', 'dt': 0.0005, 'dv': 0.0001 },
+		'Pop_HH_cond_exp[0]/v': { 'type': 'box', 'dt': 0.0005, 'dv': 0.0001 },
+	},
+},
+{
+	# the network is sensitive enough for rounding differences to shift spikes a little
+	'type': 'eden_vs_eden',
+	'sim_file': test_nml_dir + 'LEMS_EdenTest_DomainDecomposition.xml',
+	'truth_kwargs': { 'extra_cmdline_args': ['cable_solver', 'bwd_euler'], 'verbose': True },
+	'test_kwargs': { 'extra_cmdline_args': ['cable_solver', 'bwd_euler_hines'], 'verbose': True },
+	'validation_criteria': {
+		'pop0/00/MultiCompCell/0/v': { 'type': 'box', 'dt': 0.0005, 'dv': 0.0005 },
+		'pop0/01/MultiCompCell/0/v': { 'type': 'box', 'dt': 0.0005, 'dv': 0.0005 },
+		'pop0/02/MultiCompCell/0/v': { 'type': 'box', 'dt': 0.0005, 'dv': 0.0005 },
+		'pop0/03/MultiCompCell/0/v': { 'type': 'box', 'dt': 0.0005, 'dv': 0.0005 },
+		'pop0/04/MultiCompCell/0/v': { 'type': 'box', 'dt': 0.0005, 'dv': 0.0005 },
+		'pop0/05/MultiCompCell/0/v': { 'type': 'box', 'dt': 0.0005, 'dv': 0.0005 },
+		'pop0/06/MultiCompCell/0/v': { 'type': 'box', 'dt': 0.0005, 'dv': 0.0005 },
+		'pop0/07/MultiCompCell/0/v': { 'type': 'box', 'dt': 0.0005, 'dv': 0.0005 },
+		'pop0/08/MultiCompCell/0/v': { 'type': 'box', 'dt': 0.0005, 'dv': 0.0005 },
+		'pop0/09/MultiCompCell/0/v': { 'type': 'box', 'dt': 0.0005, 'dv': 0.0005 },
+		'pop0/10/MultiCompCell/0/v': { 'type': 'box', 'dt': 0.0005, 'dv': 0.0005 },
+		'pop0/11/MultiCompCell/0/v': { 'type': 'box', 'dt': 0.0005, 'dv': 0.0005 },
+		'pop0/12/MultiCompCell/0/v': { 'type': 'box', 'dt': 0.0005, 'dv': 0.0005 },
+		'pop0/13/MultiCompCell/0/v': { 'type': 'box', 'dt': 0.0005, 'dv': 0.0005 },
+	},
+},
+{
+	'type': 'eden_vs_eden',
+	'sim_file': test_nml_dir + 'LEMS_EdenTest_DomainDecomposition.xml',
+	'truth_kwargs': { 'extra_cmdline_args': ['cable_solver', 'bwd_euler'], 'verbose': True },
+	'test_kwargs': { 'extra_cmdline_args': ['cable_solver', 'crank_nicolson'], 'verbose': True },
+	'validation_criteria': {
+		'pop0/00/MultiCompCell/0/v': { 'type': 'box', 'dt': 0.0005, 'dv': 0.0005 },
+		'pop0/01/MultiCompCell/0/v': { 'type': 'box', 'dt': 0.0005, 'dv': 0.0005 },
+		'pop0/02/MultiCompCell/0/v': { 'type': 'box', 'dt': 0.0005, 'dv': 0.0005 },
+		'pop0/03/MultiCompCell/0/v': { 'type': 'box', 'dt': 0.0005, 'dv': 0.0005 },
+		'pop0/04/MultiCompCell/0/v': { 'type': 'box', 'dt': 0.0005, 'dv': 0.0005 },
+		'pop0/05/MultiCompCell/0/v': { 'type': 'box', 'dt': 0.0005, 'dv': 0.0005 },
+		'pop0/06/MultiCompCell/0/v': { 'type': 'box', 'dt': 0.0005, 'dv': 0.0005 },
+		'pop0/07/MultiCompCell/0/v': { 'type': 'box', 'dt': 0.0005, 'dv': 0.0005 },
+		'pop0/08/MultiCompCell/0/v': { 'type': 'box', 'dt': 0.0005, 'dv': 0.0005 },
+		'pop0/09/MultiCompCell/0/v': { 'type': 'box', 'dt': 0.0005, 'dv': 0.0005 },
+		'pop0/10/MultiCompCell/0/v': { 'type': 'box', 'dt': 0.0005, 'dv': 0.0005 },
+		'pop0/11/MultiCompCell/0/v': { 'type': 'box', 'dt': 0.0005, 'dv': 0.0005 },
+		'pop0/12/MultiCompCell/0/v': { 'type': 'box', 'dt': 0.0005, 'dv': 0.0005 },
+		'pop0/13/MultiCompCell/0/v': { 'type': 'box', 'dt': 0.0005, 'dv': 0.0005 },
+	},
+},
 
 ]
 res = RunTests(tests, verbose = True)